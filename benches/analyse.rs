@@ -0,0 +1,171 @@
+// the time to analyse the tracked frames: building the dependency graph and searching
+// schedules; run with `cargo xtask bench analyse`
+
+#[macro_use]
+mod common;
+
+use common::{
+    BitVec,
+    Circuit,
+};
+use criterion::{
+    black_box,
+    criterion_group,
+    BatchSize,
+    BenchmarkId,
+    Criterion,
+};
+use pauli_tracker::{
+    analyse::{
+        self,
+        schedule::{
+            heuristic::{
+                Heuristic,
+                Objective,
+            },
+            memo::TranspositionTable,
+            space::Graph,
+            time::{
+                LookupBuffer,
+                PathGenerator,
+            },
+            Scheduler,
+        },
+        DependencyGraph,
+    },
+    tracker::frames::storage::{
+        MappedVector,
+        StackStorage,
+    },
+};
+
+type Storage = MappedVector<BitVec>;
+
+fn dependency_graph(circuit: &Circuit) -> DependencyGraph {
+    let storage = common::track::<Storage>(circuit, true);
+    analyse::create_dependency_graph(storage.iter(), &circuit.frame_map)
+}
+
+fn dependency_graphs(c: &mut Criterion) {
+    let mut group = c.benchmark_group("dependency_graph");
+    group.sample_size(20);
+    for circuit in [common::teleportation(16, 64), common::brickwork(16, 64)] {
+        let storage = common::track::<Storage>(&circuit, true);
+        group.bench_with_input(
+            BenchmarkId::new("create", circuit.name),
+            &storage,
+            |bencher, storage| {
+                bencher.iter(|| {
+                    analyse::create_dependency_graph(
+                        black_box(storage).iter(),
+                        &circuit.frame_map,
+                    )
+                })
+            },
+        );
+        group.bench_with_input(
+            BenchmarkId::new("try_create", circuit.name),
+            &storage,
+            |bencher, storage| {
+                bencher.iter(|| {
+                    analyse::try_create_dependency_graph(
+                        black_box(storage).iter(),
+                        &circuit.frame_map,
+                    )
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+fn exact_schedulers(c: &mut Criterion) {
+    let mut group = c.benchmark_group("scheduler");
+    group.sample_size(10);
+    let circuit = common::teleportation(2, 4);
+    let graph = dependency_graph(&circuit);
+    let num_bits = circuit.num_qubits;
+    let mut look = LookupBuffer::new(num_bits);
+    let scheduler = Scheduler::new(
+        PathGenerator::from_dependency_graph(graph, &mut look, None),
+        Graph::new(num_bits, &circuit.edges, None),
+    );
+
+    group.bench_function(BenchmarkId::new("pareto_front", circuit.name), |bencher| {
+        bencher.iter_batched(
+            || scheduler.clone(),
+            |scheduler| scheduler.pareto_front(),
+            BatchSize::SmallInput,
+        )
+    });
+    group.bench_function(
+        BenchmarkId::new("bounded_pareto_front", circuit.name),
+        |bencher| {
+            bencher.iter_batched(
+                || scheduler.clone(),
+                |scheduler| scheduler.bounded_pareto_front(),
+                BatchSize::SmallInput,
+            )
+        },
+    );
+    group.bench_function(
+        BenchmarkId::new("memoized_pareto_front", circuit.name),
+        |bencher| {
+            bencher.iter_batched(
+                || (scheduler.clone(), TranspositionTable::new(1 << 16)),
+                |(scheduler, mut table)| scheduler.memoized_pareto_front(&mut table),
+                BatchSize::SmallInput,
+            )
+        },
+    );
+    group.finish();
+}
+
+fn heuristic_schedulers(c: &mut Criterion) {
+    let mut group = c.benchmark_group("heuristic");
+    group.sample_size(10);
+    for circuit in [common::teleportation(16, 64), common::brickwork(16, 64)] {
+        let heuristic = Heuristic::new(
+            dependency_graph(&circuit),
+            circuit.num_qubits,
+            &circuit.edges,
+            None,
+        );
+        for width in [1, 8] {
+            group.bench_with_input(
+                BenchmarkId::new(format!("beam_search_{width}"), circuit.name),
+                &heuristic,
+                |bencher, heuristic| {
+                    bencher.iter(|| heuristic.beam_search(width, Objective::default()))
+                },
+            );
+        }
+    }
+    group.finish();
+}
+
+fn memory() {
+    for circuit in [common::teleportation(16, 64), common::brickwork(16, 64)] {
+        let storage = common::track::<Storage>(&circuit, true);
+        let peak = common::peak_heap(|| {
+            analyse::create_dependency_graph(storage.iter(), &circuit.frame_map)
+        });
+        common::print_peak_heap(&format!("dependency_graph/{}", circuit.name), peak);
+        let peak = common::peak_heap(|| {
+            analyse::try_create_dependency_graph(storage.iter(), &circuit.frame_map)
+        });
+        common::print_peak_heap(
+            &format!("try_dependency_graph/{}", circuit.name),
+            peak,
+        );
+    }
+    common::print_peak_rss();
+}
+
+criterion_group!(benches, dependency_graphs, exact_schedulers, heuristic_schedulers);
+
+fn main() {
+    benches();
+    Criterion::default().configure_from_args().final_summary();
+    memory();
+}
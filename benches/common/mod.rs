@@ -0,0 +1,312 @@
+// shared circuit generators and helpers for the benchmark suites; not every suite uses
+// everything
+#![allow(dead_code)]
+
+use std::{
+    alloc::{
+        GlobalAlloc,
+        Layout,
+        System,
+    },
+    fs,
+    sync::atomic::{
+        AtomicUsize,
+        Ordering,
+    },
+};
+
+use pauli_tracker::tracker::{
+    frames::{
+        storage::StackStorage,
+        Frames,
+    },
+    Tracker,
+};
+
+pub type BitVec = bitvec::vec::BitVec;
+pub type BitVecOld = bit_vec::BitVec;
+pub type SimdBitVec = pauli_tracker::boolean_vector::bitvec_simd::SimdBitVec;
+pub type PackedBitVec = pauli_tracker::boolean_vector::packed::PackedBitVec;
+
+#[derive(Clone, Copy, Debug)]
+pub enum Operation {
+    H(usize),
+    S(usize),
+    Cx(usize, usize),
+    Cz(usize, usize),
+    MoveZToZ(usize, usize),
+    TrackZ(usize),
+    Measure(usize),
+}
+
+/// A precomputed circuit, so that the generation is not part of the measurements.
+#[derive(Clone, Debug)]
+pub struct Circuit {
+    pub name: &'static str,
+    pub num_qubits: usize,
+    pub operations: Vec<Operation>,
+    /// The number of Clifford gates (including the moves).
+    pub num_gates: usize,
+    /// The number of tracked frames.
+    pub num_frames: usize,
+    /// `frame_map[i]` is the qubit whose measurement caused the i-th frame, cf.
+    /// [create_dependency_graph](pauli_tracker::analyse::create_dependency_graph).
+    pub frame_map: Vec<usize>,
+    /// The pairs of qubits that are connected by two-qubit gates, i.e., the edges of
+    /// the graph state.
+    pub edges: Vec<(usize, usize)>,
+}
+
+impl Circuit {
+    fn new(name: &'static str, num_qubits: usize) -> Self {
+        Self {
+            name,
+            num_qubits,
+            operations: Vec::new(),
+            num_gates: 0,
+            num_frames: 0,
+            frame_map: Vec::new(),
+            edges: Vec::new(),
+        }
+    }
+
+    fn push(&mut self, operation: Operation) {
+        match operation {
+            Operation::Cx(a, b) | Operation::Cz(a, b) => {
+                self.num_gates += 1;
+                self.edges.push((a, b));
+            }
+            Operation::H(_) | Operation::S(_) | Operation::MoveZToZ(..) => {
+                self.num_gates += 1
+            }
+            Operation::TrackZ(_) => self.num_frames += 1,
+            Operation::Measure(_) => {}
+        }
+        self.operations.push(operation);
+    }
+
+    // measure `origin` and track the correction on `new`
+    fn measure_and_correct(&mut self, origin: usize, new: usize) {
+        self.push(Operation::Measure(origin));
+        self.push(Operation::TrackZ(new));
+        self.frame_map.push(origin);
+    }
+}
+
+/// `width` logical qubits, each teleported `depth` times through T-gate teleportations
+/// as in the `another_graph_test` in circuit.rs, with entangling CNOTs between the
+/// neighboring logical qubits after each layer.
+pub fn teleportation(width: usize, depth: usize) -> Circuit {
+    let mut circuit = Circuit::new("teleportation", width * (depth + 1));
+    let qubit = |layer: usize, logical: usize| layer * width + logical;
+    for layer in 0..depth {
+        for logical in 0..width {
+            let (origin, new) = (qubit(layer, logical), qubit(layer + 1, logical));
+            circuit.push(Operation::Cx(origin, new));
+            circuit.push(Operation::MoveZToZ(origin, new));
+            circuit.measure_and_correct(origin, new);
+        }
+        for logical in 1..width {
+            let (control, target) =
+                (qubit(layer + 1, logical - 1), qubit(layer + 1, logical));
+            if (layer + logical) % 2 == 0 {
+                circuit.push(Operation::H(control));
+            }
+            circuit.push(Operation::Cx(control, target));
+        }
+    }
+    circuit
+}
+
+/// A brickwork graph state with `rows` × `columns` qubits, which is measured column by
+/// column; the edges are created lazily, just before they are needed.
+pub fn brickwork(rows: usize, columns: usize) -> Circuit {
+    let mut circuit = Circuit::new("brickwork", rows * columns);
+    let qubit = |row: usize, column: usize| row * columns + column;
+    let vertical = |row: usize, column: usize| {
+        row + 1 < rows
+            && match column % 8 {
+                2 | 4 => row % 2 == 0,
+                6 | 0 => row % 2 == 1 && column > 0,
+                _ => false,
+            }
+    };
+    for column in 0..columns - 1 {
+        for row in 0..rows {
+            circuit.push(Operation::Cz(qubit(row, column), qubit(row, column + 1)));
+            if vertical(row, column + 1) {
+                circuit.push(Operation::Cz(
+                    qubit(row, column + 1),
+                    qubit(row + 1, column + 1),
+                ));
+            }
+        }
+        for row in 0..rows {
+            circuit.measure_and_correct(qubit(row, column), qubit(row, column + 1));
+            circuit.push(Operation::H(qubit(row, column + 1)));
+        }
+    }
+    circuit
+}
+
+/// `layers` layers of random single-qubit Cliffords followed by random two-qubit
+/// Cliffords on disjoint pairs, with one new frame per layer.
+pub fn random_clifford(num_qubits: usize, layers: usize, seed: u64) -> Circuit {
+    let mut circuit = Circuit::new("random_clifford", num_qubits);
+    let mut rng = XorShift(seed | 1);
+    let mut qubits: Vec<usize> = (0..num_qubits).collect();
+    for _ in 0..layers {
+        let tracked = rng.below(num_qubits);
+        circuit.push(Operation::TrackZ(tracked));
+        circuit.frame_map.push(tracked);
+        for bit in 0..num_qubits {
+            match rng.below(3) {
+                0 => circuit.push(Operation::H(bit)),
+                1 => circuit.push(Operation::S(bit)),
+                _ => {}
+            }
+        }
+        // Fisher-Yates
+        for i in (1..num_qubits).rev() {
+            qubits.swap(i, rng.below(i + 1));
+        }
+        for pair in qubits.chunks_exact(2) {
+            if rng.below(2) == 0 {
+                circuit.push(Operation::Cx(pair[0], pair[1]));
+            } else {
+                circuit.push(Operation::Cz(pair[0], pair[1]));
+            }
+        }
+    }
+    circuit
+}
+
+/// A small deterministic random number generator, so that the circuits are the same in
+/// each run.
+pub struct XorShift(pub u64);
+
+impl XorShift {
+    pub fn next_u64(&mut self) -> u64 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        self.0
+    }
+
+    pub fn below(&mut self, bound: usize) -> usize {
+        (self.next_u64() % bound as u64) as usize
+    }
+}
+
+/// Track the `circuit` with the [Frames] tracker and return the storage with all
+/// stacks. If `measure` is false, the measurements are skipped and all qubits are only
+/// moved into the storage at the end (needed for
+/// [Vector](pauli_tracker::tracker::frames::storage::Vector)).
+pub fn track<S: StackStorage>(circuit: &Circuit, measure: bool) -> S {
+    let mut tracker = Frames::<S>::init(circuit.num_qubits);
+    let mut storage = S::init(0);
+    for operation in circuit.operations.iter() {
+        match *operation {
+            Operation::H(bit) => tracker.h(bit),
+            Operation::S(bit) => tracker.s(bit),
+            Operation::Cx(control, target) => tracker.cx(control, target),
+            Operation::Cz(a, b) => tracker.cz(a, b),
+            Operation::MoveZToZ(source, destination) => {
+                tracker.move_z_to_z(source, destination)
+            }
+            Operation::TrackZ(bit) => tracker.track_z(bit),
+            Operation::Measure(bit) => {
+                if measure {
+                    tracker
+                        .measure_and_store(bit, &mut storage)
+                        .expect("the circuits measure each qubit only once");
+                }
+            }
+        }
+    }
+    tracker.measure_and_store_all(&mut storage);
+    storage
+}
+
+/// Call the generic `$function` for all storages and boolean vectors, with the storage
+/// type as type parameter, followed by a label, whether the storage supports
+/// measurements in between, and the `$arg`s.
+#[allow(unused_macros)]
+macro_rules! for_all_storages {
+    ($function:ident($($arg:expr),*)) => {
+        for_all_storages!(@backends $function, Vector, false, $($arg),*);
+        for_all_storages!(@backends $function, Map, true, $($arg),*);
+        for_all_storages!(@backends $function, MappedVector, true, $($arg),*);
+        for_all_storages!(@backends $function, Slab, true, $($arg),*);
+    };
+    (@backends $function:ident, $storage:ident, $measure:literal, $($arg:expr),*) => {
+        for_all_storages!(@call $function, $storage, Vec<bool>, "Vec<bool>", $measure, $($arg),*);
+        for_all_storages!(@call $function, $storage, BitVec, "bitvec", $measure, $($arg),*);
+        for_all_storages!(@call $function, $storage, BitVecOld, "bit-vec", $measure, $($arg),*);
+        for_all_storages!(@call $function, $storage, SimdBitVec, "bitvec_simd", $measure, $($arg),*);
+        for_all_storages!(@call $function, $storage, PackedBitVec, "packed", $measure, $($arg),*);
+    };
+    (@call $function:ident, $storage:ident, $bool:ty, $name:literal, $measure:literal, $($arg:expr),*) => {
+        $function::<$storage<$bool>>(
+            concat!(stringify!($storage), "<", $name, ">"),
+            $measure,
+            $($arg),*
+        )
+    };
+}
+
+// counts the allocated bytes, so that we can measure the peak memory of single cases
+// (the resident set size doesn't shrink when memory is freed, so it's only meaningful
+// for the whole process)
+struct CountingAllocator;
+
+static ALLOCATED: AtomicUsize = AtomicUsize::new(0);
+static PEAK: AtomicUsize = AtomicUsize::new(0);
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        let ptr = System.alloc(layout);
+        if !ptr.is_null() {
+            let current = ALLOCATED.fetch_add(layout.size(), Ordering::Relaxed);
+            PEAK.fetch_max(current + layout.size(), Ordering::Relaxed);
+        }
+        ptr
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout);
+        ALLOCATED.fetch_sub(layout.size(), Ordering::Relaxed);
+    }
+}
+
+#[global_allocator]
+static GLOBAL: CountingAllocator = CountingAllocator;
+
+/// The peak number of heap bytes that are allocated while running `f`, on top of what
+/// is already allocated before.
+pub fn peak_heap<R>(f: impl FnOnce() -> R) -> usize {
+    let start = ALLOCATED.load(Ordering::Relaxed);
+    PEAK.store(start, Ordering::Relaxed);
+    let result = f();
+    let peak = PEAK.load(Ordering::Relaxed);
+    drop(result);
+    peak - start
+}
+
+pub fn print_peak_heap(label: &str, bytes: usize) {
+    println!("peak heap {label:<60} {:>10} KiB", bytes / 1024);
+}
+
+/// The peak resident set size of this process in KiB (only supported on Linux).
+pub fn peak_rss() -> Option<usize> {
+    let status = fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find(|line| line.starts_with("VmHWM:"))?;
+    line.split_whitespace().nth(1)?.parse().ok()
+}
+
+pub fn print_peak_rss() {
+    match peak_rss() {
+        Some(peak) => println!("peak RSS of the process: {peak} KiB"),
+        None => println!("peak RSS of the process: n/a"),
+    }
+}
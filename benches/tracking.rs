@@ -0,0 +1,92 @@
+// gates/sec and frames/sec of the Frames tracker for all storages and boolean vectors,
+// and the peak heap memory of each case; run with `cargo xtask bench tracking`
+
+#[macro_use]
+mod common;
+
+use common::{
+    BitVec,
+    BitVecOld,
+    Circuit,
+    PackedBitVec,
+    SimdBitVec,
+};
+use criterion::{
+    black_box,
+    criterion_group,
+    measurement::WallTime,
+    BenchmarkGroup,
+    BenchmarkId,
+    Criterion,
+    Throughput,
+};
+use pauli_tracker::tracker::frames::storage::{
+    Map,
+    MappedVector,
+    Slab,
+    StackStorage,
+    Vector,
+};
+
+fn circuits() -> Vec<Circuit> {
+    vec![
+        common::teleportation(16, 64),
+        common::brickwork(16, 64),
+        common::random_clifford(64, 256, 42),
+    ]
+}
+
+fn track_case<S: StackStorage>(
+    storage: &str,
+    measure: bool,
+    group: &mut BenchmarkGroup<WallTime>,
+    circuit: &Circuit,
+) {
+    group.bench_with_input(
+        BenchmarkId::new(circuit.name, storage),
+        circuit,
+        |bencher, circuit| {
+            bencher.iter(|| common::track::<S>(black_box(circuit), measure))
+        },
+    );
+}
+
+fn gates(c: &mut Criterion) {
+    let mut group = c.benchmark_group("gates");
+    group.sample_size(20);
+    for circuit in circuits() {
+        group.throughput(Throughput::Elements(circuit.num_gates as u64));
+        for_all_storages!(track_case(&mut group, &circuit));
+    }
+    group.finish();
+}
+
+fn frames(c: &mut Criterion) {
+    let mut group = c.benchmark_group("frames");
+    group.sample_size(20);
+    // many frames on few qubits, so that pushing the frames dominates
+    let circuit = common::random_clifford(16, 4096, 7);
+    group.throughput(Throughput::Elements(circuit.num_frames as u64));
+    for_all_storages!(track_case(&mut group, &circuit));
+    group.finish();
+}
+
+fn memory_case<S: StackStorage>(storage: &str, measure: bool, circuit: &Circuit) {
+    let peak = common::peak_heap(|| common::track::<S>(circuit, measure));
+    common::print_peak_heap(&format!("{}/{storage}", circuit.name), peak);
+}
+
+fn memory() {
+    for circuit in circuits() {
+        for_all_storages!(memory_case(&circuit));
+    }
+    common::print_peak_rss();
+}
+
+criterion_group!(benches, gates, frames);
+
+fn main() {
+    benches();
+    Criterion::default().configure_from_args().final_summary();
+    memory();
+}
@@ -10,8 +10,20 @@ pub mod schedule;
 #[allow(unused)]
 pub(crate) mod combinatoric;
 
+use std::{
+    collections::HashSet,
+    error::Error,
+    fmt::Display,
+    iter,
+    mem,
+};
+
 use crate::{
-    boolean_vector::BooleanVector,
+    boolean_vector::{
+        packed::PackedBitVec,
+        BooleanVector,
+    },
+    collection::IntMap,
     pauli::PauliVec,
 };
 
@@ -34,6 +46,9 @@ pub type DependencyGraph = Vec<Vec<(usize, Vec<usize>)>>;
 /// implementation, the output might not be sorted as expected, since nodes are swapped
 /// around for better efficiency.
 ///
+/// For large graphs, prefer [try_create_dependency_graph], which scales much better and
+/// returns errors instead of panicking.
+///
 /// # Panics
 /// May panic if `map`.len() < number of frames in storage (out of bounds).
 ///
@@ -76,6 +91,7 @@ where
     BoolVec: BooleanVector + 'l,
     Storage: IntoIterator<Item = (usize, &'l PauliVec<BoolVec>)>,
 {
+    metric!(time(DependencyGraph));
     let mut graph: Vec<Vec<(usize, Vec<usize>)>> = vec![Vec::new()];
     let mut remaining: Vec<(usize, Vec<usize>, Vec<usize>)> = Vec::new();
 
@@ -150,6 +166,407 @@ where
     graph
 }
 
+/// The error when the dependencies passed to [try_create_dependency_graph] or
+/// [IncrementalDependencyGraph::insert] cannot be resolved.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum GraphError {
+    /// The stack of `bit` has a non-zero element in `frame`, but `map` has no entry for
+    /// that frame.
+    MissingFrame {
+        /// The qubit whose stack refers to the frame.
+        bit: usize,
+        /// The frame that is not in the map.
+        frame: usize,
+    },
+    /// The qubit `bit` depends on the qubit `dependency`, which has no stack.
+    UnknownDependency {
+        /// The dependent qubit.
+        bit: usize,
+        /// The missing qubit.
+        dependency: usize,
+    },
+    /// The dependencies of the qubits `bits` are cyclic.
+    Cyclic {
+        /// The qubits that could not be sorted into a layer.
+        bits: Vec<usize>,
+    },
+    /// The qu`bit` is already in the [IncrementalDependencyGraph].
+    Duplicate {
+        /// The qubit that has been inserted twice.
+        bit: usize,
+    },
+}
+
+impl Display for GraphError {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            GraphError::MissingFrame { bit, frame } => {
+                write!(f, "qubit {bit} depends on frame {frame}, which is not mapped")
+            }
+            GraphError::UnknownDependency { bit, dependency } => {
+                write!(f, "qubit {bit} depends on the unknown qubit {dependency}")
+            }
+            GraphError::Cyclic { bits } => {
+                write!(f, "the dependencies of the qubits {bits:?} are cyclic")
+            }
+            GraphError::Duplicate { bit } => {
+                write!(f, "qubit {bit} is already in the graph")
+            }
+        }
+    }
+}
+
+impl Error for GraphError {}
+
+/// Sort the `storage` according to the induced dependencies by the frames, like
+/// [create_dependency_graph], but return an error instead of panicking, and remove
+/// *all* redundant dependencies.
+///
+/// The layers are build with indegree counters (Kahn's algorithm), i.e., every
+/// dependency is touched only once, instead of searching through all remaining qubits
+/// for each new layer. For the transitive reduction, we collect, in topological order,
+/// the transitive dependencies of each qubit in a [PackedBitVec], so that they can be
+/// combined word-wise via [or_inplace](BooleanVector::or_inplace); a dependency is
+/// redundant if it is a transitive dependency of another dependency. A bitset is
+/// dropped as soon as all dependent qubits are sorted, so the memory usage is bounded
+/// by the "width" of the graph times the number of qubits.
+///
+/// In contrast to [create_dependency_graph], where only dependencies covered by a
+/// direct dependency of a later dependency are removed, the dependencies here are a
+/// proper transitive reduction. For example, if 0 depends on 1 and 3, 1 depends on 2
+/// and 2 depends on 3, then 3 is not listed in the dependencies of 0.
+///
+/// The qubits in each layer and the dependencies of each qubit are ordered as in the
+/// iteration of `storage`. If `storage` is empty, the graph is empty.
+///
+/// # Errors
+/// Returns a [GraphError] if a frame is not in `map`, if a qubit depends on a qubit
+/// without a stack, or if the dependencies are cyclic.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// # use pauli_tracker::analyse::{try_create_dependency_graph, GraphError};
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::frames::storage::{
+///         StackStorage,
+///         Vector,
+///     },
+/// };
+/// let storage = Vector {
+///     frames: vec![
+///         PauliVec::<Vec<bool>>::try_from_str("", "").unwrap(),
+///         PauliVec::<Vec<bool>>::try_from_str("10", "00").unwrap(),
+///         PauliVec::<Vec<bool>>::try_from_str("01", "10").unwrap(),
+///         PauliVec::<Vec<bool>>::try_from_str("1", "0").unwrap(),
+///     ],
+/// };
+/// assert_eq!(
+///     try_create_dependency_graph(storage.iter(), &[0, 3]),
+///     Ok(vec![
+///         vec![(0, vec![])],
+///         vec![(1, vec![0]), (3, vec![0])],
+///         vec![(2, vec![3])],
+///     ])
+/// );
+/// assert_eq!(
+///     try_create_dependency_graph(storage.iter(), &[0]),
+///     Err(GraphError::MissingFrame { bit: 2, frame: 1 })
+/// );
+/// # }
+/// ```
+pub fn try_create_dependency_graph<'l, BoolVec, Storage>(
+    storage: Storage,
+    map: &[usize],
+) -> Result<DependencyGraph, GraphError>
+where
+    BoolVec: BooleanVector + 'l,
+    Storage: IntoIterator<Item = (usize, &'l PauliVec<BoolVec>)>,
+{
+    metric!(time(DependencyGraph));
+    // the qubits are internally replaced by their position in the storage iteration
+
+    let mut bits = Vec::new();
+    let mut deps = Vec::new();
+    for (bit, stack) in storage {
+        let mut bit_deps = Vec::new();
+        for frame in non_zero_frames(stack) {
+            bit_deps
+                .push(*map.get(frame).ok_or(GraphError::MissingFrame { bit, frame })?);
+        }
+        bits.push(bit);
+        deps.push(bit_deps);
+    }
+    let num = bits.len();
+
+    let position: IntMap<usize, usize> =
+        bits.iter().enumerate().map(|(node, bit)| (*bit, node)).collect();
+    let mut dependents = vec![Vec::new(); num];
+    for (node, bit_deps) in deps.iter_mut().enumerate() {
+        for dep in bit_deps.iter_mut() {
+            *dep = *position.get(dep).ok_or(GraphError::UnknownDependency {
+                bit: bits[node],
+                dependency: *dep,
+            })?;
+        }
+        // different frames may map to the same qubit
+        bit_deps.sort_unstable();
+        bit_deps.dedup();
+        for dep in bit_deps.iter() {
+            dependents[*dep].push(node);
+        }
+    }
+
+    let mut indegree: Vec<usize> = deps.iter().map(Vec::len).collect();
+    let mut outstanding: Vec<usize> = dependents.iter().map(Vec::len).collect();
+    let mut reachable: Vec<Option<PackedBitVec>> = vec![None; num];
+
+    let mut graph = Vec::new();
+    let mut layer: Vec<usize> = (0..num).filter(|node| indegree[*node] == 0).collect();
+    let mut sorted = 0;
+
+    while !layer.is_empty() {
+        sorted += layer.len();
+        let mut next = Vec::new();
+        let mut graph_layer = Vec::with_capacity(layer.len());
+
+        for node in layer {
+            let node_deps = mem::take(&mut deps[node]);
+            let mut transitive = PackedBitVec::zeros(num);
+            for dep in node_deps.iter() {
+                transitive.or_inplace(
+                    reachable[*dep]
+                        .as_ref()
+                        .expect("bitsets are only dropped without dependents left"),
+                );
+                outstanding[*dep] -= 1;
+                if outstanding[*dep] == 0 {
+                    reachable[*dep] = None;
+                }
+            }
+            let reduced = node_deps
+                .iter()
+                .filter(|dep| !transitive.get(**dep).expect("in bounds"))
+                .map(|dep| bits[*dep])
+                .collect();
+            graph_layer.push((bits[node], reduced));
+
+            if outstanding[node] != 0 {
+                for dep in node_deps {
+                    transitive.set(dep, true);
+                }
+                reachable[node] = Some(transitive);
+            }
+            for dependent in dependents[node].iter() {
+                indegree[*dependent] -= 1;
+                if indegree[*dependent] == 0 {
+                    next.push(*dependent);
+                }
+            }
+        }
+
+        graph.push(graph_layer);
+        next.sort_unstable();
+        layer = next;
+    }
+
+    if sorted != num {
+        return Err(GraphError::Cyclic {
+            bits: (0..num)
+                .filter(|node| indegree[*node] != 0)
+                .map(|node| bits[node])
+                .collect(),
+        });
+    }
+
+    Ok(graph)
+}
+
+// the frames in which the stack has a non-identity Pauli
+fn non_zero_frames<B: BooleanVector>(
+    stack: &PauliVec<B>,
+) -> impl Iterator<Item = usize> + '_ {
+    let len = stack.left.len().max(stack.right.len());
+    let left = stack.left.iter_vals().chain(iter::repeat(false));
+    let right = stack.right.iter_vals().chain(iter::repeat(false));
+    left.zip(right)
+        .take(len)
+        .enumerate()
+        .filter_map(|(frame, (l, r))| (l || r).then_some(frame))
+}
+
+/// A [DependencyGraph] that is built online, qubit by qubit, for example, directly when
+/// the qubits are measured with [Frames::measure_and_record].
+///
+/// In contrast to [try_create_dependency_graph], the Pauli stacks don't have to be kept
+/// until the end of the circuit and there is no second pass over them: a qubit is
+/// sorted into its layer as soon as it is [insert](Self::insert)ed, and only its
+/// dependencies are stored, so the stack can be dropped afterwards, and the layers that
+/// are already complete can be used, e.g., for scheduling, while the circuit is still
+/// running. This requires that each qubit is inserted after all qubits it depends on.
+/// That is naturally the case if the frames are the corrections of measurements, since
+/// the measured qubit is inserted before the frame of its correction is tracked (and
+/// it also means that there cannot be any cyclic dependencies).
+///
+/// The dependencies are a proper transitive reduction, as in
+/// [try_create_dependency_graph]. They are sorted by the qubit numbers, while the
+/// qubits in each layer are in the order of their insertion.
+///
+/// [Frames::measure_and_record]: crate::tracker::frames::Frames::measure_and_record
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     analyse::IncrementalDependencyGraph,
+///     tracker::{
+///         frames::{
+///             storage::Map,
+///             Frames,
+///         },
+///         Tracker,
+///     },
+/// };
+/// let mut tracker = Frames::<Map<Vec<bool>>>::init(3);
+/// let mut graph = IncrementalDependencyGraph::new();
+/// let mut map = Vec::new();
+///
+/// // we only care about the graph and drop the stacks
+/// tracker.measure_and_record(0, &mut graph, &map).unwrap();
+/// tracker.track_z(1);
+/// map.push(0);
+/// tracker.h(1);
+/// tracker.cx(1, 2);
+/// tracker.measure_and_record(1, &mut graph, &map).unwrap();
+/// // the first two layers are already final
+/// assert_eq!(graph.graph(), &vec![vec![(0, vec![])], vec![(1, vec![0])]]);
+///
+/// tracker.track_z(2);
+/// map.push(1);
+/// tracker.measure_and_record(2, &mut graph, &map).unwrap();
+/// // 2 depends on 0 and 1, but the dependency on 0 is covered by 1
+/// assert_eq!(graph.layer(2), Some(2));
+/// assert_eq!(
+///     graph.into_graph(),
+///     vec![vec![(0, vec![])], vec![(1, vec![0])], vec![(2, vec![1])]]
+/// );
+/// # }
+/// ```
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct IncrementalDependencyGraph {
+    graph: DependencyGraph,
+    // the layer and the position in that layer of each qubit
+    nodes: IntMap<usize, (usize, usize)>,
+}
+
+impl IncrementalDependencyGraph {
+    /// Create an empty graph.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Insert the qu`bit` with its Pauli `stack` into the graph and return the layer it
+    /// is sorted into. As in [try_create_dependency_graph], frame (i) belongs to the
+    /// qubit `map`\[i\].
+    ///
+    /// # Errors
+    /// Returns a [GraphError] if a frame with a non-zero element is not in `map`, if a
+    /// qubit it depends on has not been inserted yet, if it depends on itself, or if
+    /// it has already been inserted. The graph is not changed in that case.
+    pub fn insert<B: BooleanVector>(
+        &mut self,
+        bit: usize,
+        stack: &PauliVec<B>,
+        map: &[usize],
+    ) -> Result<usize, GraphError> {
+        if self.nodes.contains_key(&bit) {
+            return Err(GraphError::Duplicate { bit });
+        }
+        let mut deps = Vec::new();
+        for frame in non_zero_frames(stack) {
+            let dependency =
+                *map.get(frame).ok_or(GraphError::MissingFrame { bit, frame })?;
+            if dependency == bit {
+                return Err(GraphError::Cyclic { bits: vec![bit] });
+            }
+            let (layer, _) = self
+                .nodes
+                .get(&dependency)
+                .ok_or(GraphError::UnknownDependency { bit, dependency })?;
+            deps.push((*layer, dependency));
+        }
+        // a dependency can only be covered by dependencies in higher layers, so when we
+        // go through them from the top, it is enough to check against the kept ones
+        deps.sort_unstable_by(|a, b| b.cmp(a));
+        deps.dedup();
+        let layer = deps.first().map_or(0, |(layer, _)| layer + 1);
+        let mut reduced = Vec::new();
+        for (dep_layer, dep) in deps {
+            if !self.reaches(&reduced, dep, dep_layer) {
+                reduced.push(dep);
+            }
+        }
+        reduced.sort_unstable();
+
+        if layer == self.graph.len() {
+            self.graph.push(Vec::new());
+        }
+        self.nodes.insert(bit, (layer, self.graph[layer].len()));
+        self.graph[layer].push((bit, reduced));
+        Ok(layer)
+    }
+
+    // whether `target`, which is in `target_layer`, is a transitive dependency of one of
+    // the `sources`; only the part of the graph above `target_layer` is searched
+    fn reaches(&self, sources: &[usize], target: usize, target_layer: usize) -> bool {
+        let mut open = sources.to_vec();
+        let mut visited = HashSet::new();
+        while let Some(bit) = open.pop() {
+            let (layer, position) = self.nodes[&bit];
+            if layer <= target_layer {
+                continue;
+            }
+            for dep in self.graph[layer][position].1.iter() {
+                if *dep == target {
+                    return true;
+                }
+                if visited.insert(*dep) {
+                    open.push(*dep);
+                }
+            }
+        }
+        false
+    }
+
+    /// The layer of the qu`bit`, if it has been inserted.
+    pub fn layer(&self, bit: usize) -> Option<usize> {
+        self.nodes.get(&bit).map(|(layer, _)| *layer)
+    }
+
+    /// The number of inserted qubits.
+    pub fn len(&self) -> usize {
+        self.nodes.len()
+    }
+
+    /// Check whether no qubit has been inserted.
+    pub fn is_empty(&self) -> bool {
+        self.nodes.is_empty()
+    }
+
+    /// The graph of the qubits inserted so far.
+    pub fn graph(&self) -> &DependencyGraph {
+        &self.graph
+    }
+
+    /// Convert into the graph of the inserted qubits.
+    pub fn into_graph(self) -> DependencyGraph {
+        self.graph
+    }
+}
+
 // pub(crate) fn invert_dependency_graph<'l, BoolVec, Storage>(
 //     storage: Storage,
 //     map: &[usize],
@@ -230,4 +647,112 @@ mod tests {
         let map = vec![1, 2];
         create_dependency_graph(storage.iter(), &map);
     }
+
+    #[test]
+    fn try_graph_errors() {
+        let storage = Vector {
+            frames: vec![PauliVec::<Vec<bool>>::try_from_str("1", "0").unwrap()],
+        };
+        assert_eq!(
+            try_create_dependency_graph(storage.iter(), &[42]),
+            Err(GraphError::UnknownDependency { bit: 0, dependency: 42 })
+        );
+        assert_eq!(
+            try_create_dependency_graph(storage.iter(), &[]),
+            Err(GraphError::MissingFrame { bit: 0, frame: 0 })
+        );
+
+        let storage = Vector {
+            frames: vec![
+                PauliVec::<Vec<bool>>::try_from_str("", "").unwrap(),
+                PauliVec::<Vec<bool>>::try_from_str("10", "00").unwrap(),
+                PauliVec::<Vec<bool>>::try_from_str("01", "00").unwrap(),
+            ],
+        };
+        assert_eq!(
+            try_create_dependency_graph(storage.iter(), &[1, 2]),
+            Err(GraphError::Cyclic { bits: vec![1, 2] })
+        );
+        assert_eq!(
+            try_create_dependency_graph(Vector::<Vec<bool>>::default().iter(), &[]),
+            Ok(vec![])
+        );
+    }
+
+    #[test]
+    fn transitive_reduction() {
+        // frame i belongs to qubit i; 0 depends on 1 and 3, 1 on 2 and 2 on 3; 4
+        // depends on 1 and 2 via different frames with the same qubit
+        let storage = Vector {
+            frames: vec![
+                PauliVec::<Vec<bool>>::try_from_str("0101", "0").unwrap(),
+                PauliVec::<Vec<bool>>::try_from_str("001", "").unwrap(),
+                PauliVec::<Vec<bool>>::try_from_str("0", "0001").unwrap(),
+                PauliVec::<Vec<bool>>::try_from_str("", "").unwrap(),
+                PauliVec::<Vec<bool>>::try_from_str("01001", "00100").unwrap(),
+            ],
+        };
+        let map = [0, 1, 2, 3, 2];
+        assert_eq!(
+            try_create_dependency_graph(storage.iter(), &map).unwrap(),
+            vec![
+                vec![(3, vec![])],
+                vec![(2, vec![3])],
+                vec![(1, vec![2])],
+                vec![(0, vec![1]), (4, vec![1])],
+            ]
+        );
+    }
+
+    #[test]
+    fn incremental() {
+        // the same as in transitive_reduction, additionally, 5 depends on 0, 2 and 3
+        let stacks = [
+            PauliVec::<Vec<bool>>::try_from_str("0101", "0").unwrap(),
+            PauliVec::<Vec<bool>>::try_from_str("001", "").unwrap(),
+            PauliVec::<Vec<bool>>::try_from_str("0", "0001").unwrap(),
+            PauliVec::<Vec<bool>>::try_from_str("", "").unwrap(),
+            PauliVec::<Vec<bool>>::try_from_str("01001", "00100").unwrap(),
+            PauliVec::<Vec<bool>>::try_from_str("101100", "000010").unwrap(),
+        ];
+        let map = [0, 1, 2, 3, 2, 0];
+        let storage = Vector { frames: stacks.to_vec() };
+        let mut expected = try_create_dependency_graph(storage.iter(), &map).unwrap();
+        sort_layers_by_bits(&mut expected);
+
+        let mut graph = IncrementalDependencyGraph::new();
+        for bit in [3, 2, 1, 0, 4, 5] {
+            let layer = graph.insert(bit, &stacks[bit], &map).unwrap();
+            assert_eq!(graph.layer(bit), Some(layer));
+        }
+        assert_eq!(graph.len(), 6);
+        assert_eq!(graph.into_graph(), expected);
+        assert_eq!(*expected.last().unwrap(), vec![(5, vec![0])]);
+    }
+
+    #[test]
+    fn incremental_errors() {
+        let mut graph = IncrementalDependencyGraph::new();
+        let stack = PauliVec::<Vec<bool>>::try_from_str("01", "00").unwrap();
+        assert_eq!(
+            graph.insert(0, &stack, &[0]),
+            Err(GraphError::MissingFrame { bit: 0, frame: 1 })
+        );
+        assert_eq!(
+            graph.insert(0, &stack, &[1, 2]),
+            Err(GraphError::UnknownDependency { bit: 0, dependency: 2 })
+        );
+        assert_eq!(
+            graph.insert(2, &stack, &[1, 2]),
+            Err(GraphError::Cyclic { bits: vec![2] })
+        );
+        assert!(graph.is_empty());
+        assert_eq!(graph.insert(2, &PauliVec::<Vec<bool>>::new(), &[]), Ok(0));
+        assert_eq!(
+            graph.insert(2, &PauliVec::<Vec<bool>>::new(), &[]),
+            Err(GraphError::Duplicate { bit: 2 })
+        );
+        assert_eq!(graph.insert(0, &stack, &[1, 2]), Ok(1));
+        assert_eq!(graph.graph(), &vec![vec![(2, vec![])], vec![(0, vec![2])]]);
+    }
 }
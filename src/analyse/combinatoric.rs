@@ -1,52 +1,348 @@
-use std::ops::Range;
+// the subsets are enumerated as bitmasks, ordered by their size, and within the same
+// size in increasing numeric order (Gosper's hack), i.e., colexicographically; the
+// partitions are written into reusable buffers, instead of cloning the set and
+// allocating the subset indices for each subset as with itertools' powerset; sets with
+// 64 or more elements do not fit into a mask, so for them we fall back to enumerating
+// the indices of the subsets in the same order
 
-use itertools::{
-    Either,
-    Itertools,
-    Powerset,
-};
+/// The order in which the subsets are enumerated, with respect to their size.
+#[derive(Copy, Clone, Debug, PartialEq, Eq, Default)]
+pub enum SubsetOrder {
+    /// Start with the smallest subsets.
+    #[default]
+    SmallestFirst,
+    /// Start with the largest subsets.
+    LargestFirst,
+}
+
+/// An [Iterator] over the subsets of {0, ..., len - 1}, with at least `min_size`
+/// elements, as bitmasks.
+#[derive(Debug, Clone)]
+pub struct Subsets {
+    len: u32,
+    min_size: u32,
+    size: u32,
+    current: Option<u64>,
+    order: SubsetOrder,
+}
+
+impl Default for Subsets {
+    fn default() -> Self {
+        Self::new(0, 0, SubsetOrder::default())
+    }
+}
+
+#[inline]
+fn first_mask(size: u32) -> u64 {
+    if size == 0 { 0 } else { u64::MAX >> (u64::BITS - size) }
+}
+
+// the size of the first subsets, and the size of the subsets after the ones of `size`
+#[inline]
+fn first_size(len: usize, min_size: usize, order: SubsetOrder) -> usize {
+    match order {
+        SubsetOrder::SmallestFirst => min_size,
+        SubsetOrder::LargestFirst => len,
+    }
+}
+#[inline]
+fn next_size(
+    size: usize,
+    len: usize,
+    min_size: usize,
+    order: SubsetOrder,
+) -> Option<usize> {
+    match order {
+        SubsetOrder::SmallestFirst if size < len => Some(size + 1),
+        SubsetOrder::LargestFirst if size > min_size => Some(size - 1),
+        _ => None,
+    }
+}
+
+impl Subsets {
+    /// # Panics
+    /// Panics if `len` > 63; use [Partition], which falls back to [LargeSubsets].
+    pub fn new(len: usize, min_size: usize, order: SubsetOrder) -> Self {
+        assert!(len < u64::BITS as usize, "too many elements for a mask: {len}");
+        let size = first_size(len, min_size, order) as u32;
+        Self {
+            len: len as u32,
+            min_size: min_size as u32,
+            size,
+            current: (min_size <= len).then(|| first_mask(size)),
+            order,
+        }
+    }
+
+    fn successor(&mut self, mask: u64) -> Option<u64> {
+        if mask != 0 {
+            let lowest = mask & mask.wrapping_neg();
+            let ripple = mask + lowest;
+            let next = (((ripple ^ mask) >> 2) / lowest) | ripple;
+            if next >> self.len == 0 {
+                return Some(next);
+            }
+        }
+        self.size = next_size(
+            self.size as usize,
+            self.len as usize,
+            self.min_size as usize,
+            self.order,
+        )? as u32;
+        Some(first_mask(self.size))
+    }
+}
+
+impl Iterator for Subsets {
+    type Item = u64;
+    fn next(&mut self) -> Option<Self::Item> {
+        let mask = self.current?;
+        self.current = self.successor(mask);
+        Some(mask)
+    }
+}
+
+/// Like [Subsets], but for any `len`; the subsets are represented by their sorted
+/// indices, which are borrowed from an internal buffer.
+#[derive(Debug, Clone)]
+pub struct LargeSubsets {
+    len: usize,
+    min_size: usize,
+    order: SubsetOrder,
+    indices: Vec<usize>,
+    // whether `indices` is the subset to return next, otherwise it's the last returned
+    // one; None if we are done
+    fresh: Option<bool>,
+}
+
+impl LargeSubsets {
+    pub fn new(len: usize, min_size: usize, order: SubsetOrder) -> Self {
+        let size = first_size(len, min_size, order);
+        Self {
+            len,
+            min_size,
+            order,
+            indices: (0..size).collect(),
+            fresh: (min_size <= len).then_some(true),
+        }
+    }
+
+    /// Get the next subset.
+    pub fn next_borrowed(&mut self) -> Option<&[usize]> {
+        if !self.fresh? && !self.advance() {
+            self.fresh = None;
+            return None;
+        }
+        self.fresh = Some(false);
+        Some(&self.indices)
+    }
 
+    // the colexicographic successor: increment the first index that can be incremented
+    // and reset the ones before it
+    fn advance(&mut self) -> bool {
+        let size = self.indices.len();
+        for i in 0..size {
+            let bound = self.indices.get(i + 1).copied().unwrap_or(self.len);
+            if self.indices[i] + 1 < bound {
+                self.indices[i] += 1;
+                for (j, index) in self.indices[..i].iter_mut().enumerate() {
+                    *index = j;
+                }
+                return true;
+            }
+        }
+        match next_size(size, self.len, self.min_size, self.order) {
+            Some(size) => {
+                self.indices.clear();
+                self.indices.extend(0..size);
+                true
+            }
+            None => false,
+        }
+    }
+}
+
+#[derive(Debug, Clone)]
+enum Inner {
+    Mask(Subsets),
+    Large(LargeSubsets),
+}
+
+/// An iterator over the partitions of `set` into a subset and its complement, cf.
+/// [Subsets].
 #[derive(Debug, Clone)]
 pub struct Partition<T> {
-    pub set: T,
-    iter: Powerset<Range<usize>>,
+    pub set: Vec<T>,
+    subsets: Inner,
+    subset: Vec<T>,
+    complement: Vec<T>,
 }
 
-impl<T: Default> Default for Partition<T> {
+impl<T> Default for Partition<T> {
     fn default() -> Self {
         Self {
-            set: T::default(),
-            iter: (0..0).powerset(),
+            set: Vec::new(),
+            subsets: Inner::Mask(Subsets::default()),
+            subset: Vec::new(),
+            complement: Vec::new(),
         }
     }
 }
 
 impl<T> Partition<T> {
-    pub fn new(set: T, len: usize) -> Self {
-        Self { set, iter: (0..len).powerset() }
+    /// Iterate over all partitions, starting with the empty subset.
+    pub fn new(set: Vec<T>) -> Self {
+        Self::with_subsets(set, 0, SubsetOrder::default())
+    }
+
+    /// Iterate over the partitions where the subset is not empty, in the given `order`.
+    pub fn non_empty(set: Vec<T>, order: SubsetOrder) -> Self {
+        Self::with_subsets(set, 1, order)
+    }
+
+    fn with_subsets(set: Vec<T>, min_size: usize, order: SubsetOrder) -> Self {
+        let len = set.len();
+        let subsets = if len < u64::BITS as usize {
+            Inner::Mask(Subsets::new(len, min_size, order))
+        } else {
+            Inner::Large(LargeSubsets::new(len, min_size, order))
+        };
+        Self {
+            set,
+            subsets,
+            subset: Vec::with_capacity(len),
+            complement: Vec::with_capacity(len),
+        }
+    }
+}
+
+impl<T: Clone> Partition<T> {
+    /// Get the next partition as (subset, complement), borrowed from internal buffers
+    /// that are reused for the following partitions.
+    pub fn next_borrowed(&mut self) -> Option<(&[T], &[T])> {
+        self.subset.clear();
+        self.complement.clear();
+        match &mut self.subsets {
+            Inner::Mask(subsets) => {
+                let mask = subsets.next()?;
+                for (i, e) in self.set.iter().enumerate() {
+                    if (mask >> i) & 1 == 1 {
+                        self.subset.push(e.clone());
+                    } else {
+                        self.complement.push(e.clone());
+                    }
+                }
+            }
+            Inner::Large(subsets) => {
+                let mut indices = subsets.next_borrowed()?.iter().peekable();
+                for (i, e) in self.set.iter().enumerate() {
+                    if indices.next_if_eq(&&i).is_some() {
+                        self.subset.push(e.clone());
+                    } else {
+                        self.complement.push(e.clone());
+                    }
+                }
+            }
+        }
+        Some((&self.subset, &self.complement))
     }
 }
 
-impl<T> Iterator for Partition<T>
-where
-    T: IntoIterator + Clone,
-{
-    type Item = (Vec<T::Item>, Vec<T::Item>);
+impl<T: Clone> Iterator for Partition<T> {
+    type Item = (Vec<T>, Vec<T>);
     fn next(&mut self) -> Option<Self::Item> {
-        match self.iter.next() {
-            Some(subset) => {
-                let mut subset = subset.into_iter().peekable();
-                Some(self.set.clone().into_iter().enumerate().partition_map(
-                    |(i, e)| match subset.peek() {
-                        Some(&p) if p == i => {
-                            subset.next();
-                            Either::Left(e)
-                        }
-                        _ => Either::Right(e),
-                    },
-                ))
+        self.next_borrowed()
+            .map(|(subset, complement)| (subset.to_vec(), complement.to_vec()))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+    use itertools::Itertools;
+
+    use super::*;
+
+    #[test]
+    fn same_as_powerset() {
+        for len in [0, 1, 4, 7] {
+            let subsets = Partition::new((0..len).collect())
+                .map(|(subset, _)| subset)
+                .collect::<Vec<Vec<usize>>>();
+            assert!(subsets.windows(2).all(|w| w[0].len() <= w[1].len()));
+            assert_eq!(
+                subsets.into_iter().sorted().collect::<Vec<_>>(),
+                (0..len).powerset().sorted().collect::<Vec<_>>()
+            );
+        }
+    }
+
+    #[test]
+    fn orders() {
+        let mut partition =
+            Partition::non_empty(vec![3, 4, 5], SubsetOrder::LargestFirst);
+        let mut sizes = Vec::new();
+        while let Some((subset, complement)) = partition.next_borrowed() {
+            assert_eq!(subset.len() + complement.len(), 3);
+            sizes.push(subset.len());
+        }
+        assert_eq!(sizes, vec![3, 2, 2, 2, 1, 1, 1]);
+        assert_eq!(
+            Partition::non_empty(vec![3, 4], SubsetOrder::SmallestFirst)
+                .collect::<Vec<_>>(),
+            vec![(vec![3], vec![4]), (vec![4], vec![3]), (vec![3, 4], vec![])]
+        );
+        assert_eq!(
+            Partition::<usize>::non_empty(vec![], SubsetOrder::LargestFirst).count(),
+            0
+        );
+        assert_eq!(Subsets::new(63, 63, SubsetOrder::SmallestFirst).count(), 1);
+        assert_eq!(Subsets::new(20, 0, SubsetOrder::LargestFirst).count(), 1 << 20);
+    }
+
+    #[test]
+    fn large_same_as_mask() {
+        for order in [SubsetOrder::SmallestFirst, SubsetOrder::LargestFirst] {
+            for (len, min_size) in [(0, 0), (1, 1), (5, 0), (9, 1), (9, 4), (3, 4)] {
+                let mut large = LargeSubsets::new(len, min_size, order);
+                let mut masks = Vec::new();
+                while let Some(indices) = large.next_borrowed() {
+                    masks.push(indices.iter().map(|i| 1 << i).sum::<u64>());
+                }
+                assert!(large.next_borrowed().is_none());
+                assert_eq!(
+                    masks,
+                    Subsets::new(len, min_size, order).collect::<Vec<_>>()
+                );
             }
-            None => None,
         }
     }
+
+    #[test]
+    fn many_elements() {
+        let len = 70;
+        let mut partition =
+            Partition::non_empty((0..len).collect(), SubsetOrder::SmallestFirst);
+        let mut pairs = Vec::new();
+        for i in 0..len + len * (len - 1) / 2 {
+            let (subset, complement) = partition.next_borrowed().unwrap();
+            assert_eq!(subset.len() + complement.len(), len);
+            if i < len {
+                assert_eq!(subset, [i]);
+            } else {
+                pairs.push(subset.to_vec());
+            }
+        }
+        assert_eq!(
+            pairs.into_iter().sorted().collect::<Vec<_>>(),
+            (0..len).combinations(2).collect::<Vec<_>>()
+        );
+        assert_eq!(partition.next().unwrap().0.len(), 3);
+
+        let mut partition =
+            Partition::non_empty((0..len).collect(), SubsetOrder::LargestFirst);
+        assert_eq!(partition.next(), Some(((0..len).collect(), vec![])));
+        let (subset, complement) = partition.next_borrowed().unwrap();
+        assert_eq!((subset.len(), complement), (len - 1, &[len - 1][..]));
+    }
 }
@@ -2,9 +2,19 @@
 ...
 */
 
-use std::fmt::Display;
+use std::{
+    fmt::Display,
+    sync::atomic::{
+        AtomicUsize,
+        Ordering,
+    },
+};
 
 use self::{
+    pareto::{
+        ParetoFront,
+        Path,
+    },
     space::{
         AlreadyMeasured,
         Graph,
@@ -16,6 +26,8 @@ use self::{
     tree::{
         Focus,
         FocusIterator,
+        Step,
+        Sweep,
     },
 };
 
@@ -28,10 +40,17 @@ macro_rules! update {
         *$bit = *update!($bit, $map);
     };
 }
+pub mod heuristic;
+pub mod memo;
+#[cfg(feature = "rayon")]
+#[cfg_attr(docsrs, doc(cfg(feature = "rayon")))]
+pub mod parallel;
+pub mod pareto;
 pub mod space;
 pub mod time;
 pub mod tree;
 
+#[derive(Clone)]
 pub struct Scheduler<'l> {
     time: PathGenerator<'l>,
     space: Graph,
@@ -41,10 +60,102 @@ impl<'l> Scheduler<'l> {
     pub fn new(time: PathGenerator<'l>, space: Graph) -> Self {
         Self { time, space }
     }
+
+    /// Sweep through all schedules and collect the [ParetoFront] of their number of
+    /// time steps and their maximum memory.
+    pub fn pareto_front(self) -> ParetoFront {
+        metric!(time(Sweep));
+        let mut front = ParetoFront::new();
+        sweep_into(self, &mut Vec::new(), &mut front);
+        front
+    }
+
+    /// Like [pareto_front](Self::pareto_front), but with branch-and-bound pruning.
+    ///
+    /// When moving to a new node, we bound the time steps from below with the current
+    /// path length plus the longest remaining dependency chain (cf.
+    /// [PathGenerator::min_remaining_steps]), and the memory with the current maximum
+    /// memory (which never decreases along a path). If this bound is already
+    /// dominated by the front found so far, no schedule through the node can improve
+    /// the front and the subtree is skipped. After a new schedule has been found, the
+    /// same check is done for the nodes on the current path.
+    ///
+    /// The resulting points on the front are the same as for the exhaustive sweep,
+    /// however, for points with multiple paths, it might keep a different path.
+    pub fn bounded_pareto_front(self) -> ParetoFront {
+        metric!(time(Sweep));
+        let heights = self.time.chain_heights();
+        let mut front = ParetoFront::new();
+        let mut path = Vec::new();
+        if let Some(memory) = self.at_leaf() {
+            front.insert(0, memory, Vec::new());
+            return front;
+        }
+
+        let bound = |scheduler: &Self, len: usize| {
+            (
+                len + scheduler.time.min_remaining_steps(&heights),
+                scheduler.space.max_memory(),
+            )
+        };
+
+        let mut sweep = Sweep::new(self, Vec::new());
+        while let Some(step) = sweep.next() {
+            match step {
+                Step::Forward(mess) => {
+                    let (time, memory) = bound(sweep.current(), path.len() + 1);
+                    if front.is_dominated(time, memory) {
+                        sweep
+                            .skip_focus()
+                            .expect("bug: we moved forward, so the stack is not empty");
+                    } else {
+                        path.push(mess);
+                    }
+                }
+                Step::Backward(at_leaf) => {
+                    if let Some(memory) = at_leaf {
+                        front.insert_with(path.len(), memory, || path.clone());
+                    }
+                    path.pop();
+                    // the front might have improved, so we check whether we can stop
+                    // the parent already
+                    let (time, memory) = bound(sweep.current(), path.len());
+                    if front.is_dominated(time, memory) {
+                        if sweep.skip_focus().is_err() {
+                            break;
+                        }
+                        path.pop();
+                    }
+                }
+            }
+        }
+        front
+    }
 }
 
-// just for seeing whether it works as expected while developing
-pub(crate) static mut COUNT: usize = 0;
+// sweep through the subtree below `scheduler`, where `path` leads to `scheduler`, and
+// insert the leafs into `front`; `path` is the same when the function returns
+fn sweep_into(scheduler: Scheduler<'_>, path: &mut Path, front: &mut ParetoFront) {
+    // the Sweep doesn't yield the final backward step out of the root
+    if let Some(memory) = scheduler.at_leaf() {
+        front.insert_with(path.len(), memory, || path.clone());
+    }
+    for step in Sweep::new(scheduler, Vec::new()) {
+        match step {
+            Step::Forward(mess) => path.push(mess),
+            Step::Backward(at_leaf) => {
+                if let Some(memory) = at_leaf {
+                    front.insert_with(path.len(), memory, || path.clone());
+                }
+                path.pop();
+            }
+        }
+    }
+}
+
+// just for seeing whether it works as expected while developing; atomic, since the
+// Scheduler might be driven by multiple threads
+pub(crate) static COUNT: AtomicUsize = AtomicUsize::new(0);
 
 impl Focus<(&Vec<usize>, Vec<usize>)> for Scheduler<'_> {
     type Error = InstructionError;
@@ -70,7 +181,7 @@ impl FocusIterator for Scheduler<'_> {
         Self: Sized,
     {
         let (new_time, mess) = self.time.next_and_focus()?;
-        unsafe { COUNT += 1 };
+        COUNT.fetch_add(1, Ordering::Relaxed);
         let new_space = self.space.focus(&mess).unwrap();
         Some((Self { time: new_time, space: new_space }, mess))
     }
@@ -116,7 +227,6 @@ mod tests {
     use coverage_helper::test;
 
     use super::*;
-    use crate::analyse::schedule::tree::Step;
 
     #[test]
     fn scheduler() {
@@ -157,7 +267,91 @@ mod tests {
             }
         }
         println!("result: {:?}", results.len());
-        println!("count: {:?}", unsafe { COUNT });
+        println!("count: {:?}", COUNT.load(Ordering::Relaxed));
+    }
+
+    #[test]
+    fn pareto_front() {
+        let (space, time, num_nodes) = input();
+        let mut look = time::LookupBuffer::new(num_nodes);
+        let scheduler = Scheduler::new(
+            PathGenerator::from_dependency_graph(time, &mut look, None),
+            Graph::new(num_nodes, &space, None),
+        );
+
+        let mut all = Vec::new();
+        let mut path = Vec::new();
+        for step in scheduler.clone() {
+            match step {
+                Step::Forward(mess) => path.push(mess),
+                Step::Backward(at_leaf) => {
+                    if let Some(max_memory) = at_leaf {
+                        all.push((path.len(), max_memory));
+                    }
+                    path.pop();
+                }
+            }
+        }
+
+        let front = scheduler.pareto_front();
+        for (time, memory) in all {
+            assert!(front.is_dominated(time, memory));
+        }
+        for entry in front.entries() {
+            assert_eq!(entry.path.len(), entry.time);
+        }
+        assert_eq!(front.entries().first().map(|entry| entry.time), Some(3));
+    }
+
+    #[test]
+    fn bounded_pareto_front() {
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn points(front: &ParetoFront) -> Vec<(usize, usize)> {
+            front
+                .entries()
+                .iter()
+                .map(|entry| (entry.time, entry.memory))
+                .collect()
+        }
+
+        let (space, time, num_nodes) = input();
+        let mut look = time::LookupBuffer::new(num_nodes);
+        let scheduler = Scheduler::new(
+            PathGenerator::from_dependency_graph(time, &mut look, None),
+            Graph::new(num_nodes, &space, None),
+        );
+        assert_eq!(
+            points(&scheduler.clone().bounded_pareto_front()),
+            points(&scheduler.pareto_front())
+        );
+
+        // a chain 0 - 1 - ... - 7, where all bits are independent, so the exhaustive
+        // sweep goes through all ordered set partitions
+        let num = 7;
+        let space: Vec<_> = (1..num).map(|i| (i - 1, i)).collect();
+        let time = vec![(0..num).map(|i| (i, vec![])).collect()];
+        let mut look = time::LookupBuffer::new(num);
+        let scheduler = Scheduler::new(
+            PathGenerator::from_dependency_graph(time, &mut look, None),
+            Graph::new(num, &space, None),
+        );
+        let bounded = scheduler.clone().bounded_pareto_front();
+        assert_eq!(points(&bounded), points(&scheduler.clone().pareto_front()));
+        let largest_first = Scheduler::new(
+            scheduler
+                .time
+                .clone()
+                .with_subset_order(time::SubsetOrder::LargestFirst),
+            scheduler.space.clone(),
+        );
+        assert_eq!(
+            points(&largest_first.bounded_pareto_front()),
+            points(&bounded)
+        );
+        assert_eq!(bounded.entries()[0].time, 1);
+        for entry in bounded.entries() {
+            assert_eq!(entry.path.len(), entry.time);
+        }
     }
 
     #[test]
@@ -185,7 +379,7 @@ mod tests {
                     } else {
                         path.len() + 2
                     };
-                    // unsafe { COUNT += 1 };
+                    // COUNT.fetch_add(1, Ordering::Relaxed);
                     if current.space.max_memory() >= predicates[minimum_time] {
                         if scheduler.skip_focus().is_err() {
                             break;
@@ -210,7 +404,7 @@ mod tests {
                     //     path.len() + 1
                     // };
                     let minimum_time = path.len() + 1;
-                    // unsafe { COUNT += 1 };
+                    // COUNT.fetch_add(1, Ordering::Relaxed);
                     if current.space.max_memory() >= predicates[minimum_time] {
                         path.pop();
                         if scheduler.skip_focus().is_err() {
@@ -221,7 +415,7 @@ mod tests {
             }
         }
         println!("result: {:?}", results.len());
-        println!("count: {:?}", unsafe { COUNT });
+        println!("count: {:?}", COUNT.load(Ordering::Relaxed));
     }
 
     #[allow(clippy::type_complexity)]
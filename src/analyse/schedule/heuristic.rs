@@ -0,0 +1,350 @@
+/*!
+Polynomial-time heuristics (greedy and beam search) to find a schedule.
+
+The exhaustive sweeps through the [Scheduler](super::Scheduler) tree try all
+partitions of the measurable sets, which is only possible for small graphs. The
+[Heuristic] instead considers in each step only the measurable bits sorted by the
+number of bits they would newly initialize, and tries measuring the cheapest `k` of
+them, for all `k`. The candidates are rated by an [Objective] that weights the number
+of time steps (including a lower bound for the remaining steps) against the maximum
+memory, and the best `width` of them are kept for the next step (beam search; a width
+of 1 is a greedy search). Only the kept candidates are actually built, so one step
+costs roughly *O*(width · (measurable bits · log + graph size)).
+
+The resulting [Entry] has the same path format as the exhaustive sweeps, so one can,
+e.g., use the heuristic for the whole graph and the exact search only for small
+subgraphs.
+*/
+
+use std::collections::HashMap;
+
+use super::{
+    pareto::{
+        Entry,
+        Path,
+    },
+    space::Graph,
+};
+use crate::analyse::DependencyGraph;
+
+/// The weights of the time steps and the maximum memory; a schedule is rated as `time`
+/// · steps + `memory` · maximum memory, where lower is better.
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+pub struct Objective {
+    pub time: usize,
+    pub memory: usize,
+}
+
+impl Default for Objective {
+    fn default() -> Self {
+        Self { time: 1, memory: 1 }
+    }
+}
+
+impl Objective {
+    fn rate(&self, time: usize, memory: usize) -> usize {
+        self.time * time + self.memory * memory
+    }
+}
+
+/// The input for the heuristic searches, cf. the [module](self) documentation.
+#[derive(Clone, Debug)]
+pub struct Heuristic {
+    dependents: Vec<Vec<usize>>,
+    // the number of steps needed to measure a bit and all the bits that depend on it
+    heights: Vec<usize>,
+    root: Node,
+}
+
+#[derive(Clone, Debug)]
+struct Node {
+    space: Graph,
+    open_deps: Vec<usize>,
+    measurable: Vec<usize>,
+    path: Path,
+}
+
+// a not yet built child: measure the `num` cheapest measurable bits of the `parent`
+struct Candidate {
+    rating: usize,
+    parent: usize,
+    num: usize,
+}
+
+impl Heuristic {
+    /// Create the input from the `graph` describing the time ordering and the `edges`
+    /// describing the space, taking the same arguments as
+    /// [PathGenerator::from_dependency_graph](super::time::PathGenerator::from_dependency_graph)
+    /// and [Graph::new].
+    ///
+    /// # Panics
+    /// Panics if a bit is not smaller than `num_bits` or if it is not in the
+    /// `bit_mapping`.
+    pub fn new(
+        mut graph: DependencyGraph,
+        num_bits: usize,
+        edges: &[(usize, usize)],
+        bit_mapping: Option<&HashMap<usize, usize>>,
+    ) -> Self {
+        if let Some(bit_mapping) = bit_mapping {
+            for layer in graph.iter_mut() {
+                for (bit, deps) in layer {
+                    update!(bit; bit_mapping);
+                    for dep in deps.iter_mut() {
+                        update!(dep; bit_mapping);
+                    }
+                }
+            }
+        }
+
+        let mut dependents = vec![Vec::new(); num_bits];
+        let mut open_deps = vec![0; num_bits];
+        let mut measurable = Vec::new();
+        for (bit, deps) in graph.iter().flatten() {
+            if deps.is_empty() {
+                measurable.push(*bit);
+            }
+            open_deps[*bit] = deps.len();
+            for dep in deps {
+                dependents[*dep].push(*bit);
+            }
+        }
+
+        // the layers are topologically sorted, so we can go backwards
+        let mut heights = vec![0; num_bits];
+        for (bit, _) in graph.iter().rev().flatten() {
+            heights[*bit] =
+                1 + dependents[*bit].iter().map(|d| heights[*d]).max().unwrap_or(0);
+        }
+
+        Self {
+            dependents,
+            heights,
+            root: Node {
+                space: Graph::new(num_bits, edges, bit_mapping),
+                open_deps,
+                measurable,
+                path: Vec::new(),
+            },
+        }
+    }
+
+    /// A greedy search, i.e., a [beam_search](Self::beam_search) with width 1.
+    pub fn greedy(&self, objective: Objective) -> Entry {
+        self.beam_search(1, objective)
+    }
+
+    /// Search a schedule with a beam search that keeps the `width` best candidates in
+    /// each step, cf. the [module](self) documentation.
+    ///
+    /// # Panics
+    /// Panics if `width` is 0.
+    pub fn beam_search(&self, width: usize, objective: Objective) -> Entry {
+        assert!(width > 0, "the beam width must be positive");
+        let mut beam = vec![self.root.clone()];
+        let mut best: Option<(usize, Entry)> = None;
+        // reused buffers
+        let mut candidates = Vec::new();
+        let mut stamps = vec![0; self.heights.len()];
+        let mut stamp = 0;
+
+        while !beam.is_empty() {
+            candidates.clear();
+            for (parent, node) in beam.iter_mut().enumerate() {
+                if node.measurable.is_empty() {
+                    let time = node.path.len();
+                    let memory = node.space.max_memory();
+                    let rating = objective.rate(time, memory);
+                    if best.as_ref().map_or(true, |(r, _)| rating < *r) {
+                        let path = node.path.clone();
+                        best = Some((rating, Entry { time, memory, path }));
+                    }
+                    continue;
+                }
+
+                let mut costs: Vec<(usize, usize)> = node
+                    .measurable
+                    .iter()
+                    .map(|bit| (node.space.newly_initialized(*bit).count(), *bit))
+                    .collect();
+                costs.sort_unstable();
+                for (i, (_, bit)) in costs.iter().enumerate() {
+                    node.measurable[i] = *bit;
+                }
+
+                // the bits that are not measured now need at least their height many
+                // steps; the measured ones at least their height - 1
+                let mut rest_height = vec![0; node.measurable.len() + 1];
+                for (i, bit) in node.measurable.iter().enumerate().rev() {
+                    rest_height[i] = rest_height[i + 1].max(self.heights[*bit]);
+                }
+
+                stamp += 1;
+                let steps = node.path.len() + 1;
+                let mut new_memory = 0;
+                let mut measured_height = 0;
+                for (i, bit) in node.measurable.iter().enumerate() {
+                    for new in node.space.newly_initialized(*bit) {
+                        if stamps[new] != stamp {
+                            stamps[new] = stamp;
+                            new_memory += 1;
+                        }
+                    }
+                    measured_height = measured_height.max(self.heights[*bit] - 1);
+                    let lower_bound = measured_height.max(rest_height[i + 1]);
+                    let memory = node
+                        .space
+                        .max_memory()
+                        .max(node.space.current_memory() + new_memory);
+                    candidates.push(Candidate {
+                        rating: objective.rate(steps + lower_bound, memory),
+                        parent,
+                        num: i + 1,
+                    });
+                }
+            }
+
+            // prefer measuring more bits if the rating is the same
+            candidates
+                .sort_unstable_by_key(|c| (c.rating, usize::MAX - c.num, c.parent));
+            if let Some((best_rating, _)) = best {
+                // the ratings are lower bounds, so these candidates cannot improve
+                candidates.retain(|c| c.rating < best_rating);
+            }
+            candidates.truncate(width);
+            beam = candidates
+                .iter()
+                .map(|c| self.child(&beam[c.parent], c.num))
+                .collect();
+        }
+
+        best.map(|(_, entry)| entry).unwrap_or(Entry {
+            time: 0,
+            memory: 0,
+            path: Vec::new(),
+        })
+    }
+
+    fn child(&self, parent: &Node, num: usize) -> Node {
+        let (measuring, rest) = parent.measurable.split_at(num);
+        let mut space = parent.space.clone();
+        space
+            .update(measuring)
+            .expect("bug: the bits are only measurable once");
+        let mut open_deps = parent.open_deps.clone();
+        let mut measurable = rest.to_vec();
+        for bit in measuring {
+            for dependent in self.dependents[*bit].iter() {
+                open_deps[*dependent] -= 1;
+                if open_deps[*dependent] == 0 {
+                    measurable.push(*dependent);
+                }
+            }
+        }
+        let mut path = parent.path.clone();
+        path.push(measuring.to_vec());
+        Node {
+            space,
+            open_deps,
+            measurable,
+            path,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::analyse::schedule::{
+        time::{
+            LookupBuffer,
+            PathGenerator,
+        },
+        Scheduler,
+    };
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn input() -> (Vec<(usize, usize)>, DependencyGraph) {
+        let space = vec![
+            (0, 1),
+            (1, 2),
+            (1, 3),
+            (2, 4),
+            (4, 3),
+            (5, 0),
+            (5, 6),
+            (6, 7),
+            (2, 7),
+        ];
+        let time = vec![
+            vec![(0, vec![]), (2, vec![]), (5, vec![]), (6, vec![])],
+            vec![(3, vec![0]), (1, vec![0, 2]), (7, vec![6])],
+            vec![(4, vec![0, 3])],
+        ];
+        (space, time)
+    }
+
+    // check that the path is valid and that time and memory are correct
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn check(entry: &Entry, space: &[(usize, usize)], time: &DependencyGraph) {
+        let deps: HashMap<usize, Vec<usize>> = time.iter().flatten().cloned().collect();
+        let mut graph = Graph::new(8, space, None);
+        let mut measured = Vec::new();
+        for step in entry.path.iter() {
+            for bit in step {
+                assert!(deps[bit].iter().all(|dep| measured.contains(dep)), "{bit}");
+            }
+            graph.update(step).unwrap();
+            measured.extend_from_slice(step);
+        }
+        measured.sort();
+        assert_eq!(measured, (0..8).collect::<Vec<_>>());
+        assert_eq!(entry.time, entry.path.len());
+        assert_eq!(entry.memory, graph.max_memory());
+    }
+
+    #[test]
+    fn valid_schedules() {
+        let (space, time) = input();
+        let heuristic = Heuristic::new(time.clone(), 8, &space, None);
+
+        let mut look = LookupBuffer::new(8);
+        let exact = Scheduler::new(
+            PathGenerator::from_dependency_graph(time.clone(), &mut look, None),
+            Graph::new(8, &space, None),
+        )
+        .pareto_front();
+        let fastest = exact.entries().first().unwrap();
+        let smallest = exact.entries().last().unwrap();
+
+        for objective in [
+            Objective::default(),
+            Objective { time: 100, memory: 1 },
+            Objective { time: 1, memory: 100 },
+            Objective { time: 0, memory: 1 },
+        ] {
+            for width in [1, 3, 20] {
+                let entry = heuristic.beam_search(width, objective);
+                check(&entry, &space, &time);
+                assert!(entry.time >= fastest.time);
+                assert!(entry.memory >= smallest.memory);
+            }
+        }
+
+        // measuring everything that is possible gives the fastest schedule
+        let entry = heuristic.greedy(Objective { time: 100, memory: 1 });
+        assert_eq!(entry.time, fastest.time);
+        assert_eq!(entry.time, time.len());
+    }
+
+    #[test]
+    fn empty() {
+        let heuristic = Heuristic::new(Vec::new(), 0, &[], None);
+        assert_eq!(
+            heuristic.greedy(Objective::default()),
+            Entry { time: 0, memory: 0, path: vec![] }
+        );
+    }
+}
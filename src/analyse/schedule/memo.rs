@@ -0,0 +1,295 @@
+/*!
+Memoize the results of subtrees in a [Scheduler] sweep.
+
+Different orders of measurements often lead to the same state, e.g., measuring first
+{0} and then {1}, or first {1} and then {0}. The future of such a state, i.e., the
+subtree below it, only depends on which bits are measured and which are initialized
+(the bits that can be measured next are determined by the measured bits). A
+[TranspositionTable] stores, for each such state, the Pareto front of the remaining
+time steps and the peak memory of the remaining schedule, so the subtree is only
+explored once, as long as the state is not evicted. The table is bounded and evicts
+the least recently used states.
+*/
+
+use std::collections::HashMap;
+
+use super::{
+    pareto::{
+        Entry,
+        ParetoFront,
+    },
+    tree::FocusIterator,
+    Scheduler,
+};
+
+type Key = Vec<u64>;
+
+const NIL: usize = usize::MAX;
+
+#[derive(Debug, Clone)]
+struct Slot {
+    key: Key,
+    front: ParetoFront,
+    // towards the most recently used
+    prev: usize,
+    // towards the least recently used
+    next: usize,
+}
+
+/// A bounded cache for the [Scheduler::memoized_pareto_front] with least recently used
+/// eviction, cf. the [module](self) documentation.
+///
+/// A table must only be used for one [Scheduler] (or its subtrees), since the states
+/// of different graphs cannot be distinguished; use [clear](Self::clear) to reuse it
+/// for another one.
+#[derive(Debug, Clone)]
+pub struct TranspositionTable {
+    capacity: usize,
+    map: HashMap<Key, usize>,
+    slots: Vec<Slot>,
+    head: usize,
+    tail: usize,
+    hits: usize,
+    misses: usize,
+}
+
+impl TranspositionTable {
+    /// Create a table that stores at most `capacity` states; a `capacity` of 0 disables
+    /// the caching.
+    pub fn new(capacity: usize) -> Self {
+        Self {
+            capacity,
+            map: HashMap::new(),
+            slots: Vec::new(),
+            head: NIL,
+            tail: NIL,
+            hits: 0,
+            misses: 0,
+        }
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.capacity
+    }
+
+    /// The number of stored states.
+    pub fn len(&self) -> usize {
+        self.slots.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.slots.is_empty()
+    }
+
+    /// The number of lookups that found a state.
+    pub fn hits(&self) -> usize {
+        self.hits
+    }
+
+    /// The number of lookups that didn't find a state.
+    pub fn misses(&self) -> usize {
+        self.misses
+    }
+
+    /// Remove all states and reset the statistics.
+    pub fn clear(&mut self) {
+        *self = Self::new(self.capacity);
+    }
+
+    fn get(&mut self, key: &Key) -> Option<&ParetoFront> {
+        match self.map.get(key) {
+            Some(&idx) => {
+                self.hits += 1;
+                self.detach(idx);
+                self.push_front(idx);
+                Some(&self.slots[idx].front)
+            }
+            None => {
+                self.misses += 1;
+                None
+            }
+        }
+    }
+
+    fn insert(&mut self, key: Key, front: ParetoFront) {
+        if self.capacity == 0 {
+            return;
+        }
+        let idx = if self.slots.len() < self.capacity {
+            self.slots.push(Slot {
+                key: key.clone(),
+                front,
+                prev: NIL,
+                next: NIL,
+            });
+            self.slots.len() - 1
+        } else {
+            let idx = self.tail;
+            self.detach(idx);
+            let slot = &mut self.slots[idx];
+            self.map.remove(&slot.key);
+            slot.key = key.clone();
+            slot.front = front;
+            idx
+        };
+        self.map.insert(key, idx);
+        self.push_front(idx);
+    }
+
+    fn detach(&mut self, idx: usize) {
+        let Slot { prev, next, .. } = self.slots[idx];
+        match prev {
+            NIL => self.head = next,
+            prev => self.slots[prev].next = next,
+        }
+        match next {
+            NIL => self.tail = prev,
+            next => self.slots[next].prev = prev,
+        }
+    }
+
+    fn push_front(&mut self, idx: usize) {
+        self.slots[idx].prev = NIL;
+        self.slots[idx].next = self.head;
+        match self.head {
+            NIL => self.tail = idx,
+            head => self.slots[head].prev = idx,
+        }
+        self.head = idx;
+    }
+}
+
+impl Scheduler<'_> {
+    /// Like [pareto_front](Scheduler::pareto_front), but with memoization of the
+    /// subtrees in the `table`, cf. the [module](self) documentation.
+    ///
+    /// The resulting points on the front are the same as for the exhaustive sweep,
+    /// however, for points with multiple paths, it might keep a different path.
+    pub fn memoized_pareto_front(
+        mut self,
+        table: &mut TranspositionTable,
+    ) -> ParetoFront {
+        metric!(time(Sweep));
+        let past_memory = self.space.max_memory();
+        self.space.reset_max_memory();
+        let mut front = ParetoFront::new();
+        for Entry { time, memory, path } in solve(&mut self, table).into_entries() {
+            front.insert(time, memory.max(past_memory), path);
+        }
+        front
+    }
+}
+
+// the front of the remaining time steps and the peak memory of the remaining schedule,
+// where the max_memory of `scheduler` has been reset, so that it is the current memory
+fn solve(scheduler: &mut Scheduler<'_>, table: &mut TranspositionTable) -> ParetoFront {
+    if let Some(memory) = scheduler.at_leaf() {
+        let mut front = ParetoFront::new();
+        front.insert(0, memory, Vec::new());
+        return front;
+    }
+    let key = scheduler.space.state_key();
+    if let Some(front) = table.get(&key) {
+        return front.clone();
+    }
+
+    let mut front = ParetoFront::new();
+    while let Some((mut child, mess)) = scheduler.next_and_focus() {
+        // since the max_memory of the parent has been reset, this is the peak memory
+        // of this step
+        let step_memory = child.space.max_memory();
+        child.space.reset_max_memory();
+        for Entry { time, memory, path } in solve(&mut child, table).into_entries() {
+            front.insert_with(time + 1, memory.max(step_memory), || {
+                let mut new_path = Vec::with_capacity(path.len() + 1);
+                new_path.push(mess.clone());
+                new_path.extend(path);
+                new_path
+            });
+        }
+    }
+
+    table.insert(key, front.clone());
+    front
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::analyse::schedule::{
+        space::Graph,
+        time::{
+            LookupBuffer,
+            PathGenerator,
+        },
+    };
+
+    #[test]
+    fn lru() {
+        let front = |time| {
+            let mut front = ParetoFront::new();
+            front.insert(time, 0, Vec::new());
+            front
+        };
+        let mut table = TranspositionTable::new(2);
+        table.insert(vec![1], front(1));
+        table.insert(vec![2], front(2));
+        assert!(table.get(&vec![1]).is_some());
+        table.insert(vec![3], front(3));
+        assert_eq!(table.len(), 2);
+        assert!(table.get(&vec![2]).is_none());
+        assert_eq!(table.get(&vec![1]), Some(&front(1)));
+        assert_eq!(table.get(&vec![3]), Some(&front(3)));
+        assert_eq!((table.hits(), table.misses()), (3, 1));
+
+        let mut table = TranspositionTable::new(0);
+        table.insert(vec![1], front(1));
+        assert!(table.is_empty());
+        assert!(table.get(&vec![1]).is_none());
+    }
+
+    #[test]
+    fn compare_with_sweep() {
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn points(front: &ParetoFront) -> Vec<(usize, usize)> {
+            front
+                .entries()
+                .iter()
+                .map(|entry| (entry.time, entry.memory))
+                .collect()
+        }
+
+        let num = 6;
+        let space: Vec<_> = (1..num).map(|i| (i - 1, i)).chain([(0, 5)]).collect();
+        let time = vec![
+            (0..num - 1).map(|i| (i, vec![])).collect(),
+            vec![(num - 1, vec![0, 2])],
+        ];
+        let mut look = LookupBuffer::new(num);
+        let scheduler = Scheduler::new(
+            PathGenerator::from_dependency_graph(time, &mut look, None),
+            Graph::new(num, &space, None),
+        );
+        let expected = scheduler.clone().pareto_front();
+
+        for capacity in [0, 3, 1000] {
+            let mut table = TranspositionTable::new(capacity);
+            let front = scheduler.clone().memoized_pareto_front(&mut table);
+            assert_eq!(points(&front), points(&expected), "{capacity}");
+            for entry in front.entries() {
+                let mut graph = Graph::new(num, &space, None);
+                for step in entry.path.iter() {
+                    graph.update(step).unwrap();
+                }
+                assert_eq!(graph.max_memory(), entry.memory);
+                assert_eq!(entry.path.len(), entry.time);
+            }
+            assert!(table.len() <= capacity);
+            if capacity == 1000 {
+                assert!(table.hits() > 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*!
+Sweep through the [Scheduler] tree with multiple threads, using [rayon].
+
+Instead of precomputing all instructions and splitting them up front, as
+`time::split_instructions` does, the tree is split while it is explored: the
+children of the nodes up to a given depth are handed out lazily to idle threads via
+[par_bridge](ParallelBridge::par_bridge), i.e., a child is only created when a thread
+is ready to take it, and not all children of a (possibly very wide) node are held at
+once. Below that depth, each subtree is swept sequentially. Every task collects its
+own [ParetoFront], and the fronts are merged when the tasks are done.
+*/
+
+use rayon::iter::{
+    ParallelBridge,
+    ParallelIterator,
+};
+
+use super::{
+    pareto::{
+        ParetoFront,
+        Path,
+    },
+    sweep_into,
+    tree::FocusIterator,
+    Scheduler,
+};
+
+impl Scheduler<'_> {
+    /// Like [pareto_front](Scheduler::pareto_front), but sweep in parallel through the
+    /// subtrees below the depth `split_depth`, cf. the [module](self) documentation.
+    ///
+    /// A `split_depth` of 0 is a sequential sweep. Higher values create more, but
+    /// smaller, tasks; since the number of nodes grows exponentially with the depth, a
+    /// small value, e.g., 2 or 3, is usually enough to keep all threads busy.
+    ///
+    /// The resulting front is the same as in the sequential sweep, except that, if
+    /// multiple paths have the same time and memory, it is not specified which path is
+    /// kept.
+    pub fn par_pareto_front(self, split_depth: usize) -> ParetoFront {
+        metric!(time(Sweep));
+        split(self, Vec::new(), split_depth)
+    }
+}
+
+fn split(mut scheduler: Scheduler<'_>, mut path: Path, depth: usize) -> ParetoFront {
+    let mut front = ParetoFront::new();
+    if depth == 0 {
+        sweep_into(scheduler, &mut path, &mut front);
+        return front;
+    }
+    if let Some(memory) = scheduler.at_leaf() {
+        front.insert(path.len(), memory, path);
+        return front;
+    }
+    std::iter::from_fn(|| scheduler.next_and_focus())
+        .map(|(child, mess)| {
+            let mut path = path.clone();
+            path.push(mess);
+            (child, path)
+        })
+        .par_bridge()
+        .map(|(child, path)| split(child, path, depth - 1))
+        .reduce(ParetoFront::new, |mut front, other| {
+            front.merge(other);
+            front
+        })
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::analyse::schedule::{
+        space::Graph,
+        time::{
+            LookupBuffer,
+            PathGenerator,
+        },
+    };
+
+    #[test]
+    fn compare_with_sequential() {
+        let space = vec![(0, 1), (1, 2), (1, 3), (2, 4), (4, 3), (5, 0), (5, 4)];
+        let time = vec![
+            vec![(0, vec![]), (2, vec![]), (5, vec![])],
+            vec![(3, vec![0]), (1, vec![0, 2])],
+            vec![(4, vec![0, 3])],
+        ];
+        let mut look = LookupBuffer::new(6);
+        let time = PathGenerator::from_dependency_graph(time, &mut look, None);
+        let space = Graph::new(6, &space, None);
+
+        let points = |front: ParetoFront| {
+            front
+                .into_entries()
+                .into_iter()
+                .map(|entry| (entry.time, entry.memory))
+                .collect::<Vec<_>>()
+        };
+
+        let expected = Scheduler::new(time.clone(), space.clone()).pareto_front();
+        assert!(!expected.is_empty());
+        for entry in expected.entries() {
+            assert_eq!(entry.path.len(), entry.time);
+            assert_eq!(entry.path.iter().map(Vec::len).sum::<usize>(), 6);
+        }
+        for depth in 0..5 {
+            let front =
+                Scheduler::new(time.clone(), space.clone()).par_pareto_front(depth);
+            assert_eq!(points(front), points(expected.clone()), "{depth}");
+        }
+    }
+}
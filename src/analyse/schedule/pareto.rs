@@ -0,0 +1,130 @@
+/*!
+A Pareto front of schedules with respect to their time steps and their required memory.
+*/
+
+/// A path through the [Scheduler](super::Scheduler) tree, i.e., the sets of qubits that
+/// are measured in the time steps.
+pub type Path = Vec<Vec<usize>>;
+
+/// A point on the [ParetoFront]: a path with its number of time steps and its maximum
+/// memory.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Entry {
+    pub time: usize,
+    pub memory: usize,
+    pub path: Path,
+}
+
+/// The schedules that are not dominated by another schedule, i.e., for which no other
+/// schedule needs less or equal time steps *and* less or equal memory (while not being
+/// equal in both).
+///
+/// The entries are sorted by increasing time and, therefore, strictly decreasing
+/// memory. For each point on the front, only the first path that is inserted is kept.
+#[derive(Debug, Clone, PartialEq, Eq, Default)]
+pub struct ParetoFront {
+    entries: Vec<Entry>,
+}
+
+impl ParetoFront {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    pub fn entries(&self) -> &[Entry] {
+        &self.entries
+    }
+
+    pub fn into_entries(self) -> Vec<Entry> {
+        self.entries
+    }
+
+    /// The minimum memory of the schedules with at most `time` steps, if there are any.
+    pub fn best_memory(&self, time: usize) -> Option<usize> {
+        let idx = self.entries.partition_point(|entry| entry.time <= time);
+        idx.checked_sub(1).map(|idx| self.entries[idx].memory)
+    }
+
+    /// Check whether a schedule with `time` steps and `memory` would not be inserted,
+    /// because it is dominated by (or equal to) an entry.
+    pub fn is_dominated(&self, time: usize, memory: usize) -> bool {
+        self.best_memory(time).map_or(false, |best| best <= memory)
+    }
+
+    /// Insert the schedule if it is not [dominated](Self::is_dominated), removing all
+    /// entries that it dominates. `path` is only called if the schedule is inserted.
+    /// Returns whether the schedule has been inserted.
+    pub fn insert_with(
+        &mut self,
+        time: usize,
+        memory: usize,
+        path: impl FnOnce() -> Path,
+    ) -> bool {
+        if self.is_dominated(time, memory) {
+            return false;
+        }
+        let start = self.entries.partition_point(|entry| entry.time < time);
+        let end = start
+            + self.entries[start..].partition_point(|entry| entry.memory >= memory);
+        self.entries
+            .splice(start..end, [Entry { time, memory, path: path() }]);
+        true
+    }
+
+    /// Like [insert_with](Self::insert_with), but with the `path` directly.
+    pub fn insert(&mut self, time: usize, memory: usize, path: Path) -> bool {
+        self.insert_with(time, memory, || path)
+    }
+
+    /// Merge the `other` front into this one.
+    pub fn merge(&mut self, other: ParetoFront) {
+        for Entry { time, memory, path } in other.entries {
+            self.insert(time, memory, path);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn points(front: &ParetoFront) -> Vec<(usize, usize)> {
+        front
+            .entries()
+            .iter()
+            .map(|entry| (entry.time, entry.memory))
+            .collect()
+    }
+
+    #[test]
+    fn insert_and_merge() {
+        let mut front = ParetoFront::new();
+        assert!(front.insert(3, 5, vec![vec![0]]));
+        assert!(!front.insert(3, 5, vec![vec![1]]));
+        assert!(!front.insert(4, 6, vec![]));
+        assert!(front.insert(5, 2, vec![]));
+        assert!(front.insert(4, 3, vec![]));
+        assert_eq!(points(&front), vec![(3, 5), (4, 3), (5, 2)]);
+        assert_eq!(front.entries()[0].path, vec![vec![0]]);
+        assert_eq!(front.best_memory(2), None);
+        assert_eq!(front.best_memory(4), Some(3));
+        assert_eq!(front.best_memory(9), Some(2));
+
+        let mut other = ParetoFront::new();
+        other.insert(2, 6, vec![]);
+        other.insert(3, 2, vec![]);
+        front.merge(other);
+        assert_eq!(points(&front), vec![(2, 6), (3, 2)]);
+    }
+}
@@ -6,7 +6,9 @@ use std::{
     collections::HashMap,
     error::Error,
     fmt::Display,
+    iter,
     mem,
+    sync::Arc,
 };
 
 #[cfg(feature = "serde")]
@@ -20,9 +22,6 @@ use super::{
     tree::Focus,
 };
 
-type Node = (State, Vec<usize>);
-type Nodes = Vec<Node>;
-
 #[derive(Copy, Clone, PartialEq, Eq, PartialOrd, Ord, Hash, Default, Debug)]
 #[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
 pub enum State {
@@ -32,44 +31,97 @@ pub enum State {
     Measured,
 }
 
+const WORD_BITS: usize = u64::BITS as usize;
+
+// the neighbors of bit i are neighbors[offsets[i]..offsets[i + 1]] (compressed sparse
+// row format)
+#[derive(Clone, PartialEq, Eq, Default, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+struct Adjacency {
+    offsets: Vec<usize>,
+    neighbors: Vec<usize>,
+}
+
+impl Adjacency {
+    #[inline]
+    fn neighbors(&self, bit: usize) -> &[usize] {
+        &self.neighbors[self.offsets[bit]..self.offsets[bit + 1]]
+    }
+}
+
+/// The space graph: which bits are initialized and which are measured.
+///
+/// The edges are stored once, in a compressed sparse row format, and are shared
+/// between all clones of the graph, while the states of the bits are stored in bitsets.
+/// Therefore, cloning a graph, e.g., when [focus](Focus::focus)ing, only copies a few
+/// words per 64 bits.
 #[derive(Clone, PartialEq, Eq, Default, Debug)]
 #[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
 pub struct Graph {
-    space: Nodes,
+    adjacency: Arc<Adjacency>,
+    // the measured bits are also initialized
+    initialized: Vec<u64>,
+    measured: Vec<u64>,
     current_memory: usize,
     max_memory: usize,
 }
 
+#[inline]
+fn get(set: &[u64], bit: usize) -> bool {
+    (set[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1 == 1
+}
+
+#[inline]
+fn set(set: &mut [u64], bit: usize) {
+    set[bit / WORD_BITS] |= 1 << (bit % WORD_BITS);
+}
+
 impl Graph {
+    /// Create the graph, mapping the bits in the `edges` with `bit_mapping`, if it is
+    /// given. Loops are ignored.
+    ///
+    /// # Panics
+    /// Panics if a (mapped) bit is not smaller than `num_bits` or if a bit is not in
+    /// the `bit_mapping`.
     pub fn new(
         num_bits: usize,
         edges: &[(usize, usize)],
         bit_mapping: Option<&HashMap<usize, usize>>,
     ) -> Self {
-        let mut nodes = vec![Node::default(); num_bits];
-
-        if let Some(bit_mapping) = bit_mapping {
-            run(
-                edges.iter().map(|(left, right)| {
+        // renumber the bits only once
+        let edges: Vec<(usize, usize)> = edges
+            .iter()
+            .map(|(left, right)| match bit_mapping {
+                Some(bit_mapping) => {
                     (*update!(left, bit_mapping), *update!(right, bit_mapping))
-                }),
-                &mut nodes,
-            )
-        } else {
-            run(edges.iter().copied(), &mut nodes);
-        };
-        fn run<T: Iterator<Item = (usize, usize)>>(edges: T, nodes: &mut Nodes) {
-            for (left, right) in edges {
-                if left == right {
-                    continue;
                 }
-                nodes[left].1.push(right);
-                nodes[right].1.push(left);
-            }
+                None => (*left, *right),
+            })
+            .filter(|(left, right)| left != right)
+            .collect();
+
+        let mut offsets = vec![0; num_bits + 1];
+        for (left, right) in edges.iter() {
+            offsets[left + 1] += 1;
+            offsets[right + 1] += 1;
+        }
+        for bit in 0..num_bits {
+            offsets[bit + 1] += offsets[bit];
+        }
+        let mut fill = offsets.clone();
+        let mut neighbors = vec![0; offsets[num_bits]];
+        for (left, right) in edges {
+            neighbors[fill[left]] = right;
+            fill[left] += 1;
+            neighbors[fill[right]] = left;
+            fill[right] += 1;
         }
 
+        let words = (num_bits + WORD_BITS - 1) / WORD_BITS;
         Self {
-            space: nodes,
+            adjacency: Arc::new(Adjacency { offsets, neighbors }),
+            initialized: vec![0; words],
+            measured: vec![0; words],
             current_memory: 0,
             max_memory: 0,
         }
@@ -90,43 +142,84 @@ impl Graph {
         self.max_memory
     }
 
+    pub fn current_memory(&self) -> usize {
+        self.current_memory
+    }
+
+    /// The number of bits in the graph.
+    pub fn len(&self) -> usize {
+        self.adjacency.offsets.len() - 1
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// The state of `bit`.
+    ///
+    /// # Panics
+    /// Panics if `bit` is not in the graph.
+    pub fn state(&self, bit: usize) -> State {
+        match (get(&self.initialized, bit), get(&self.measured, bit)) {
+            (_, true) => State::Measured,
+            (true, false) => State::InMemory,
+            (false, false) => State::Sleeping,
+        }
+    }
+
+    /// Forget the maximum memory of the past, i.e., set it to the current memory.
+    pub(crate) fn reset_max_memory(&mut self) {
+        self.max_memory = self.current_memory;
+    }
+
+    /// The bitsets of the initialized and the measured bits, as one key. The future of
+    /// the graph is fully determined by this key (and the
+    /// [max_memory](Self::max_memory)).
+    pub(crate) fn state_key(&self) -> Vec<u64> {
+        let mut key = Vec::with_capacity(2 * self.initialized.len());
+        key.extend_from_slice(&self.initialized);
+        key.extend_from_slice(&self.measured);
+        key
+    }
+
+    /// Iterate over the bits that would be newly initialized when measuring `bit`, i.e.,
+    /// `bit` itself and its neighbors, if they are still sleeping.
+    pub fn newly_initialized(&self, bit: usize) -> impl Iterator<Item = usize> + '_ {
+        iter::once(bit)
+            .chain(self.adjacency.neighbors(bit).iter().copied())
+            .filter(|bit| !get(&self.initialized, *bit))
+    }
+
     fn initialize(&mut self, bit: usize) -> Result<(), AlreadyMeasured> {
-        match &mut self.space[bit].0 {
-            state @ State::Sleeping => {
-                *state = State::InMemory;
-                self.current_memory += 1;
-            }
-            State::InMemory => (),
-            State::Measured => {
-                return Err(AlreadyMeasured {
-                    bit,
-                    operation: Operation::Initialize,
-                });
-            }
+        if get(&self.measured, bit) {
+            return Err(AlreadyMeasured {
+                bit,
+                operation: Operation::Initialize,
+            });
+        }
+        if !get(&self.initialized, bit) {
+            set(&mut self.initialized, bit);
+            self.current_memory += 1;
         }
         Ok(())
     }
 
     fn measure(&mut self, bit: usize) -> Result<(), AlreadyMeasured> {
-        let neighbors = mem::take(&mut self.space[bit].1);
-        for neighbor in neighbors.iter() {
+        let adjacency = Arc::clone(&self.adjacency);
+        for neighbor in adjacency.neighbors(bit) {
             let _ = self.initialize(*neighbor); // Err is okay
         }
-        let node = &mut self.space[bit];
-        let _ = mem::replace(&mut node.1, neighbors);
-        match node.0 {
-            State::Sleeping => {
-                self.current_memory += 1;
-                node.0 = State::Measured;
-            }
-            State::InMemory => node.0 = State::Measured,
-            State::Measured => {
-                return Err(AlreadyMeasured {
-                    bit,
-                    operation: Operation::Measure,
-                });
-            }
+        if get(&self.measured, bit) {
+            return Err(AlreadyMeasured {
+                bit,
+                operation: Operation::Measure,
+            });
+        }
+        if !get(&self.initialized, bit) {
+            set(&mut self.initialized, bit);
+            self.current_memory += 1;
         }
+        set(&mut self.measured, bit);
         Ok(())
     }
 }
@@ -272,6 +365,49 @@ mod tests {
         }
     }
 
+    #[test]
+    fn states() {
+        let bit_mapping = HashMap::from([(10, 0), (11, 1), (12, 2), (13, 3)]);
+        let mut graph = Graph::new(
+            4,
+            &[(10, 11), (11, 11), (11, 12), (12, 10)],
+            Some(&bit_mapping),
+        );
+        assert_eq!(graph.len(), 4);
+        assert_eq!(graph.newly_initialized(1).collect::<Vec<_>>(), vec![1, 0, 2]);
+
+        let mut focused = graph.focus(&[0][..]).unwrap();
+        assert_eq!(graph.state(0), State::Sleeping);
+        assert_eq!(
+            [0, 1, 2, 3].map(|bit| focused.state(bit)),
+            [State::Measured, State::InMemory, State::InMemory, State::Sleeping]
+        );
+        assert_eq!((focused.current_memory(), focused.max_memory()), (2, 3));
+        assert_eq!(focused.newly_initialized(1).count(), 0);
+        assert_ne!(focused.state_key(), graph.state_key());
+
+        assert!(matches!(
+            focused.update(&[1, 0]),
+            Err(AlreadyMeasured {
+                bit: 0,
+                operation: Operation::Measure
+            })
+        ));
+        graph.update(&[0, 1, 2]).unwrap();
+        assert!(graph.initialize(1).is_err());
+        graph.update(&[3]).unwrap();
+        assert_eq!((graph.current_memory(), graph.max_memory()), (0, 3));
+
+        // more than one word
+        let edges: Vec<_> = (1..150).map(|i| (i - 1, i)).collect();
+        let mut graph = Graph::new(150, &edges, None);
+        graph.update(&[64, 130]).unwrap();
+        assert_eq!(graph.state(63), State::InMemory);
+        assert_eq!(graph.state(130), State::Measured);
+        assert_eq!(graph.state(132), State::Sleeping);
+        assert_eq!(graph.max_memory(), 6);
+    }
+
     // #[test]
     // fn bar() {
     //     let deps = Deps::from([(0, vec![]), (1, vec![]), (2, vec![0, 1])]);
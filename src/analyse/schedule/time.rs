@@ -14,12 +14,16 @@ use super::tree::{
     Focus,
     FocusIterator,
 };
-use crate::analyse::{
-    combinatoric::Partition,
-    DependencyGraph,
+pub use crate::analyse::combinatoric::SubsetOrder;
+use crate::{
+    analyse::{
+        combinatoric::Partition,
+        DependencyGraph,
+    },
+    collection::IntMap,
 };
 
-type Deps = HashMap<usize, Vec<usize>>;
+type Deps = IntMap<usize, Vec<usize>>;
 type Look = Vec<Vec<usize>>;
 
 pub struct LookupBuffer {
@@ -34,11 +38,11 @@ impl LookupBuffer {
 #[derive(Debug, Clone)]
 pub struct PathGenerator<'l> {
     // one could also put the dependents with the bit into the partition set and in deps
-    // have vaules of the form (dependents, dependencies), however, the Partition clones
-    // the set multiple times, therefore we don't want the dependents in there (also it
-    // makes the from(DependencyGraph) function and the step function simpler if it is
-    // separated)
-    known: Partition<Vec<usize>>,
+    // have vaules of the form (dependents, dependencies), however, the Partition copies
+    // the set elements for every subset, therefore we don't want the dependents in there
+    // (also it makes the from(DependencyGraph) function and the step function simpler
+    // if it is separated)
+    known: Partition<usize>,
     deps: Deps,
     // it would have been slighty more ergnomic to use use an Rc instead of a reference
     // (no need to keep the actual map in an extra variable), however, this would have
@@ -50,6 +54,7 @@ pub struct PathGenerator<'l> {
     // cause a slight overhead, and also we have the additional time and space overhead
     // when cloning it
     look: &'l Look,
+    order: SubsetOrder,
 }
 
 impl<'l> PathGenerator<'l> {
@@ -65,6 +70,7 @@ impl<'l> PathGenerator<'l> {
                 known: Partition::default(),
                 deps: Deps::default(),
                 look,
+                order: SubsetOrder::default(),
             };
         }
 
@@ -92,7 +98,7 @@ impl<'l> PathGenerator<'l> {
         }
 
         let mut known = Vec::new();
-        let mut deps = HashMap::new();
+        let mut deps = Deps::default();
 
         let mut graph_iter = graph.into_iter();
 
@@ -111,33 +117,92 @@ impl<'l> PathGenerator<'l> {
             }
         }
 
-        let known = Self::new_partition(known);
-        Self { known, deps, look }
+        let order = SubsetOrder::default();
+        let known = Partition::non_empty(known, order);
+        Self { known, deps, look, order }
+    }
+
+    /// Set the order in which the sets of measured bits are tried in each step, e.g.,
+    /// [SubsetOrder::LargestFirst] to try large measurement layers first; the default
+    /// is [SubsetOrder::SmallestFirst]. This restarts the iteration over the measurable
+    /// sets of the current step.
+    pub fn with_subset_order(mut self, order: SubsetOrder) -> Self {
+        self.order = order;
+        self.known = Partition::non_empty(mem::take(&mut self.known.set), order);
+        self
     }
 
     pub fn finished_path(&self) -> bool {
         self.known.set.is_empty()
     }
 
-    fn new(first: Partition<Vec<usize>>, deps: Deps, look: &'l Look) -> Self {
-        Self { known: first, deps, look }
+    /// For each bit, the number of bits in the longest chain of dependents starting at
+    /// the bit (including the bit itself); this is the minimum number of steps needed
+    /// to measure the bit and everything that depends on it.
+    pub fn chain_heights(&self) -> Vec<usize> {
+        // sort the bits topologically (Kahn's algorithm) and go backwards, so that the
+        // heights of the dependents are known; no recursion, since the chains may be
+        // long
+        let mut open = vec![0; self.look.len()];
+        for dependent in self.look.iter().flatten() {
+            open[*dependent] += 1;
+        }
+        let mut order = (0..self.look.len())
+            .filter(|bit| open[*bit] == 0)
+            .collect::<Vec<_>>();
+        let mut next = 0;
+        while let Some(bit) = order.get(next).copied() {
+            next += 1;
+            for dependent in self.look[bit].iter() {
+                open[*dependent] -= 1;
+                if open[*dependent] == 0 {
+                    order.push(*dependent);
+                }
+            }
+        }
+        let mut heights = vec![0; self.look.len()];
+        for bit in order.into_iter().rev() {
+            heights[bit] =
+                1 + self.look[bit].iter().map(|d| heights[*d]).max().unwrap_or(0);
+        }
+        heights
     }
 
-    fn new_partition(a: Vec<usize>) -> Partition<Vec<usize>> {
-        let first_len = a.len();
-        let mut first = Partition::new(a, first_len);
-        first.next();
-        first
+    /// A lower bound for the number of steps that are still needed to finish the path,
+    /// given the [chain_heights](Self::chain_heights).
+    pub fn min_remaining_steps(&self, heights: &[usize]) -> usize {
+        self.known.set.iter().map(|bit| heights[*bit]).max().unwrap_or(0)
+    }
+
+    fn new(
+        first: Partition<usize>,
+        deps: Deps,
+        look: &'l Look,
+        order: SubsetOrder,
+    ) -> Self {
+        Self { known: first, deps, look, order }
     }
 
     fn focus_unchecked(
         &mut self,
         measuring: &[usize],
+        first: Vec<usize>,
+    ) -> Result<Self, TimeOrderingViolation> {
+        Self::focus_parts(&self.deps, self.look, self.order, measuring, first)
+    }
+
+    // focus_unchecked, but without borrowing self.known, so that the partition can be
+    // borrowed from it
+    fn focus_parts(
+        deps: &Deps,
+        look: &'l Look,
+        order: SubsetOrder,
+        measuring: &[usize],
         mut first: Vec<usize>,
     ) -> Result<Self, TimeOrderingViolation> {
-        let mut deps = self.deps.clone();
+        let mut deps = deps.clone();
         for known in measuring.iter() {
-            let dependents = &self.look[*known];
+            let dependents = &look[*known];
             for bit in dependents {
                 let dependencies = match deps.get_mut(bit) {
                     Some(s) => s,
@@ -159,7 +224,7 @@ impl<'l> PathGenerator<'l> {
                 }
             }
         }
-        Ok(Self::new(Self::new_partition(first), deps, self.look))
+        Ok(Self::new(Partition::non_empty(first, order), deps, look, order))
     }
 }
 
@@ -193,18 +258,27 @@ impl FocusIterator for PathGenerator<'_> {
     where
         Self: Sized,
     {
-        let (measuring, new_measureable_set) = self.known.next()?;
-        Some((
-            // we know that the input is fine, because it comes from self.known.next()
-            self.focus_unchecked(&measuring, new_measureable_set).expect(
-                "bug: the only way to change self in the API is through this function \
-                 here (the pointee behind self.look is already through the borrow \
-                 checker system locked since we take a mut ref to when creating a \
-                 TimeOrdering in from_dependency_graph, and additionally through the \
-                 type system ), so we know that all should be fine",
-            ),
-            measuring,
-        ))
+        let (look, order) = (self.look, self.order);
+        let (measuring, complement) = self.known.next_borrowed()?;
+        // the new measurable set is the complement plus the bits that only depend on
+        // the measured bits, so we allocate it only once with enough capacity
+        let capacity = complement.len()
+            + measuring.iter().map(|bit| look[*bit].len()).sum::<usize>();
+        let mut new_measureable_set = Vec::with_capacity(capacity);
+        new_measureable_set.extend_from_slice(complement);
+        let measuring = measuring.to_vec();
+        // we know that the input is fine, because it comes from self.known
+        let focused =
+            Self::focus_parts(&self.deps, look, order, &measuring, new_measureable_set)
+                .expect(
+                    "bug: the only way to change self in the API is through this \
+                     function here (the pointee behind self.look is already through \
+                     the borrow checker system locked since we take a mut ref to when \
+                     creating a TimeOrdering in from_dependency_graph, and \
+                     additionally through the type system ), so we know that all \
+                     should be fine",
+                );
+        Some((focused, measuring))
     }
 
     fn at_leaf(&self) -> Option<Self::LeafItem> {
@@ -329,6 +403,47 @@ mod tests {
         println!("{:?}", graph);
     }
 
+    #[test]
+    fn long_chain_heights() {
+        // long enough to overflow the stack with a recursion per link
+        // (from_dependency_graph is too slow for that)
+        let len = 200_000;
+        let look = (0..len)
+            .map(|bit| if bit + 1 < len { vec![bit + 1] } else { vec![] })
+            .collect::<Look>();
+        let order = SubsetOrder::default();
+        let graph = PathGenerator::new(
+            Partition::non_empty(vec![0], order),
+            Deps::default(),
+            &look,
+            order,
+        );
+        let heights = graph.chain_heights();
+        assert_eq!(heights.len(), len);
+        assert!(heights.iter().rev().copied().eq(1..=len));
+        assert_eq!(graph.min_remaining_steps(&heights), len);
+    }
+
+    #[test]
+    fn many_measurable_bits() {
+        // more initially measurable bits than fit into a subset mask
+        let len = 70;
+        let time = vec![
+            (0..len).map(|bit| (bit, vec![])).collect(),
+            vec![(len, (0..len).collect())],
+        ];
+        let mut look = LookupBuffer::new(len + 1);
+        let mut graph = PathGenerator::from_dependency_graph(time, &mut look, None)
+            .with_subset_order(SubsetOrder::LargestFirst);
+        let (mut all, measuring) = graph.next_and_focus().unwrap();
+        assert_eq!(measuring.len(), len);
+        assert_eq!(all.known.set, vec![len]);
+        let (last, _) = all.next_and_focus().unwrap();
+        assert!(last.at_leaf().is_some());
+        let (rest, measuring) = graph.next_and_focus().unwrap();
+        assert_eq!((measuring.len(), rest.known.set.len()), (len - 1, 1));
+    }
+
     #[test]
     fn invert_graph() {
         let time = vec![
@@ -384,13 +499,3 @@ mod tests {
         // println!("{:?}", instructions);
     }
 }
-
-// currently, when looping through the partitions in next_and_focus, we do
-// let (measuring, new_measureable_set) = self.known.next()?;
-// if we want to swap the order, we have to do
-// let (mut new_measureable_set, measuring) = self.first.next()?;
-// if measuring.is_empty() {
-//     return None;
-// }
-// and in new_partition we have to comment
-// first.next();
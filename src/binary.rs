@@ -0,0 +1,704 @@
+/*!
+A compact, versioned binary format for the [StackStorage]s and the
+[DependencyGraph](crate::analyse::DependencyGraph).
+
+In contrast to the (feature gated) serde implementations, which serialize the
+[BooleanVector]s element-wise, this format dumps the bits of the
+[left](PauliVec::left) and [right](PauliVec::right) vectors as raw little endian [u64]
+words (least significant bit first). Optionally, runs of zero words are compressed
+(cf. [Compression]), which pays off for the typically very sparse Pauli stacks.
+
+Use [write_storage] and [read_storage] to (de)serialize whole storages, or
+[StorageView] to access the stacks in a buffer without decoding everything.
+
+# Format
+Every number is a little endian u64, except for the header fields noted below, so
+that all records are 8 byte aligned:
+- header (32 bytes): the magic bytes `PTBINARY`, the version (u32), the kind (u32; 1 =
+  storage, 2 = dependency graph), the flags (u32; bit 0 = zero-run compression), 4
+  reserved bytes and the number of elements (u64), i.e., stacks or layers
+- storage: for each stack the qubit, the lengths of left and right and then the two
+  words blocks; an uncompressed block consists of ⌈len / 64⌉ words, a compressed block
+  starts with the number of the following tokens, which are repetitions of (number of
+  zero words, number n of literal words, n literal words)
+- dependency graph: for each layer the number of nodes and then for each node the
+  qubit, the number of dependencies and the dependencies
+
+# Examples
+```
+# #[cfg_attr(coverage_nightly, no_coverage)]
+# fn main() {
+use pauli_tracker::{
+    binary::{
+        self,
+        Compression,
+        StorageView,
+    },
+    boolean_vector::packed::PackedBitVec,
+    pauli::PauliVec,
+    tracker::frames::storage::{
+        self,
+        Map,
+    },
+};
+let mut map = Map::<PackedBitVec>::default();
+map.insert(3, PauliVec::try_from_str("1000000", "0000001").unwrap());
+map.insert(1, PauliVec::try_from_str("", "1").unwrap());
+
+let mut buf = Vec::new();
+binary::write_storage(&map, Compression::ZeroRuns, &mut buf).unwrap();
+
+let view = StorageView::new(&buf).unwrap();
+assert_eq!(view.len(), 2);
+let stack = view.iter().find(|stack| stack.bit() == 3).unwrap();
+assert_eq!(stack.left().len(), 7);
+assert_eq!(stack.left().words().collect::<Vec<_>>(), vec![0b1]);
+
+let read: Map<PackedBitVec> = binary::read_storage(&mut buf.as_slice()).unwrap();
+assert_eq!(storage::into_sorted_by_bit(read), storage::into_sorted_by_bit(map));
+# }
+```
+*/
+
+use std::{
+    cmp::Ordering,
+    io::{
+        self,
+        Read,
+        Write,
+    },
+};
+
+#[cfg(feature = "analyse")]
+use crate::analyse::DependencyGraph;
+use crate::{
+    boolean_vector::BooleanVector,
+    pauli::PauliVec,
+    tracker::frames::storage::StackStorage,
+};
+
+const MAGIC: &[u8; 8] = b"PTBINARY";
+/// The version of the binary format that is written by this version of the library.
+pub const VERSION: u32 = 1;
+const HEADER_LEN: usize = 32;
+const STORAGE: u32 = 1;
+#[cfg(feature = "analyse")]
+const GRAPH: u32 = 2;
+const ZERO_RUNS: u32 = 1;
+
+/// The compression of the words of the [BooleanVector]s.
+#[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Default, Debug)]
+pub enum Compression {
+    /// Store every word.
+    #[default]
+    None,
+    /// Encode runs of zero words by their length.
+    ZeroRuns,
+}
+
+fn invalid_data(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.to_string())
+}
+
+// doesn't overflow, since the length may come from untrusted data
+#[inline]
+pub(crate) fn num_words(len: usize) -> usize {
+    len / 64 + usize::from(len % 64 != 0)
+}
+
+/// Build a boolean vector of length `len` from its `words`, cf.
+/// [BooleanVector::to_words].
+pub(crate) fn from_words<B: BooleanVector>(
+    words: impl IntoIterator<Item = u64>,
+    len: usize,
+) -> io::Result<B> {
+    let mut ret = B::new();
+    let mut words = words.into_iter();
+    let mut remaining = len;
+    while remaining > 0 {
+        let num = remaining.min(64);
+        let word = words.next().ok_or_else(|| invalid_data("missing words"))?;
+        ret.extend_from_word(word, num);
+        remaining -= num;
+    }
+    Ok(ret)
+}
+
+fn write_u64(writer: &mut impl Write, value: u64) -> io::Result<()> {
+    writer.write_all(&value.to_le_bytes())
+}
+
+fn read_u64(reader: &mut impl Read) -> io::Result<u64> {
+    let mut bytes = [0; 8];
+    reader.read_exact(&mut bytes)?;
+    Ok(u64::from_le_bytes(bytes))
+}
+
+fn write_header(
+    writer: &mut impl Write,
+    kind: u32,
+    flags: u32,
+    len: usize,
+) -> io::Result<()> {
+    let mut header = [0; HEADER_LEN];
+    header[..8].copy_from_slice(MAGIC);
+    header[8..12].copy_from_slice(&VERSION.to_le_bytes());
+    header[12..16].copy_from_slice(&kind.to_le_bytes());
+    header[16..20].copy_from_slice(&flags.to_le_bytes());
+    header[24..].copy_from_slice(&(len as u64).to_le_bytes());
+    writer.write_all(&header)
+}
+
+// returns (flags, len)
+fn parse_header(header: &[u8; HEADER_LEN], kind: u32) -> io::Result<(u32, usize)> {
+    let u32_at = |i: usize| u32::from_le_bytes(header[i..i + 4].try_into().unwrap());
+    if &header[..8] != MAGIC {
+        return Err(invalid_data("not a pauli_tracker binary"));
+    }
+    let version = u32_at(8);
+    if version != VERSION {
+        return Err(invalid_data(&format!("unsupported version {version}")));
+    }
+    if u32_at(12) != kind {
+        return Err(invalid_data(&format!("unexpected kind {}", u32_at(12))));
+    }
+    let flags = u32_at(16);
+    if flags & !ZERO_RUNS != 0 {
+        return Err(invalid_data(&format!("unknown flags {flags:#x}")));
+    }
+    Ok((
+        flags,
+        u64::from_le_bytes(header[24..].try_into().unwrap()) as usize,
+    ))
+}
+
+fn read_header(reader: &mut impl Read, kind: u32) -> io::Result<(u32, usize)> {
+    let mut header = [0; HEADER_LEN];
+    reader.read_exact(&mut header)?;
+    parse_header(&header, kind)
+}
+
+fn write_block<B: BooleanVector>(
+    writer: &mut impl Write,
+    vec: &B,
+    compression: Compression,
+) -> io::Result<()> {
+    match compression {
+        Compression::None => {
+            for word in vec.to_words().iter() {
+                write_u64(writer, *word)?;
+            }
+        }
+        Compression::ZeroRuns => {
+            let words = vec.to_words();
+            let mut tokens = Vec::new();
+            let mut i = 0;
+            while i < words.len() {
+                let zeros = words[i..].iter().take_while(|w| **w == 0).count();
+                i += zeros;
+                // a new token costs two words, so we keep short zero runs as literals
+                let mut end = i;
+                while end < words.len() {
+                    match words[end..].iter().take_while(|w| **w == 0).count() {
+                        0 => end += 1,
+                        run if run < 3 && end + run < words.len() => end += run,
+                        _ => break,
+                    }
+                }
+                let literals = end - i;
+                tokens.push(zeros as u64);
+                tokens.push(literals as u64);
+                tokens.extend_from_slice(&words[i..i + literals]);
+                i += literals;
+            }
+            write_u64(writer, tokens.len() as u64)?;
+            for token in tokens {
+                write_u64(writer, token)?;
+            }
+        }
+    }
+    Ok(())
+}
+
+/// Write the `storage` in the binary format into `writer`, cf. the [module](self)
+/// documentation.
+pub fn write_storage<S: StackStorage>(
+    storage: &S,
+    compression: Compression,
+    writer: &mut impl Write,
+) -> io::Result<()> {
+    let flags = match compression {
+        Compression::None => 0,
+        Compression::ZeroRuns => ZERO_RUNS,
+    };
+    write_header(writer, STORAGE, flags, storage.iter().count())?;
+    for (bit, stack) in storage.iter() {
+        write_u64(writer, bit as u64)?;
+        write_u64(writer, stack.left.len() as u64)?;
+        write_u64(writer, stack.right.len() as u64)?;
+        write_block(writer, &stack.left, compression)?;
+        write_block(writer, &stack.right, compression)?;
+    }
+    Ok(())
+}
+
+/// Read a storage, written with [write_storage], from `reader`. Errors with
+/// [InvalidData](io::ErrorKind::InvalidData) if the data is not a valid storage.
+///
+/// For data in memory, [StorageView] is more efficient if not all stacks are needed.
+pub fn read_storage<S: StackStorage>(reader: &mut impl Read) -> io::Result<S> {
+    let mut data = Vec::new();
+    reader.read_to_end(&mut data)?;
+    let view = StorageView::new(&data)?;
+    view.iter()
+        .map(|stack| Ok((stack.bit(), stack.to_pauli_vec()?)))
+        .collect()
+}
+
+/// A validated view into a buffer that contains a storage written with [write_storage].
+///
+/// Creating the view walks once through the buffer to check it and to index the
+/// stacks, but the words are only decoded when they are accessed.
+#[derive(Clone, Debug)]
+pub struct StorageView<'l> {
+    // the decoded heads of the stacks
+    stacks: Vec<StackView<'l>>,
+}
+
+/// A view to one stack in a [StorageView].
+#[derive(Clone, Copy, Debug)]
+pub struct StackView<'l> {
+    bit: usize,
+    left: BitsView<'l>,
+    right: BitsView<'l>,
+}
+
+/// A view to one boolean vector in a [StorageView].
+#[derive(Clone, Copy, Debug)]
+pub struct BitsView<'l> {
+    len: usize,
+    compression: Compression,
+    // the (compressed) words, without the token count
+    data: &'l [u8],
+}
+
+/// An iterator over the words of a [BitsView].
+#[derive(Clone, Debug)]
+pub struct Words<'l> {
+    data: &'l [u8],
+    compression: Compression,
+    remaining: usize,
+    zeros: u64,
+    literals: u64,
+}
+
+// a bounds checked cursor over data
+struct Cursor<'l> {
+    data: &'l [u8],
+    pos: usize,
+}
+
+impl<'l> Cursor<'l> {
+    fn u64(&mut self) -> io::Result<u64> {
+        let bytes = self
+            .data
+            .get(self.pos..self.pos + 8)
+            .ok_or_else(|| invalid_data("unexpected end of data"))?;
+        self.pos += 8;
+        Ok(u64::from_le_bytes(bytes.try_into().unwrap()))
+    }
+
+    fn usize(&mut self) -> io::Result<usize> {
+        self.u64()?
+            .try_into()
+            .map_err(|_| invalid_data("number too large for usize"))
+    }
+
+    fn skip_words(&mut self, num: usize) -> io::Result<&'l [u8]> {
+        let end = num
+            .checked_mul(8)
+            .and_then(|len| len.checked_add(self.pos))
+            .filter(|end| *end <= self.data.len())
+            .ok_or_else(|| invalid_data("unexpected end of data"))?;
+        let ret = &self.data[self.pos..end];
+        self.pos = end;
+        Ok(ret)
+    }
+
+    fn bits(
+        &mut self,
+        len: usize,
+        compression: Compression,
+    ) -> io::Result<BitsView<'l>> {
+        let data = match compression {
+            Compression::None => self.skip_words(num_words(len))?,
+            Compression::ZeroRuns => {
+                let tokens = self.usize()?;
+                let data = self.skip_words(tokens)?;
+                // check that the tokens really describe len bits; we sum up the counts
+                // instead of walking through the words, since they may be bogus
+                let mut tokens = Cursor { data, pos: 0 };
+                let mut num = 0usize;
+                while tokens.pos < data.len() {
+                    let zeros = tokens.usize()?;
+                    let literals = tokens.usize()?;
+                    tokens.skip_words(literals)?;
+                    num = num
+                        .checked_add(zeros)
+                        .and_then(|num| num.checked_add(literals))
+                        .ok_or_else(|| invalid_data("too many words"))?;
+                }
+                match num.cmp(&num_words(len)) {
+                    Ordering::Less => return Err(invalid_data("missing words")),
+                    Ordering::Greater => return Err(invalid_data("too many words")),
+                    Ordering::Equal => {}
+                }
+                data
+            }
+        };
+        Ok(BitsView { len, compression, data })
+    }
+}
+
+impl<'l> StorageView<'l> {
+    /// Check the `data` and create a view into it. Errors with
+    /// [InvalidData](io::ErrorKind::InvalidData) if the data is not a valid storage.
+    pub fn new(data: &'l [u8]) -> io::Result<Self> {
+        let header = data
+            .get(..HEADER_LEN)
+            .ok_or_else(|| invalid_data("missing header"))?;
+        let (flags, len) = parse_header(header.try_into().unwrap(), STORAGE)?;
+        let compression = if flags & ZERO_RUNS != 0 {
+            Compression::ZeroRuns
+        } else {
+            Compression::None
+        };
+        let mut cursor = Cursor { data, pos: HEADER_LEN };
+        // the length is not trusted, but every stack needs at least 24 bytes
+        let mut stacks = Vec::with_capacity(len.min(data.len() / 24));
+        for _ in 0..len {
+            let bit = cursor.usize()?;
+            let (left, right) = (cursor.usize()?, cursor.usize()?);
+            stacks.push(StackView {
+                bit,
+                left: cursor.bits(left, compression)?,
+                right: cursor.bits(right, compression)?,
+            });
+        }
+        if cursor.pos != data.len() {
+            return Err(invalid_data("trailing data"));
+        }
+        Ok(Self { stacks })
+    }
+
+    /// Get the number of stacks.
+    pub fn len(&self) -> usize {
+        self.stacks.len()
+    }
+
+    /// Check whether there are no stacks.
+    pub fn is_empty(&self) -> bool {
+        self.stacks.is_empty()
+    }
+
+    /// Get the `idx`th stack (in the order they have been written), if present,
+    /// otherwise return [None].
+    pub fn get(&self, idx: usize) -> Option<StackView<'l>> {
+        self.stacks.get(idx).copied()
+    }
+
+    /// Iterate over all stacks.
+    pub fn iter(&self) -> impl Iterator<Item = StackView<'l>> + '_ {
+        self.stacks.iter().copied()
+    }
+}
+
+impl<'l> StackView<'l> {
+    /// Get the qubit.
+    pub fn bit(&self) -> usize {
+        self.bit
+    }
+
+    /// Get the [left](PauliVec::left) vector.
+    pub fn left(&self) -> BitsView<'l> {
+        self.left
+    }
+
+    /// Get the [right](PauliVec::right) vector.
+    pub fn right(&self) -> BitsView<'l> {
+        self.right
+    }
+
+    /// Decode the stack.
+    pub fn to_pauli_vec<B: BooleanVector>(&self) -> io::Result<PauliVec<B>> {
+        Ok(PauliVec {
+            left: self.left.to_boolean_vector()?,
+            right: self.right.to_boolean_vector()?,
+        })
+    }
+}
+
+impl<'l> BitsView<'l> {
+    /// Get the number of bits.
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Check whether there are no bits.
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Iterate over the words, cf. the [module](self) documentation.
+    pub fn words(&self) -> Words<'l> {
+        Words::new(self.data, self.compression, num_words(self.len))
+    }
+
+    /// Decode the bits.
+    pub fn to_boolean_vector<B: BooleanVector>(&self) -> io::Result<B> {
+        from_words(self.words(), self.len)
+    }
+}
+
+impl<'l> Words<'l> {
+    fn new(data: &'l [u8], compression: Compression, num: usize) -> Self {
+        Self {
+            data,
+            compression,
+            remaining: num,
+            zeros: 0,
+            literals: 0,
+        }
+    }
+
+    fn take(&mut self) -> io::Result<u64> {
+        let (word, rest) = self.data.split_at(8.min(self.data.len()));
+        if word.len() != 8 {
+            return Err(invalid_data("unexpected end of data"));
+        }
+        self.data = rest;
+        Ok(u64::from_le_bytes(word.try_into().unwrap()))
+    }
+
+    fn try_next(&mut self) -> io::Result<Option<u64>> {
+        if self.remaining == 0 {
+            return Ok(None);
+        }
+        self.remaining -= 1;
+        if let Compression::None = self.compression {
+            return self.take().map(Some);
+        }
+        while self.zeros == 0 && self.literals == 0 {
+            self.zeros = self.take()?;
+            self.literals = self.take()?;
+        }
+        if self.zeros > 0 {
+            self.zeros -= 1;
+            Ok(Some(0))
+        } else {
+            self.literals -= 1;
+            self.take().map(Some)
+        }
+    }
+}
+
+impl Iterator for Words<'_> {
+    type Item = u64;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        // the data has been checked when the StorageView was created
+        self.try_next().expect("bug: the data has been checked")
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.remaining, Some(self.remaining))
+    }
+}
+
+impl ExactSizeIterator for Words<'_> {}
+
+/// Write the dependency `graph` in the binary format into `writer`, cf. the
+/// [module](self) documentation.
+#[cfg(feature = "analyse")]
+#[cfg_attr(docsrs, doc(cfg(feature = "analyse")))]
+pub fn write_dependency_graph(
+    graph: &DependencyGraph,
+    writer: &mut impl Write,
+) -> io::Result<()> {
+    write_header(writer, GRAPH, 0, graph.len())?;
+    for layer in graph {
+        write_u64(writer, layer.len() as u64)?;
+        for (bit, deps) in layer {
+            write_u64(writer, *bit as u64)?;
+            write_u64(writer, deps.len() as u64)?;
+            for dep in deps {
+                write_u64(writer, *dep as u64)?;
+            }
+        }
+    }
+    Ok(())
+}
+
+/// Read a dependency graph, written with [write_dependency_graph], from `reader`.
+/// Errors with [InvalidData](io::ErrorKind::InvalidData) if the data is not a valid
+/// dependency graph.
+#[cfg(feature = "analyse")]
+#[cfg_attr(docsrs, doc(cfg(feature = "analyse")))]
+pub fn read_dependency_graph(reader: &mut impl Read) -> io::Result<DependencyGraph> {
+    let (_, len) = read_header(reader, GRAPH)?;
+    let mut read_usize = || -> io::Result<usize> {
+        read_u64(reader)?
+            .try_into()
+            .map_err(|_| invalid_data("number too large for usize"))
+    };
+    // don't trust the lengths for allocations
+    let mut graph = Vec::new();
+    for _ in 0..len {
+        let mut layer = Vec::new();
+        for _ in 0..read_usize()? {
+            let bit = read_usize()?;
+            let mut deps = Vec::new();
+            for _ in 0..read_usize()? {
+                deps.push(read_usize()?);
+            }
+            layer.push((bit, deps));
+        }
+        graph.push(layer);
+    }
+    Ok(graph)
+}
+
+#[cfg(test)]
+mod tests {
+    use std::borrow::Cow;
+
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::{
+            packed::PackedBitVec,
+            sparse::SparseBitVec,
+        },
+        pauli::Pauli,
+        tracker::frames::storage::{
+            self,
+            Map,
+            Vector,
+        },
+    };
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn storage() -> Map<PackedBitVec> {
+        let mut ret = Map::default();
+        for bit in 0..6 {
+            let mut stack = PauliVec::new();
+            for frame in 0..(bit * 400) {
+                let pauli = match frame % 397 {
+                    0 | 130 | 131 => 1 + frame % 3,
+                    _ => 0,
+                };
+                stack.push(Pauli::try_from(pauli as u8).unwrap());
+            }
+            ret.insert(bit * 3, stack);
+        }
+        ret
+    }
+
+    #[test]
+    fn roundtrip() {
+        let storage = storage();
+        let mut sizes = Vec::new();
+        for compression in [Compression::None, Compression::ZeroRuns] {
+            let mut buf = Vec::new();
+            write_storage(&storage, compression, &mut buf).unwrap();
+            sizes.push(buf.len());
+            let read: Map<PackedBitVec> = read_storage(&mut buf.as_slice()).unwrap();
+            assert_eq!(read, storage);
+            // Vector fills the gaps with empty stacks
+            let read: Vector<Vec<bool>> = read_storage(&mut buf.as_slice()).unwrap();
+            assert_eq!(read.frames.len(), 16);
+            for (bit, stack) in storage::sort_by_bit(&storage) {
+                assert_eq!(
+                    read.frames[bit].left.iter_vals().collect::<Vec<_>>(),
+                    stack.left.iter_vals().collect::<Vec<_>>()
+                );
+            }
+        }
+        assert!(sizes[1] < sizes[0]);
+    }
+
+    #[test]
+    fn words_roundtrip() {
+        let vec = (0..200).map(|i| i % 7 == 0).collect::<Vec<bool>>();
+        let words = vec.to_words();
+        assert_eq!(words.len(), 4);
+        assert_eq!(from_words::<Vec<bool>>(words.iter().copied(), 200).unwrap(), vec);
+        let packed = vec.iter().copied().collect::<PackedBitVec>();
+        assert_eq!(packed.to_words(), words);
+        assert!(matches!(packed.to_words(), Cow::Borrowed(_)));
+        let sparse = vec.iter().copied().collect::<SparseBitVec>();
+        assert_eq!(sparse.to_words(), words);
+    }
+
+    #[test]
+    fn invalid_data() {
+        let mut buf = Vec::new();
+        write_storage(&storage(), Compression::ZeroRuns, &mut buf).unwrap();
+        assert!(StorageView::new(&buf).is_ok());
+        for data in [&buf[..buf.len() - 1], &buf[..HEADER_LEN - 1], &buf[1..]] {
+            assert_eq!(
+                StorageView::new(data).unwrap_err().kind(),
+                io::ErrorKind::InvalidData
+            );
+        }
+        let mut longer = buf.clone();
+        longer.push(0);
+        assert!(StorageView::new(&longer).is_err());
+        let mut wrong_version = buf;
+        wrong_version[8] = 42;
+        assert!(StorageView::new(&wrong_version).is_err());
+
+        // a huge length must neither overflow nor be walked through
+        let stack = |len: u64, block: &[u64]| {
+            let mut buf = Vec::new();
+            write_header(&mut buf, STORAGE, ZERO_RUNS, 1).unwrap();
+            for word in [0, len, 0].iter().chain(block) {
+                write_u64(&mut buf, *word).unwrap();
+            }
+            // the empty right block
+            write_u64(&mut buf, 0).unwrap();
+            buf
+        };
+        for (len, block) in [
+            (u64::MAX, &[0][..]),
+            (u64::MAX, &[4, u64::MAX, 0, 1, 0]),
+            (u64::MAX, &[2, 1, u64::MAX]),
+        ] {
+            assert_eq!(
+                StorageView::new(&stack(len, block)).unwrap_err().kind(),
+                io::ErrorKind::InvalidData
+            );
+        }
+        assert!(StorageView::new(&stack(130, &[3, 2, 1, 1])).is_ok());
+        let mut uncompressed = Vec::new();
+        write_header(&mut uncompressed, STORAGE, 0, 1).unwrap();
+        for word in [0, u64::MAX, 0] {
+            write_u64(&mut uncompressed, word).unwrap();
+        }
+        assert_eq!(
+            StorageView::new(&uncompressed).unwrap_err().kind(),
+            io::ErrorKind::InvalidData
+        );
+    }
+
+    #[cfg(feature = "analyse")]
+    #[test]
+    fn dependency_graph() {
+        let graph = vec![vec![(0, vec![]), (4, vec![])], vec![(1, vec![0, 4])]];
+        let mut buf = Vec::new();
+        write_dependency_graph(&graph, &mut buf).unwrap();
+        assert_eq!(read_dependency_graph(&mut buf.as_slice()).unwrap(), graph);
+        assert!(read_storage::<Map<Vec<bool>>>(&mut buf.as_slice()).is_err());
+    }
+}
@@ -2,7 +2,15 @@
 This module defines a common interface [BooleanVector] over boolean storage types that
 we use in [frames](crate::tracker::frames) and for [PauliVec](crate::pauli::PauliVec).
 
-We provide optional implementations for the foreign types
+We provide the first-party bit-vector [PackedBitVec](packed::PackedBitVec), which packs
+the bits into aligned words and uses explicit SIMD kernels (selected at runtime) for the
+elementwise operations. It is the recommended type if one tracks many frames. For
+stacks that are mostly zeros, [SparseBitVec](sparse::SparseBitVec) stores only the set
+bits, switching adaptively to a [PackedBitVec](packed::PackedBitVec) when that is
+cheaper. If only a few frames, known at compile time, are tracked,
+[FixedBits](fixed::FixedBits) stores the bits inline without any allocation.
+
+Additionally, we provide optional implementations for the foreign types
 [bitvec::vec::BitVec](https://docs.rs/bitvec/latest/bitvec/vec/struct.BitVec.html),
 [bitvec_simd::BitVec] (included via the corresponding features) and
 [bit_vec::BitVec](https://docs.rs/bit-vec/latest/bit_vec/struct.BitVec.html).
@@ -15,7 +23,10 @@ bit-vector libraries too, for which it should be easy to implement [BooleanVecto
 [bitvec_simd::BitVec]: https://docs.rs/bitvec_simd/latest/bitvec_simd/type.BitVec.html
 */
 
-use std::fmt::Debug;
+use std::{
+    borrow::Cow,
+    fmt::Debug,
+};
 
 macro_rules! inplace {
     ($(($name:ident, $action:literal),)*) => {$(
@@ -51,6 +62,40 @@ pub trait BooleanVector:
     /// Create a new empty boolean vector.
     fn new() -> Self;
 
+    /// Create a new empty boolean vector with enough capacity to hold `capacity`
+    /// elements without reallocating.
+    ///
+    /// The default implementation ignores the `capacity` and calls [new](Self::new).
+    fn with_capacity(capacity: usize) -> Self {
+        let _ = capacity;
+        Self::new()
+    }
+
+    /// Reserve capacity for at least `additional` more elements.
+    ///
+    /// The default implementation does nothing.
+    fn reserve(&mut self, additional: usize) {
+        let _ = additional;
+    }
+
+    /// Append `num` many `false/0` elements.
+    ///
+    /// The default implementation [resize](Self::resize)s the vector.
+    ///
+    /// # Examples
+    ///```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let mut vec = vec![true];
+    /// vec.extend_zeros(2);
+    /// assert_eq!(vec, vec![true, false, false]);
+    /// # }
+    /// ```
+    fn extend_zeros(&mut self, num: usize) {
+        self.resize(self.len() + num, false);
+    }
+
     /// Create a boolean vector with `len` many `false/0` elements.
     ///
     /// # Examples
@@ -79,8 +124,62 @@ pub trait BooleanVector:
     /// # }
     fn set(&mut self, idx: usize, flag: bool);
 
+    /// Get the element at `idx`, or [None] if `idx` is out of bounds.
+    ///
+    /// The default implementation goes through [iter_vals](Self::iter_vals), i.e., it
+    /// is *O*(`idx`); overwrite it if the elements can be accessed directly, as the
+    /// implementations in this crate do.
+    ///
+    /// # Examples
+    ///```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let vec = vec![true, false];
+    /// assert_eq!(vec.get_val(0), Some(true));
+    /// assert_eq!(vec.get_val(2), None);
+    /// # }
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.iter_vals().nth(idx)
+    }
+
     inplace!((xor_inplace, "XOR"), (or_inplace, "OR"),);
 
+    /// Perform AND between `self` and `rhs` elementwise, updating self.
+    ///
+    /// The default implementation uses `a AND b = (a OR b) XOR (a XOR b)`, i.e., it
+    /// needs a temporary vector and three passes; the implementations in this crate
+    /// overwrite it.
+    ///
+    /// # Panics
+    /// Panics if self.len() \neq rhs.len().
+    ///
+    /// # Examples
+    ///```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let mut vec = vec![true, true, false];
+    /// vec.and_inplace(&vec![true, false, true]);
+    /// assert_eq!(vec, vec![true, false, false]);
+    /// # }
+    fn and_inplace(&mut self, rhs: &Self) {
+        let mut xor = self.clone();
+        xor.xor_inplace(rhs);
+        self.or_inplace(rhs);
+        self.xor_inplace(&xor);
+    }
+
+    /// Like [xor_inplace](Self::xor_inplace), but the work may be split across multiple
+    /// threads, e.g., into word-chunks for long vectors.
+    ///
+    /// The default implementation just calls [xor_inplace](Self::xor_inplace).
+    #[cfg(feature = "rayon")]
+    #[cfg_attr(docsrs, doc(cfg(feature = "rayon")))]
+    fn par_xor_inplace(&mut self, rhs: &Self) {
+        self.xor_inplace(rhs)
+    }
+
     /// Resize the boolean vector to contain `len` elements, where new values are
     /// initialized with `flag`.
     ///
@@ -100,6 +199,78 @@ pub trait BooleanVector:
     /// Push a new element onto the vector.
     fn push(&mut self, flag: bool);
 
+    /// Push the lowest `num` bits of `word` onto the vector, starting with the least
+    /// significant bit.
+    ///
+    /// The default implementation pushes the bits one by one; bit-vectors that store
+    /// their bits in words should overwrite it.
+    ///
+    /// # Panics
+    /// Panics if `num` > 64.
+    ///
+    /// # Examples
+    ///```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let mut vec = vec![true];
+    /// vec.extend_from_word(0b110, 3);
+    /// assert_eq!(vec, vec![true, false, true, true]);
+    /// # }
+    fn extend_from_word(&mut self, word: u64, num: usize) {
+        assert!(num <= 64, "a word has only 64 bits");
+        for i in 0..num {
+            self.push(word & (1 << i) != 0);
+        }
+    }
+
+    /// Get the bits packed into ⌈[len](Self::len) / 64⌉ words, least significant bit
+    /// first, i.e., the inverse of [extend_from_word](Self::extend_from_word). The bits
+    /// beyond [len](Self::len) in the last word are zero.
+    ///
+    /// The default implementation packs the bits one by one; bit-vectors that store
+    /// their bits in words should overwrite it to borrow them.
+    ///
+    /// # Examples
+    ///```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let vec = vec![true, false, true, true];
+    /// assert_eq!(vec.to_words().as_ref(), [0b1101]);
+    /// # }
+    fn to_words(&self) -> Cow<'_, [u64]> {
+        let mut words = vec![0; (self.len() + 63) / 64];
+        for (i, flag) in self.iter_vals().enumerate() {
+            words[i / 64] |= (flag as u64) << (i % 64);
+        }
+        Cow::Owned(words)
+    }
+
+    /// Get the `idx`-th word of [to_words](Self::to_words), or [None] if `idx` is out
+    /// of bounds.
+    ///
+    /// The default implementation packs the 64 bits of the word one by one via
+    /// [get_val](Self::get_val); the implementations in this crate that store their
+    /// bits in words read the word directly.
+    ///
+    /// # Examples
+    ///```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let mut vec = vec![false; 64];
+    /// vec.extend_from_word(0b101, 3);
+    /// assert_eq!(vec.get_word(1), Some(0b101));
+    /// assert_eq!(vec.get_word(2), None);
+    /// # }
+    fn get_word(&self, idx: usize) -> Option<u64> {
+        let start = idx.checked_mul(64).filter(|start| *start < self.len())?;
+        Some((0..64).fold(0, |word, k| {
+            word | (self.get_val(start + k).unwrap_or(false) as u64) << k
+        }))
+    }
+
     /// Pop the last element from the vector and return it. Returns [None] if the vector
     /// is empty.
     fn pop(&mut self) -> Option<bool>;
@@ -149,16 +320,51 @@ pub trait BooleanVector:
     /// # }
     /// ```
     fn sum_up(&self, filter: &[bool]) -> u8 {
-        self.iter_vals()
+        (self
+            .iter_vals()
             .enumerate()
-            .filter_map(|(i, f)| if filter[i] { Some(f as u8) } else { None })
-            .sum::<u8>()
-            % 2
+            .filter(|(i, f)| filter[*i] && *f)
+            .count()
+            % 2) as u8
+    }
+
+    /// Like [sum_up](Self::sum_up), but with the `filter` given as boolean vector of
+    /// the same type, e.g., the measurement outcomes. An element `e` is filtered if
+    /// `filter`'s element at `e`'s index is `true`; if the `filter` is shorter than
+    /// `self`, the remaining elements are not filtered.
+    ///
+    /// The default implementation goes through both vectors elementwise; bit-vectors
+    /// like [PackedBitVec](packed::PackedBitVec) evaluate it word by word as parity of
+    /// AND and popcount.
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::BooleanVector;
+    /// let bools = vec![true, false, true, false, true, false];
+    /// let filter = vec![true, true, true, false, true];
+    /// assert_eq!(bools.sum_up_filter(&filter), 1);
+    /// # }
+    /// ```
+    fn sum_up_filter(&self, filter: &Self) -> u8 {
+        (self
+            .iter_vals()
+            .zip(filter.iter_vals())
+            .filter(|(flag, filtered)| *flag && *filtered)
+            .count()
+            % 2) as u8
     }
 }
 
 mod std_vec;
 
+pub mod packed;
+
+pub mod sparse;
+
+pub mod fixed;
+
 #[cfg(feature = "bitvec")]
 #[cfg_attr(docsrs, doc(cfg(feature = "bitvec")))]
 mod bitvec;
@@ -182,4 +388,85 @@ mod tests {
         assert!(<Vec<bool> as BooleanVector>::is_empty(&vec![]));
         assert!(!<Vec<bool> as BooleanVector>::is_empty(&vec![true]));
     }
+
+    // implements only the required methods, to test the default implementations
+    #[derive(Clone, PartialEq, Debug)]
+    struct Minimal(Vec<bool>);
+
+    impl FromIterator<bool> for Minimal {
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn from_iter<T: IntoIterator<Item = bool>>(iter: T) -> Self {
+            Self(iter.into_iter().collect())
+        }
+    }
+
+    impl IntoIterator for Minimal {
+        type Item = bool;
+        type IntoIter = std::vec::IntoIter<bool>;
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn into_iter(self) -> Self::IntoIter {
+            self.0.into_iter()
+        }
+    }
+
+    impl BooleanVector for Minimal {
+        type IterVals<'l> = std::iter::Copied<std::slice::Iter<'l, bool>>;
+
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn new() -> Self {
+            Self(Vec::new())
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn zeros(len: usize) -> Self {
+            Self(vec![false; len])
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn set(&mut self, idx: usize, flag: bool) {
+            self.0.set(idx, flag)
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn xor_inplace(&mut self, rhs: &Self) {
+            self.0.xor_inplace(&rhs.0)
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn or_inplace(&mut self, rhs: &Self) {
+            self.0.or_inplace(&rhs.0)
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn resize(&mut self, len: usize, flag: bool) {
+            self.0.resize(len, flag)
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn push(&mut self, flag: bool) {
+            self.0.push(flag)
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn pop(&mut self) -> Option<bool> {
+            self.0.pop()
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn len(&self) -> usize {
+            self.0.len()
+        }
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn iter_vals(&self) -> Self::IterVals<'_> {
+            self.0.iter().copied()
+        }
+    }
+
+    #[test]
+    fn default_get_and() {
+        let a = vec![true, true, false, false, true];
+        let b = vec![true, false, true, false, true];
+        let mut minimal = Minimal(a);
+        minimal.and_inplace(&Minimal(b));
+        let expected = vec![true, false, false, false, true];
+        for (idx, flag) in expected.iter().enumerate() {
+            assert_eq!(minimal.get_val(idx), Some(*flag));
+        }
+        assert_eq!(minimal.get_val(5), None);
+        assert_eq!(minimal.get_word(0), Some(0b10001));
+        assert_eq!(minimal.get_word(1), None);
+        assert_eq!(minimal, Minimal(expected));
+    }
 }
@@ -10,6 +10,18 @@ impl BooleanVector for BitVec {
         BitVec::new()
     }
 
+    fn with_capacity(capacity: usize) -> Self {
+        BitVec::with_capacity(capacity)
+    }
+
+    fn reserve(&mut self, additional: usize) {
+        self.reserve(additional)
+    }
+
+    fn extend_zeros(&mut self, num: usize) {
+        self.grow(num, false)
+    }
+
     fn zeros(len: usize) -> Self {
         // not sure whether that is the fastest way
         let rest = len % 8;
@@ -25,6 +37,10 @@ impl BooleanVector for BitVec {
         self.set(idx, flag);
     }
 
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.get(idx)
+    }
+
     fn xor_inplace(&mut self, rhs: &Self) {
         self.xor(rhs);
     }
@@ -33,6 +49,10 @@ impl BooleanVector for BitVec {
         self.or(rhs);
     }
 
+    fn and_inplace(&mut self, rhs: &Self) {
+        self.and(rhs);
+    }
+
     fn resize(&mut self, len: usize, flag: bool) {
         let current_len = self.len();
         match current_len.cmp(&len) {
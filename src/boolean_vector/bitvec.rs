@@ -18,6 +18,14 @@ impl BooleanVector for BitVec {
         BitVec::new()
     }
 
+    fn with_capacity(capacity: usize) -> Self {
+        BitVec::with_capacity(capacity)
+    }
+
+    fn reserve(&mut self, additional: usize) {
+        self.reserve(additional)
+    }
+
     fn zeros(len: usize) -> Self {
         bitvec::bitvec![0; len]
     }
@@ -26,6 +34,10 @@ impl BooleanVector for BitVec {
         *self.get_mut(idx).unwrap() = flag;
     }
 
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.get(idx).map(|flag| *flag)
+    }
+
     fn xor_inplace(&mut self, rhs: &Self) {
         *self ^= rhs;
     }
@@ -34,6 +46,10 @@ impl BooleanVector for BitVec {
         *self |= rhs;
     }
 
+    fn and_inplace(&mut self, rhs: &Self) {
+        *self &= rhs;
+    }
+
     fn resize(&mut self, len: usize, flag: bool) {
         self.resize(len, flag);
     }
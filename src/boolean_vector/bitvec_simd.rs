@@ -82,6 +82,10 @@ impl BooleanVector for SimdBitVec {
         self.0.set(idx, flag);
     }
 
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.0.get(idx)
+    }
+
     fn xor_inplace(&mut self, rhs: &Self) {
         self.0.xor_inplace(&rhs.0);
     }
@@ -90,6 +94,10 @@ impl BooleanVector for SimdBitVec {
         self.0.or_inplace(&rhs.0);
     }
 
+    fn and_inplace(&mut self, rhs: &Self) {
+        self.0.and_inplace(&rhs.0);
+    }
+
     fn resize(&mut self, len: usize, flag: bool) {
         self.0.resize(len, flag);
     }
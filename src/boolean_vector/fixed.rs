@@ -0,0 +1,566 @@
+/*!
+An inline [BooleanVector] with a capacity that is fixed at compile time.
+
+If the number of frames that are tracked is small and known in advance, e.g., at most
+64 or 128 frames per sub-circuit, [FixedBits] stores the bits inline in an array of
+`WORDS` [u64] words, without any heap allocation. Since the number of words is a
+constant, the elementwise operations compile down to a few word operations, e.g., the
+gates of `Frames<Vector<FixedBits<2>>>` are just a couple of register XORs per qubit.
+
+The methods of the [BooleanVector] trait cannot report errors, so they panic if the
+[CAPACITY](FixedBits::CAPACITY) is exceeded, e.g., when pushing too many frames onto a
+stack. Use [try_push](FixedBits::try_push), [try_resize](FixedBits::try_resize) and
+[try_extend_from_word](FixedBits::try_extend_from_word) to handle that case, e.g., to
+switch to a heap-backed vector like [PackedBitVec](super::packed::PackedBitVec).
+*/
+
+use std::{
+    borrow::Cow,
+    error::Error,
+    fmt::{
+        self,
+        Display,
+        Formatter,
+    },
+};
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use super::BooleanVector;
+
+const WORD_BITS: usize = u64::BITS as usize;
+
+/// A bit-vector with an inline capacity of `WORDS` [u64] words, cf. the
+/// [module](self) documentation.
+///
+/// The type holds the invariant that all bits beyond [len](BooleanVector::len) are
+/// zero. The [PartialEq] implementation relies on that.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     boolean_vector::fixed::FixedBits,
+///     tracker::{
+///         frames::{
+///             storage::Vector,
+///             Frames,
+///         },
+///         Tracker,
+///     },
+/// };
+/// let mut tracker = Frames::<Vector<FixedBits<2>>>::init(2);
+/// tracker.track_x(0);
+/// tracker.track_z(1);
+/// tracker.cx(0, 1);
+/// assert_eq!(tracker.as_storage().frames[1].left.as_words(), &[0b01, 0]);
+/// assert_eq!(tracker.as_storage().frames[0].right.as_words(), &[0b10, 0]);
+/// # }
+/// ```
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+#[cfg_attr(
+    feature = "serde",
+    derive(Serialize, Deserialize),
+    serde(into = "Repr", try_from = "Repr")
+)]
+pub struct FixedBits<const WORDS: usize> {
+    words: [u64; WORDS],
+    len: usize,
+}
+
+/// The error when an operation on a [FixedBits] would exceed its
+/// [CAPACITY](FixedBits::CAPACITY).
+#[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Default, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct CapacityError {
+    /// The capacity of the vector.
+    pub capacity: usize,
+    /// The length that would have been needed.
+    pub requested: usize,
+}
+impl Display for CapacityError {
+    fn fmt(&self, f: &mut Formatter<'_>) -> fmt::Result {
+        write!(
+            f,
+            "the length {} exceeds the fixed capacity {}",
+            self.requested, self.capacity
+        )
+    }
+}
+impl Error for CapacityError {}
+
+impl<const WORDS: usize> Default for FixedBits<WORDS> {
+    fn default() -> Self {
+        Self { words: [0; WORDS], len: 0 }
+    }
+}
+
+#[inline]
+fn position(idx: usize) -> (usize, u64) {
+    (idx / WORD_BITS, 1 << (idx % WORD_BITS))
+}
+
+impl<const WORDS: usize> FixedBits<WORDS> {
+    /// The maximum number of bits that the vector can hold.
+    pub const CAPACITY: usize = WORDS * WORD_BITS;
+
+    /// Create a vector with `len` bits from the `words`, where the bit `i` is the bit
+    /// `i % 64` of the word `i / 64`. Superfluous bits are ignored.
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::{
+    ///     fixed::FixedBits,
+    ///     BooleanVector,
+    /// };
+    /// let vec = FixedBits::from_words([0b1101], 3).unwrap();
+    /// assert_eq!(vec.iter_vals().collect::<Vec<_>>(), vec![true, false, true]);
+    /// assert!(FixedBits::from_words([0], 65).is_err());
+    /// # }
+    /// ```
+    pub fn from_words(words: [u64; WORDS], len: usize) -> Result<Self, CapacityError> {
+        check_capacity::<WORDS>(len)?;
+        let mut ret = Self { words, len };
+        ret.clear_tail();
+        Ok(ret)
+    }
+
+    /// Get the bit at `idx`, or [None] if `idx` is out of bounds.
+    #[inline]
+    pub fn get(&self, idx: usize) -> Option<bool> {
+        if idx >= self.len {
+            return None;
+        }
+        let (word, mask) = position(idx);
+        Some(self.words[word] & mask != 0)
+    }
+
+    /// Count the number of `true/1` elements.
+    pub fn count_ones(&self) -> usize {
+        self.words.iter().map(|w| w.count_ones() as usize).sum()
+    }
+
+    /// Get the inner words. All bits beyond [len](BooleanVector::len) are zero.
+    #[inline]
+    pub fn as_words(&self) -> &[u64; WORDS] {
+        &self.words
+    }
+
+    /// Append `flag`, or return an error if the vector is full.
+    pub fn try_push(&mut self, flag: bool) -> Result<(), CapacityError> {
+        check_capacity::<WORDS>(self.len + 1)?;
+        let (word, mask) = position(self.len);
+        if flag {
+            self.words[word] |= mask;
+        }
+        self.len += 1;
+        Ok(())
+    }
+
+    /// Resize the vector to `len`, filling new elements with `flag`, or return an
+    /// error (without changing the vector) if `len` exceeds the capacity.
+    pub fn try_resize(&mut self, len: usize, flag: bool) -> Result<(), CapacityError> {
+        check_capacity::<WORDS>(len)?;
+        let old_len = self.len;
+        self.len = len;
+        if len <= old_len {
+            self.clear_tail();
+        } else if flag {
+            let (first, _) = position(old_len);
+            let (last, _) = position(len - 1);
+            self.words[first] |= !((1 << (old_len % WORD_BITS)) - 1);
+            for w in self.words[first + 1..=last].iter_mut() {
+                *w = u64::MAX;
+            }
+            self.clear_tail();
+        }
+        Ok(())
+    }
+
+    /// Append the first `num` bits of `word`, or return an error (without changing
+    /// the vector) if that would exceed the capacity, cf.
+    /// [BooleanVector::extend_from_word].
+    ///
+    /// # Panics
+    /// Panics if `num` > 64.
+    pub fn try_extend_from_word(
+        &mut self,
+        word: u64,
+        num: usize,
+    ) -> Result<(), CapacityError> {
+        assert!(num <= WORD_BITS, "a word has only 64 bits");
+        check_capacity::<WORDS>(self.len + num)?;
+        if num == 0 {
+            return Ok(());
+        }
+        let word = if num < WORD_BITS { word & ((1 << num) - 1) } else { word };
+        let (idx, shift) = (self.len / WORD_BITS, self.len % WORD_BITS);
+        self.words[idx] |= word << shift;
+        if shift != 0 && shift + num > WORD_BITS {
+            self.words[idx + 1] |= word >> (WORD_BITS - shift);
+        }
+        self.len += num;
+        Ok(())
+    }
+
+    fn clear_tail(&mut self) {
+        let (word, _) = position(self.len);
+        if word < WORDS {
+            self.words[word] &= (1 << (self.len % WORD_BITS)) - 1;
+            for w in self.words[word + 1..].iter_mut() {
+                *w = 0;
+            }
+        }
+    }
+}
+
+#[inline]
+fn check_capacity<const WORDS: usize>(len: usize) -> Result<(), CapacityError> {
+    let capacity = FixedBits::<WORDS>::CAPACITY;
+    if len > capacity {
+        return Err(CapacityError { capacity, requested: len });
+    }
+    Ok(())
+}
+
+fn or_panic(result: Result<(), CapacityError>) {
+    if let Err(e) = result {
+        panic!("{e}");
+    }
+}
+
+fn check_len<const WORDS: usize>(lhs: &FixedBits<WORDS>, rhs: &FixedBits<WORDS>) {
+    assert_eq!(
+        lhs.len, rhs.len,
+        "left and right-hand side must have the same length"
+    );
+}
+
+macro_rules! inplace {
+    ($(($name:ident, $op:tt),)*) => {$(
+        #[inline]
+        fn $name(&mut self, rhs: &Self) {
+            check_len(self, rhs);
+            for (l, r) in self.words.iter_mut().zip(rhs.words) {
+                *l $op r;
+            }
+        }
+    )*};
+}
+
+impl<const WORDS: usize> BooleanVector for FixedBits<WORDS> {
+    type IterVals<'l> = Iter<'l, WORDS>;
+
+    fn new() -> Self {
+        Self::default()
+    }
+
+    /// # Panics
+    /// Panics if `len` exceeds the [CAPACITY](FixedBits::CAPACITY).
+    fn zeros(len: usize) -> Self {
+        let mut ret = Self::new();
+        or_panic(ret.try_resize(len, false));
+        ret
+    }
+
+    fn set(&mut self, idx: usize, flag: bool) {
+        assert!(idx < self.len, "index {idx} out of bounds for length {}", self.len);
+        let (word, mask) = position(idx);
+        if flag {
+            self.words[word] |= mask;
+        } else {
+            self.words[word] &= !mask;
+        }
+    }
+
+    inplace!((xor_inplace, ^=), (or_inplace, |=), (and_inplace, &=),);
+
+    #[inline]
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.get(idx)
+    }
+
+    /// # Panics
+    /// Panics if `len` exceeds the [CAPACITY](FixedBits::CAPACITY), cf.
+    /// [try_resize](FixedBits::try_resize).
+    fn resize(&mut self, len: usize, flag: bool) {
+        or_panic(self.try_resize(len, flag));
+    }
+
+    /// # Panics
+    /// Panics if the vector is full, cf. [try_push](FixedBits::try_push).
+    fn push(&mut self, flag: bool) {
+        or_panic(self.try_push(flag));
+    }
+
+    /// # Panics
+    /// Panics if `num` > 64 or if the [CAPACITY](FixedBits::CAPACITY) would be
+    /// exceeded, cf. [try_extend_from_word](FixedBits::try_extend_from_word).
+    fn extend_from_word(&mut self, word: u64, num: usize) {
+        or_panic(self.try_extend_from_word(word, num));
+    }
+
+    #[inline]
+    fn to_words(&self) -> Cow<'_, [u64]> {
+        Cow::Borrowed(&self.words[..(self.len + WORD_BITS - 1) / WORD_BITS])
+    }
+
+    #[inline]
+    fn get_word(&self, idx: usize) -> Option<u64> {
+        self.to_words().get(idx).copied()
+    }
+
+    fn pop(&mut self) -> Option<bool> {
+        let last = self.len.checked_sub(1)?;
+        let ret = self.get(last);
+        self.len = last;
+        self.clear_tail();
+        ret
+    }
+
+    #[inline]
+    fn len(&self) -> usize {
+        self.len
+    }
+
+    fn iter_vals(&self) -> Self::IterVals<'_> {
+        Iter { vec: self, current: 0 }
+    }
+
+    fn sum_up_filter(&self, filter: &Self) -> u8 {
+        let parity = self
+            .words
+            .iter()
+            .zip(filter.words)
+            .fold(0, |parity, (word, mask)| parity ^ (word & mask).count_ones());
+        (parity & 1) as u8
+    }
+}
+
+/// # Panics
+/// Panics if the iterator yields more than [CAPACITY](FixedBits::CAPACITY) elements.
+impl<const WORDS: usize> FromIterator<bool> for FixedBits<WORDS> {
+    fn from_iter<T: IntoIterator<Item = bool>>(iter: T) -> Self {
+        let mut ret = Self::new();
+        for flag in iter {
+            ret.push(flag);
+        }
+        ret
+    }
+}
+
+/// An [Iterator] over &[FixedBits]. Created with [BooleanVector::iter_vals].
+#[derive(Copy, Clone, PartialEq, Eq, Debug)]
+pub struct Iter<'l, const WORDS: usize> {
+    vec: &'l FixedBits<WORDS>,
+    current: usize,
+}
+
+impl<const WORDS: usize> Iterator for Iter<'_, WORDS> {
+    type Item = bool;
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        let ret = self.vec.get(self.current)?;
+        self.current += 1;
+        Some(ret)
+    }
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let rest = self.vec.len - self.current;
+        (rest, Some(rest))
+    }
+}
+impl<const WORDS: usize> ExactSizeIterator for Iter<'_, WORDS> {}
+
+/// An [Iterator] over [FixedBits]. Created with [IntoIterator].
+#[derive(Copy, Clone, PartialEq, Eq, Debug)]
+pub struct IntoIter<const WORDS: usize> {
+    vec: FixedBits<WORDS>,
+    current: usize,
+}
+
+impl<const WORDS: usize> Iterator for IntoIter<WORDS> {
+    type Item = bool;
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        let ret = self.vec.get(self.current)?;
+        self.current += 1;
+        Some(ret)
+    }
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let rest = self.vec.len - self.current;
+        (rest, Some(rest))
+    }
+}
+impl<const WORDS: usize> ExactSizeIterator for IntoIter<WORDS> {}
+
+impl<const WORDS: usize> IntoIterator for FixedBits<WORDS> {
+    type Item = bool;
+    type IntoIter = IntoIter<WORDS>;
+    fn into_iter(self) -> Self::IntoIter {
+        IntoIter { vec: self, current: 0 }
+    }
+}
+
+// serde does not support arrays of generic length, so we (de)serialize the words as
+// sequence
+#[cfg(feature = "serde")]
+#[derive(Serialize, Deserialize)]
+struct Repr {
+    words: Vec<u64>,
+    len: usize,
+}
+
+#[cfg(feature = "serde")]
+impl<const WORDS: usize> From<FixedBits<WORDS>> for Repr {
+    fn from(vec: FixedBits<WORDS>) -> Self {
+        Self {
+            words: vec.words.to_vec(),
+            len: vec.len,
+        }
+    }
+}
+
+#[cfg(feature = "serde")]
+impl<const WORDS: usize> TryFrom<Repr> for FixedBits<WORDS> {
+    type Error = CapacityError;
+    fn try_from(repr: Repr) -> Result<Self, Self::Error> {
+        let mut words = [0; WORDS];
+        let num = WORDS.min(repr.words.len());
+        words[..num].copy_from_slice(&repr.words[..num]);
+        Self::from_words(words, repr.len)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+
+    type Fixed = FixedBits<2>;
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn bits(len: usize, period: usize, offset: usize) -> Vec<bool> {
+        (0..len).map(|i| (i + offset) % period == 0).collect()
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn check(fixed: &Fixed, expected: &[bool]) {
+        assert_eq!(fixed.len(), expected.len());
+        assert_eq!(fixed.iter_vals().collect::<Vec<_>>(), expected);
+        assert_eq!(fixed.into_iter().collect::<Vec<_>>(), expected);
+        assert_eq!(fixed.count_ones(), expected.iter().filter(|b| **b).count());
+    }
+
+    #[test]
+    fn compare_with_vec() {
+        for len in [0, 1, 63, 64, 65, 100, 128] {
+            for (period, offset) in [(1, 0), (2, 1), (3, 0), (7, 2)] {
+                let a = bits(len, period, offset);
+                let fixed = a.iter().copied().collect::<Fixed>();
+                check(&fixed, &a);
+                let b = bits(len, period + 1, offset + 1);
+                let rhs = b.iter().copied().collect::<Fixed>();
+
+                let (mut xor, mut expected) = (fixed, a.clone());
+                xor.xor_inplace(&rhs);
+                expected.xor_inplace(&b);
+                check(&xor, &expected);
+
+                let (mut or, mut expected) = (fixed, a.clone());
+                or.or_inplace(&rhs);
+                expected.or_inplace(&b);
+                check(&or, &expected);
+
+                let (mut and, mut expected) = (fixed, a.clone());
+                and.and_inplace(&rhs);
+                expected.and_inplace(&b);
+                check(&and, &expected);
+
+                assert_eq!(fixed.sum_up(&b), a.sum_up(&b));
+                assert_eq!(fixed.sum_up_filter(&rhs), a.sum_up(&b));
+
+                for new_len in [len / 2, (len + 1).min(128), 128] {
+                    for flag in [true, false] {
+                        let (mut fixed, mut expected) = (fixed, a.clone());
+                        fixed.resize(new_len, flag);
+                        expected.resize(new_len, flag);
+                        check(&fixed, &expected);
+                        assert_eq!(fixed, expected.iter().copied().collect());
+                    }
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn single_elements() {
+        let mut fixed = Fixed::zeros(3);
+        fixed.set(1, true);
+        fixed.push(true);
+        fixed.extend_from_word(0b101, 62);
+        fixed.extend_from_word(u64::MAX, 62);
+        let mut expected = vec![false, true, false, true, true, false, true];
+        expected.extend_zeros(59);
+        expected.extend(std::iter::repeat(true).take(62));
+        check(&fixed, &expected);
+        assert_eq!(fixed.get_val(1), Some(true));
+        assert_eq!(fixed.get_val(128), None);
+        fixed.set(1, false);
+        assert_eq!(fixed.pop(), Some(true));
+        expected.set(1, false);
+        expected.pop();
+        check(&fixed, &expected);
+        while fixed.pop().is_some() {}
+        assert_eq!(fixed, Fixed::new());
+    }
+
+    #[test]
+    fn capacity() {
+        assert_eq!(Fixed::CAPACITY, 128);
+        let error = CapacityError { capacity: 128, requested: 129 };
+        let mut fixed = Fixed::zeros(127);
+        assert_eq!(fixed.try_push(true), Ok(()));
+        let copy = fixed;
+        assert_eq!(fixed.try_push(true), Err(error));
+        assert_eq!(fixed.try_resize(129, true), Err(error));
+        assert_eq!(fixed.try_extend_from_word(1, 1), Err(error));
+        assert_eq!(fixed, copy);
+        assert_eq!(error.to_string(), "the length 129 exceeds the fixed capacity 128");
+        assert_eq!(Fixed::from_words([u64::MAX; 2], 129), Err(error));
+        assert_eq!(
+            Fixed::from_words([u64::MAX; 2], 65).unwrap(),
+            Fixed::zeros(65).into_iter().map(|_| true).collect()
+        );
+    }
+
+    #[test]
+    #[should_panic(expected = "the length 129 exceeds the fixed capacity 128")]
+    fn push_beyond_capacity() {
+        Fixed::zeros(128).push(false);
+    }
+
+    #[test]
+    #[should_panic]
+    fn xor_different_lengths() {
+        Fixed::zeros(3).xor_inplace(&Fixed::zeros(4));
+    }
+
+    #[cfg(feature = "serde")]
+    #[test]
+    fn serde_repr() {
+        let fixed = bits(100, 3, 1).into_iter().collect::<Fixed>();
+        let repr = Repr::from(fixed);
+        assert_eq!(repr.words.len(), 2);
+        let error = FixedBits::<1>::try_from(Repr::from(fixed)).unwrap_err();
+        assert_eq!(error.requested, 100);
+        assert_eq!(Fixed::try_from(repr), Ok(fixed));
+    }
+}
@@ -0,0 +1,699 @@
+/*!
+A first-party, word-packed [BooleanVector] with explicit SIMD kernels.
+
+The bits are packed into [u64] words, which are themselves grouped into [Block]s of
+[WORDS_PER_BLOCK] words. The blocks are aligned to their size, so that the inner
+allocation of a [PackedBitVec] is always aligned for the widest load we use. The
+[xor_inplace](BooleanVector::xor_inplace) and [or_inplace](BooleanVector::or_inplace)
+methods, which are the hot path of basically every gate in
+[Frames](crate::tracker::frames::Frames), go through kernels that are selected at
+runtime via CPU feature detection:
+- x86(_64): AVX2 if available, otherwise the portable word kernel (which is
+  auto-vectorized with SSE2)
+- aarch64: NEON (always available on that target)
+- otherwise: the portable word kernel
+
+Use [detected_kernel] to check which kernel is used on the current machine.
+*/
+
+use std::{
+    borrow::Cow,
+    fmt::Debug,
+    slice,
+};
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use super::BooleanVector;
+
+/// The number of [u64] words in one [Block].
+pub const WORDS_PER_BLOCK: usize = 4;
+const WORD_BITS: usize = u64::BITS as usize;
+/// The number of bits in one [Block].
+pub const BLOCK_BITS: usize = WORDS_PER_BLOCK * WORD_BITS;
+
+/// A 256 bit chunk of a [PackedBitVec], aligned to 32 bytes so that it can be loaded
+/// into one AVX2 register (or two NEON registers).
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Default, Debug)]
+#[repr(C, align(32))]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct Block(pub [u64; WORDS_PER_BLOCK]);
+
+/// A word-packed bit-vector, cf. the [module](self) documentation.
+///
+/// This is the recommended [BooleanVector] for [PauliVec](crate::pauli::PauliVec), if
+/// one tracks many frames.
+///
+/// The type holds the invariant that all bits in the inner storage that are beyond
+/// [len](BooleanVector::len) are zero. Methods like [PackedBitVec::count_ones] and the
+/// [PartialEq] implementation rely on that.
+#[derive(Clone, PartialEq, Eq, Hash, Default, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct PackedBitVec {
+    blocks: Vec<Block>,
+    len: usize,
+}
+
+#[inline]
+fn num_blocks(len: usize) -> usize {
+    (len + BLOCK_BITS - 1) / BLOCK_BITS
+}
+
+#[inline]
+fn position(idx: usize) -> (usize, u64) {
+    (idx / WORD_BITS, 1 << (idx % WORD_BITS))
+}
+
+impl PackedBitVec {
+    /// Create a vector with `len` bits from the `words`, where the bit `i` is the bit
+    /// `i % 64` of the word `i / 64`. Missing words are filled with zeros and
+    /// superfluous bits are ignored.
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::boolean_vector::{
+    ///     packed::PackedBitVec,
+    ///     BooleanVector,
+    /// };
+    /// let vec = PackedBitVec::from_words(&[0b1101], 3);
+    /// assert_eq!(vec.iter_vals().collect::<Vec<_>>(), vec![true, false, true]);
+    /// # }
+    /// ```
+    pub fn from_words(words: &[u64], len: usize) -> Self {
+        let mut ret = Self::zeros(len);
+        let inner = ret.as_words_mut();
+        let num = inner.len().min(words.len());
+        inner[..num].copy_from_slice(&words[..num]);
+        ret.clear_tail();
+        ret
+    }
+
+    /// Get the bit at `idx`, or [None] if `idx` is out of bounds.
+    #[inline]
+    pub fn get(&self, idx: usize) -> Option<bool> {
+        if idx >= self.len {
+            return None;
+        }
+        let (word, mask) = position(idx);
+        Some(self.as_words()[word] & mask != 0)
+    }
+
+    /// Count the number of `true/1` elements.
+    pub fn count_ones(&self) -> usize {
+        self.as_words().iter().map(|w| w.count_ones() as usize).sum()
+    }
+
+    /// Get the inner storage as slice of words. The slice might be longer than
+    /// necessary to hold [len](BooleanVector::len) bits, but all the superfluous bits
+    /// are zero.
+    #[inline]
+    pub fn as_words(&self) -> &[u64] {
+        // Safety: Block is repr(C) around [u64; WORDS_PER_BLOCK], so the blocks are a
+        // contiguous and properly aligned array of u64s
+        unsafe {
+            slice::from_raw_parts(
+                self.blocks.as_ptr() as *const u64,
+                self.blocks.len() * WORDS_PER_BLOCK,
+            )
+        }
+    }
+
+    /// Get the inner storage as mutable slice of words, cf. [PackedBitVec::as_words].
+    ///
+    /// The caller should ensure that the bits beyond [len](BooleanVector::len) stay
+    /// zero; otherwise, the results of methods that rely on this invariant, e.g., the
+    /// [PartialEq] implementation, are unspecified (but it's not undefined behaviour).
+    #[inline]
+    pub fn as_words_mut(&mut self) -> &mut [u64] {
+        // Safety: cf. as_words
+        unsafe {
+            slice::from_raw_parts_mut(
+                self.blocks.as_mut_ptr() as *mut u64,
+                self.blocks.len() * WORDS_PER_BLOCK,
+            )
+        }
+    }
+
+    /// Get the inner storage as slice of [Block]s.
+    #[inline]
+    pub fn as_blocks(&self) -> &[Block] {
+        &self.blocks
+    }
+
+    fn clear_tail(&mut self) {
+        let len = self.len;
+        let words = self.as_words_mut();
+        let (word, _) = position(len);
+        if word < words.len() {
+            words[word] &= (1 << (len % WORD_BITS)) - 1;
+            for w in words[word + 1..].iter_mut() {
+                *w = 0;
+            }
+        }
+    }
+}
+
+impl BooleanVector for PackedBitVec {
+    type IterVals<'l> = Iter<'l>;
+
+    fn new() -> Self {
+        Self::default()
+    }
+
+    fn with_capacity(capacity: usize) -> Self {
+        Self {
+            blocks: Vec::with_capacity(num_blocks(capacity)),
+            len: 0,
+        }
+    }
+
+    fn reserve(&mut self, additional: usize) {
+        self.blocks
+            .reserve(num_blocks(self.len + additional) - self.blocks.len());
+    }
+
+    fn zeros(len: usize) -> Self {
+        Self {
+            blocks: vec![Block::default(); num_blocks(len)],
+            len,
+        }
+    }
+
+    fn set(&mut self, idx: usize, flag: bool) {
+        assert!(idx < self.len, "index {idx} out of bounds for length {}", self.len);
+        let (word, mask) = position(idx);
+        let word = &mut self.as_words_mut()[word];
+        if flag {
+            *word |= mask;
+        } else {
+            *word &= !mask;
+        }
+    }
+
+    fn xor_inplace(&mut self, rhs: &Self) {
+        check_len(self, rhs);
+        kernel::xor(&mut self.blocks, &rhs.blocks);
+    }
+
+    fn or_inplace(&mut self, rhs: &Self) {
+        check_len(self, rhs);
+        kernel::or(&mut self.blocks, &rhs.blocks);
+    }
+
+    fn and_inplace(&mut self, rhs: &Self) {
+        check_len(self, rhs);
+        kernel::and(&mut self.blocks, &rhs.blocks);
+    }
+
+    #[inline]
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.get(idx)
+    }
+
+    #[cfg(feature = "rayon")]
+    fn par_xor_inplace(&mut self, rhs: &Self) {
+        check_len(self, rhs);
+        kernel::par_xor(&mut self.blocks, &rhs.blocks);
+    }
+
+    fn resize(&mut self, len: usize, flag: bool) {
+        let old_len = self.len;
+        if len <= old_len {
+            self.blocks.truncate(num_blocks(len));
+            self.len = len;
+            self.clear_tail();
+            return;
+        }
+        self.blocks.resize(num_blocks(len), Block::default());
+        self.len = len;
+        if flag {
+            let words = self.as_words_mut();
+            let (first, _) = position(old_len);
+            let (last, _) = position(len - 1);
+            words[first] |= !((1 << (old_len % WORD_BITS)) - 1);
+            for w in words[first + 1..=last].iter_mut() {
+                *w = u64::MAX;
+            }
+            self.clear_tail();
+        }
+    }
+
+    fn push(&mut self, flag: bool) {
+        if self.len % BLOCK_BITS == 0 {
+            self.blocks.push(Block::default());
+        }
+        self.len += 1;
+        if flag {
+            self.set(self.len - 1, true);
+        }
+    }
+
+    fn extend_from_word(&mut self, word: u64, num: usize) {
+        assert!(num <= WORD_BITS, "a word has only 64 bits");
+        if num == 0 {
+            return;
+        }
+        let word = if num < WORD_BITS { word & ((1 << num) - 1) } else { word };
+        let old_len = self.len;
+        self.blocks.resize(num_blocks(old_len + num), Block::default());
+        self.len += num;
+        let words = self.as_words_mut();
+        let (idx, shift) = (old_len / WORD_BITS, old_len % WORD_BITS);
+        words[idx] |= word << shift;
+        if shift != 0 && shift + num > WORD_BITS {
+            words[idx + 1] |= word >> (WORD_BITS - shift);
+        }
+    }
+
+    #[inline]
+    fn to_words(&self) -> Cow<'_, [u64]> {
+        Cow::Borrowed(&self.as_words()[..(self.len + WORD_BITS - 1) / WORD_BITS])
+    }
+
+    #[inline]
+    fn get_word(&self, idx: usize) -> Option<u64> {
+        self.to_words().get(idx).copied()
+    }
+
+    fn pop(&mut self) -> Option<bool> {
+        let last = self.len.checked_sub(1)?;
+        let ret = self.get(last);
+        self.resize(last, false);
+        ret
+    }
+
+    #[inline]
+    fn len(&self) -> usize {
+        self.len
+    }
+
+    fn iter_vals(&self) -> Self::IterVals<'_> {
+        Iter { vec: self, current: 0 }
+    }
+
+    fn sum_up_filter(&self, filter: &Self) -> u8 {
+        let parity = self
+            .as_words()
+            .iter()
+            .zip(filter.as_words())
+            .fold(0, |parity, (word, mask)| parity ^ (word & mask).count_ones());
+        (parity & 1) as u8
+    }
+}
+
+fn check_len(lhs: &PackedBitVec, rhs: &PackedBitVec) {
+    assert_eq!(
+        lhs.len, rhs.len,
+        "left and right-hand side must have the same length"
+    );
+}
+
+impl FromIterator<bool> for PackedBitVec {
+    fn from_iter<T: IntoIterator<Item = bool>>(iter: T) -> Self {
+        let iter = iter.into_iter();
+        let mut ret = Self::with_capacity(iter.size_hint().0);
+        for flag in iter {
+            ret.push(flag);
+        }
+        ret
+    }
+}
+
+/// An [Iterator] over &[PackedBitVec]. Created with [BooleanVector::iter_vals].
+#[derive(Copy, Clone, PartialEq, Eq, Debug)]
+pub struct Iter<'l> {
+    vec: &'l PackedBitVec,
+    current: usize,
+}
+
+impl Iterator for Iter<'_> {
+    type Item = bool;
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        let ret = self.vec.get(self.current)?;
+        self.current += 1;
+        Some(ret)
+    }
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let rest = self.vec.len - self.current;
+        (rest, Some(rest))
+    }
+}
+impl ExactSizeIterator for Iter<'_> {}
+
+/// An [Iterator] over [PackedBitVec]. Created with [IntoIterator].
+#[derive(Clone, PartialEq, Eq, Debug)]
+pub struct IntoIter {
+    vec: PackedBitVec,
+    current: usize,
+}
+
+impl Iterator for IntoIter {
+    type Item = bool;
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        let ret = self.vec.get(self.current)?;
+        self.current += 1;
+        Some(ret)
+    }
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let rest = self.vec.len - self.current;
+        (rest, Some(rest))
+    }
+}
+impl ExactSizeIterator for IntoIter {}
+
+impl IntoIterator for PackedBitVec {
+    type Item = bool;
+    type IntoIter = IntoIter;
+    fn into_iter(self) -> Self::IntoIter {
+        IntoIter { vec: self, current: 0 }
+    }
+}
+
+/// Return the name of the kernel that is used for the elementwise operations on the
+/// current machine, i.e., "avx2", "neon" or "portable".
+pub fn detected_kernel() -> &'static str {
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    if is_x86_feature_detected!("avx2") {
+        return "avx2";
+    }
+    #[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+    {
+        return "neon";
+    }
+    #[allow(unreachable_code)]
+    "portable"
+}
+
+// AVX-512 intrinsics are not stable for our MSRV; the portable kernel is usually
+// auto-vectorized well enough if the code is compiled with target-cpu=native
+mod kernel {
+    use super::Block;
+
+    macro_rules! kernel {
+        ($($name:ident),*) => {$(
+            #[inline]
+            pub(super) fn $name(lhs: &mut [Block], rhs: &[Block]) {
+                debug_assert_eq!(lhs.len(), rhs.len());
+                #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+                if is_x86_feature_detected!("avx2") {
+                    // Safety: we just checked that avx2 is available
+                    unsafe { x86::$name(lhs, rhs) };
+                    return;
+                }
+                #[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+                {
+                    // Safety: neon is enabled at compile time
+                    unsafe { neon::$name(lhs, rhs) };
+                    return;
+                }
+                #[allow(unreachable_code)]
+                portable::$name(lhs, rhs)
+            }
+        )*};
+    }
+    kernel!(xor, or, and);
+
+    // below that many blocks (128 KiB) it's not worth to split the work
+    #[cfg(feature = "rayon")]
+    pub(super) const PAR_MIN_BLOCKS: usize = 1 << 12;
+
+    #[cfg(feature = "rayon")]
+    pub(super) fn par_xor(lhs: &mut [Block], rhs: &[Block]) {
+        if lhs.len() <= PAR_MIN_BLOCKS {
+            return xor(lhs, rhs);
+        }
+        let mid = lhs.len() / 2;
+        let (lhs_a, lhs_b) = lhs.split_at_mut(mid);
+        let (rhs_a, rhs_b) = rhs.split_at(mid);
+        rayon::join(|| par_xor(lhs_a, rhs_a), || par_xor(lhs_b, rhs_b));
+    }
+
+    pub(super) mod portable {
+        use super::Block;
+
+        macro_rules! portable {
+            ($(($name:ident, $op:tt),)*) => {$(
+                #[inline]
+                pub(crate) fn $name(lhs: &mut [Block], rhs: &[Block]) {
+                    for (l, r) in lhs.iter_mut().zip(rhs) {
+                        for (lw, rw) in l.0.iter_mut().zip(r.0) {
+                            *lw $op rw;
+                        }
+                    }
+                }
+            )*};
+        }
+        portable!((xor, ^=), (or, |=), (and, &=),);
+    }
+
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    mod x86 {
+        #[cfg(target_arch = "x86")]
+        use std::arch::x86::{
+            __m256i,
+            _mm256_and_si256,
+            _mm256_load_si256,
+            _mm256_or_si256,
+            _mm256_store_si256,
+            _mm256_xor_si256,
+        };
+        #[cfg(target_arch = "x86_64")]
+        use std::arch::x86_64::{
+            __m256i,
+            _mm256_and_si256,
+            _mm256_load_si256,
+            _mm256_or_si256,
+            _mm256_store_si256,
+            _mm256_xor_si256,
+        };
+
+        use super::Block;
+
+        macro_rules! avx2 {
+            ($(($name:ident, $intrinsic:ident),)*) => {$(
+                /// # Safety
+                ///
+                /// The CPU must support avx2.
+                #[target_feature(enable = "avx2")]
+                pub(super) unsafe fn $name(lhs: &mut [Block], rhs: &[Block]) {
+                    for (l, r) in lhs.iter_mut().zip(rhs) {
+                        let l = l as *mut Block as *mut __m256i;
+                        let r = r as *const Block as *const __m256i;
+                        // Safety: Blocks are 32 bytes wide and aligned to 32 bytes
+                        unsafe {
+                            _mm256_store_si256(
+                                l,
+                                $intrinsic(_mm256_load_si256(l), _mm256_load_si256(r)),
+                            )
+                        };
+                    }
+                }
+            )*};
+        }
+        avx2!(
+            (xor, _mm256_xor_si256),
+            (or, _mm256_or_si256),
+            (and, _mm256_and_si256),
+        );
+    }
+
+    #[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+    mod neon {
+        use std::arch::aarch64::{
+            vandq_u64,
+            veorq_u64,
+            vld1q_u64,
+            vorrq_u64,
+            vst1q_u64,
+        };
+
+        use super::Block;
+
+        macro_rules! neon {
+            ($(($name:ident, $intrinsic:ident),)*) => {$(
+                /// # Safety
+                ///
+                /// The CPU must support neon.
+                pub(super) unsafe fn $name(lhs: &mut [Block], rhs: &[Block]) {
+                    for (l, r) in lhs.iter_mut().zip(rhs) {
+                        let l = l.0.as_mut_ptr();
+                        let r = r.0.as_ptr();
+                        // Safety: a Block consists of two 128 bit lanes
+                        unsafe {
+                            vst1q_u64(l, $intrinsic(vld1q_u64(l), vld1q_u64(r)));
+                            vst1q_u64(
+                                l.add(2),
+                                $intrinsic(vld1q_u64(l.add(2)), vld1q_u64(r.add(2))),
+                            );
+                        }
+                    }
+                }
+            )*};
+        }
+        neon!((xor, veorq_u64), (or, vorrq_u64), (and, vandq_u64),);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+
+    // lengths around the word and block boundaries
+    const LENGTHS: [usize; 9] = [0, 1, 63, 64, 65, 255, 256, 257, 1000];
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn pattern(len: usize, seed: usize) -> Vec<bool> {
+        (0..len).map(|i| (i * 7 + seed) % 3 == 0).collect()
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn convert(vec: &PackedBitVec) -> Vec<bool> {
+        vec.iter_vals().collect()
+    }
+
+    #[test]
+    fn compare_with_vec() {
+        for len in LENGTHS {
+            let a = pattern(len, 0);
+            let b = pattern(len, 1);
+            let mut packed_a = a.iter().copied().collect::<PackedBitVec>();
+            let packed_b = b.iter().copied().collect::<PackedBitVec>();
+            assert_eq!(convert(&packed_a), a);
+            assert_eq!(packed_a.count_ones(), a.iter().filter(|e| **e).count());
+
+            let mut xor = a.clone();
+            xor.xor_inplace(&b);
+            packed_a.xor_inplace(&packed_b);
+            assert_eq!(convert(&packed_a), xor, "{len}");
+
+            let mut or = xor.clone();
+            or.or_inplace(&b);
+            packed_a.or_inplace(&packed_b);
+            assert_eq!(convert(&packed_a), or, "{len}");
+
+            let mut and = or.clone();
+            and.and_inplace(&a);
+            packed_a.and_inplace(&a.iter().copied().collect());
+            assert_eq!(convert(&packed_a), and, "{len}");
+            for idx in [0, len / 2, len] {
+                assert_eq!(packed_a.get_val(idx), and.get_val(idx), "{len}");
+            }
+
+            assert_eq!(packed_a.clone().into_iter().collect::<Vec<_>>(), and);
+
+            assert_eq!(packed_a.sum_up_filter(&packed_b), and.sum_up(&b), "{len}");
+            assert_eq!(packed_a.sum_up_filter(&packed_b), and.sum_up_filter(&b));
+        }
+    }
+
+    #[test]
+    fn resize_push_pop() {
+        for len in LENGTHS {
+            for new_len in LENGTHS {
+                for flag in [false, true] {
+                    let mut vec = pattern(len, 2);
+                    let mut packed = vec.iter().copied().collect::<PackedBitVec>();
+                    BooleanVector::resize(&mut vec, new_len, flag);
+                    packed.resize(new_len, flag);
+                    assert_eq!(convert(&packed), vec, "{len}, {new_len}, {flag}");
+                    assert_eq!(packed, vec.iter().copied().collect::<PackedBitVec>());
+                }
+            }
+        }
+
+        let mut vec = Vec::new();
+        let mut packed = PackedBitVec::new();
+        for i in 0..600 {
+            BooleanVector::push(&mut vec, i % 5 == 0);
+            packed.push(i % 5 == 0);
+        }
+        assert_eq!(convert(&packed), vec);
+        while let Some(flag) = BooleanVector::pop(&mut vec) {
+            assert_eq!(packed.pop(), Some(flag));
+        }
+        assert_eq!(packed.pop(), None);
+        assert!(packed.as_blocks().is_empty());
+    }
+
+    #[test]
+    fn extend_from_word() {
+        let mut vec = pattern(61, 3);
+        let mut packed = vec.iter().copied().collect::<PackedBitVec>();
+        for (word, num) in [(u64::MAX, 64), (0b1011, 3), (0, 0), (!0b1, 64), (7, 20)] {
+            vec.extend_from_word(word, num);
+            packed.extend_from_word(word, num);
+            assert_eq!(convert(&packed), vec, "{num}");
+        }
+        assert_eq!(packed, vec.iter().copied().collect::<PackedBitVec>());
+    }
+
+    #[test]
+    fn words() {
+        let packed = PackedBitVec::from_words(&[u64::MAX, u64::MAX], 70);
+        assert_eq!(packed.count_ones(), 70);
+        assert_eq!(packed.as_words()[..2], [u64::MAX, (1 << 6) - 1]);
+        assert_eq!(packed.as_words().len(), WORDS_PER_BLOCK);
+        assert_eq!(packed, PackedBitVec::from_iter([true; 70]));
+    }
+
+    #[test]
+    fn capacity() {
+        let mut packed = PackedBitVec::with_capacity(300);
+        assert!(packed.blocks.capacity() >= 2);
+        packed.push(true);
+        packed.reserve(600);
+        assert!(packed.blocks.capacity() >= 3);
+        packed.extend_zeros(400);
+        assert_eq!(packed.len(), 401);
+        assert_eq!(packed.count_ones(), 1);
+        packed.extend_zeros(0);
+        assert_eq!(packed.as_words().len(), 2 * WORDS_PER_BLOCK);
+    }
+
+    #[test]
+    fn kernel_matches_portable() {
+        let a = (0..5)
+            .map(|i| Block([i, i << 7, !i, i.wrapping_mul(0x9e3779b97f4a7c15)]))
+            .collect::<Vec<_>>();
+        let b = a.iter().rev().copied().collect::<Vec<_>>();
+        let (mut fast, mut slow) = (a.clone(), a.clone());
+        kernel::xor(&mut fast, &b);
+        kernel::portable::xor(&mut slow, &b);
+        assert_eq!(fast, slow);
+        kernel::or(&mut fast, &a);
+        kernel::portable::or(&mut slow, &a);
+        assert_eq!(fast, slow);
+        kernel::and(&mut fast, &b);
+        kernel::portable::and(&mut slow, &b);
+        assert_eq!(fast, slow);
+        assert!(["avx2", "neon", "portable"].contains(&detected_kernel()));
+    }
+
+    #[cfg(feature = "rayon")]
+    #[test]
+    fn par_xor() {
+        let len = 3 * kernel::PAR_MIN_BLOCKS * BLOCK_BITS + 17;
+        let a = (0..len).map(|i| i % 3 == 0).collect::<PackedBitVec>();
+        let b = (0..len).map(|i| i % 5 == 0).collect::<PackedBitVec>();
+        let (mut par, mut seq) = (a.clone(), a);
+        par.par_xor_inplace(&b);
+        seq.xor_inplace(&b);
+        assert_eq!(par, seq);
+    }
+
+    #[test]
+    #[should_panic]
+    fn xor_different_lengths() {
+        PackedBitVec::zeros(3).xor_inplace(&PackedBitVec::zeros(4));
+    }
+}
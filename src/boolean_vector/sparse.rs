@@ -0,0 +1,847 @@
+/*!
+A sparse [BooleanVector] for vectors that are mostly `false/0`.
+
+In many applications, e.g., MBQC, most qubits depend only on a few frames, so their
+Pauli stacks are mostly zeros. A [SparseBitVec] stores only the sorted indices of the
+`true/1` elements, as long as that needs less memory than the dense representation, and
+switches adaptively to a [PackedBitVec] (and back, e.g., when a growing vector gets
+sparse again) otherwise. The elementwise operations take advantage of the
+representations, e.g., XORing a sparse vector onto a dense one only flips the few set
+bits, and [sum_up](BooleanVector::sum_up) only looks at the set bits. Since
+[analyse::create_dependency_graph] and [PauliVec::sum_up] are implemented via these
+methods, their memory usage then scales with the number of set bits and not with the
+number of frames.
+
+[analyse::create_dependency_graph]: crate::analyse::create_dependency_graph
+[PauliVec::sum_up]: crate::pauli::PauliVec::sum_up
+*/
+
+use std::{
+    borrow::Cow,
+    iter::Peekable,
+    slice,
+    vec,
+};
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use super::{
+    packed::{
+        self,
+        PackedBitVec,
+    },
+    BooleanVector,
+};
+
+const WORD_BITS: usize = u64::BITS as usize;
+
+// an index needs one word, so the sparse representation needs less memory as long as
+// there are less than len / 64 set bits; we switch back only below len / 128 to avoid
+// switching back and forth; short vectors stay sparse, since a few indices are not
+// more expensive than the (block aligned) dense allocation, and otherwise the first set
+// bit of a growing vector would already densify it
+const MIN_DENSE_LEN: usize = 8 * WORD_BITS;
+#[inline]
+fn too_dense(ones: usize, len: usize) -> bool {
+    ones * WORD_BITS > len.max(MIN_DENSE_LEN)
+}
+#[inline]
+fn sparse_enough(ones: usize, len: usize) -> bool {
+    ones * 2 * WORD_BITS <= len.max(MIN_DENSE_LEN)
+}
+// counting the set bits of a dense vector costs len / 64 operations, so when the
+// vector grows, we recheck, whether it became sparse, only when the length crosses a
+// power of two, i.e., amortized constant time per element
+#[inline]
+fn crossed_power_of_two(old_len: usize, len: usize) -> bool {
+    old_len.leading_zeros() != len.leading_zeros()
+}
+
+#[derive(Clone, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+enum Repr {
+    // sorted indices of the set bits
+    Sparse(Vec<usize>),
+    Dense(PackedBitVec),
+}
+
+impl Repr {
+    fn contains(&self, idx: usize) -> bool {
+        match self {
+            Repr::Sparse(indices) => indices.binary_search(&idx).is_ok(),
+            Repr::Dense(dense) => dense.get(idx) == Some(true),
+        }
+    }
+}
+
+/// An adaptively sparse bit-vector, cf. the [module](self) documentation.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::boolean_vector::{
+///     sparse::SparseBitVec,
+///     BooleanVector,
+/// };
+/// let mut vec = SparseBitVec::zeros(1000);
+/// vec.set(3, true);
+/// vec.set(700, true);
+/// assert!(vec.is_sparse());
+/// assert_eq!(vec.ones().collect::<Vec<_>>(), vec![3, 700]);
+///
+/// let mut dense = (0..1000).map(|i| i % 2 == 0).collect::<SparseBitVec>();
+/// assert!(!dense.is_sparse());
+/// dense.xor_inplace(&vec);
+/// assert_eq!(dense.count_ones(), 500 - 1 + 1);
+/// # }
+/// ```
+#[derive(Clone, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct SparseBitVec {
+    len: usize,
+    repr: Repr,
+}
+
+impl Default for SparseBitVec {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl PartialEq for SparseBitVec {
+    fn eq(&self, other: &Self) -> bool {
+        if self.len != other.len {
+            return false;
+        }
+        match (&self.repr, &other.repr) {
+            (Repr::Sparse(l), Repr::Sparse(r)) => l == r,
+            (Repr::Dense(l), Repr::Dense(r)) => l == r,
+            _ => self.ones().eq(other.ones()),
+        }
+    }
+}
+
+impl Eq for SparseBitVec {}
+
+fn check_len(lhs: &SparseBitVec, rhs: &SparseBitVec) {
+    assert_eq!(
+        lhs.len, rhs.len,
+        "left and right-hand side must have the same length"
+    );
+}
+
+// the sorted symmetric difference or union of two sorted index lists
+fn merge(lhs: &[usize], rhs: &[usize], keep_common: bool) -> Vec<usize> {
+    let mut ret = Vec::with_capacity(lhs.len() + rhs.len());
+    let (mut l, mut r) = (0, 0);
+    while l < lhs.len() && r < rhs.len() {
+        match lhs[l].cmp(&rhs[r]) {
+            std::cmp::Ordering::Less => {
+                ret.push(lhs[l]);
+                l += 1;
+            }
+            std::cmp::Ordering::Greater => {
+                ret.push(rhs[r]);
+                r += 1;
+            }
+            std::cmp::Ordering::Equal => {
+                if keep_common {
+                    ret.push(lhs[l]);
+                }
+                l += 1;
+                r += 1;
+            }
+        }
+    }
+    ret.extend_from_slice(&lhs[l..]);
+    ret.extend_from_slice(&rhs[r..]);
+    ret
+}
+
+impl SparseBitVec {
+    /// Create a vector with `len` elements, where the elements at the `indices` are
+    /// `true/1`.
+    ///
+    /// # Panics
+    /// Panics if an index is out of bounds.
+    pub fn from_indices(indices: impl IntoIterator<Item = usize>, len: usize) -> Self {
+        let mut indices: Vec<usize> = indices.into_iter().collect();
+        indices.sort_unstable();
+        indices.dedup();
+        if let Some(last) = indices.last() {
+            assert!(*last < len, "index {last} out of bounds for length {len}");
+        }
+        let mut ret = Self { len, repr: Repr::Sparse(indices) };
+        ret.adapt();
+        ret
+    }
+
+    /// Check whether the vector is currently stored sparsely.
+    pub fn is_sparse(&self) -> bool {
+        matches!(self.repr, Repr::Sparse(_))
+    }
+
+    /// Count the number of `true/1` elements.
+    pub fn count_ones(&self) -> usize {
+        match &self.repr {
+            Repr::Sparse(indices) => indices.len(),
+            Repr::Dense(dense) => dense.count_ones(),
+        }
+    }
+
+    /// Iterate over the indices of the `true/1` elements, in increasing order.
+    pub fn ones(&self) -> Ones<'_> {
+        let inner = match &self.repr {
+            Repr::Sparse(indices) => OnesInner::Sparse(indices.iter()),
+            Repr::Dense(dense) => OnesInner::Dense {
+                words: dense.as_words(),
+                idx: 0,
+                current: dense.as_words().first().copied().unwrap_or(0),
+            },
+        };
+        Ones { inner }
+    }
+
+    // switch to the sparse representation if it's too dense, and vice versa
+    fn adapt(&mut self) {
+        let dense = match &self.repr {
+            Repr::Sparse(indices) => too_dense(indices.len(), self.len),
+            Repr::Dense(dense) => !sparse_enough(dense.count_ones(), self.len),
+        };
+        match (&self.repr, dense) {
+            (Repr::Sparse(_), true) => {
+                self.densify();
+            }
+            (Repr::Dense(_), false) => {
+                let indices = self.ones().collect();
+                self.repr = Repr::Sparse(indices);
+            }
+            _ => {}
+        }
+    }
+
+    fn densify(&mut self) -> &mut PackedBitVec {
+        if let Repr::Sparse(indices) = &self.repr {
+            let mut dense = PackedBitVec::zeros(self.len);
+            let words = dense.as_words_mut();
+            for idx in indices.iter() {
+                words[idx / WORD_BITS] |= 1 << (idx % WORD_BITS);
+            }
+            self.repr = Repr::Dense(dense);
+        }
+        match &mut self.repr {
+            Repr::Dense(dense) => dense,
+            Repr::Sparse(_) => unreachable!(),
+        }
+    }
+
+    fn inplace(&mut self, rhs: &Self, xor: bool) {
+        check_len(self, rhs);
+        match (&mut self.repr, &rhs.repr) {
+            (Repr::Sparse(lhs), Repr::Sparse(rhs)) => {
+                *lhs = merge(lhs, rhs, !xor);
+                if too_dense(lhs.len(), self.len) {
+                    self.densify();
+                }
+            }
+            // this is the cheap case: only the few set bits of rhs have to be touched;
+            // we check whether the result is sparse only if a set bit was cleared,
+            // since otherwise the number of set bits did not decrease
+            (Repr::Dense(lhs), Repr::Sparse(rhs)) => {
+                let words = lhs.as_words_mut();
+                let mut cleared = false;
+                for idx in rhs {
+                    let (word, mask) = (idx / WORD_BITS, 1 << (idx % WORD_BITS));
+                    if xor {
+                        cleared |= words[word] & mask != 0;
+                        words[word] ^= mask;
+                    } else {
+                        words[word] |= mask;
+                    }
+                }
+                if cleared {
+                    self.adapt();
+                }
+            }
+            (Repr::Sparse(_), Repr::Dense(_)) => {
+                let mut ret = rhs.clone();
+                ret.inplace(self, xor);
+                *self = ret;
+            }
+            (Repr::Dense(lhs), Repr::Dense(rhs)) => {
+                if xor {
+                    lhs.xor_inplace(rhs);
+                    // the xor might have canceled most bits
+                    self.adapt();
+                } else {
+                    lhs.or_inplace(rhs);
+                }
+            }
+        }
+    }
+}
+
+impl BooleanVector for SparseBitVec {
+    type IterVals<'l> = Iter<'l>;
+
+    fn new() -> Self {
+        Self {
+            len: 0,
+            repr: Repr::Sparse(Vec::new()),
+        }
+    }
+
+    fn reserve(&mut self, additional: usize) {
+        if let Repr::Dense(dense) = &mut self.repr {
+            dense.reserve(additional);
+        }
+    }
+
+    fn zeros(len: usize) -> Self {
+        Self {
+            len,
+            repr: Repr::Sparse(Vec::new()),
+        }
+    }
+
+    fn set(&mut self, idx: usize, flag: bool) {
+        assert!(idx < self.len, "index {idx} out of bounds for length {}", self.len);
+        match &mut self.repr {
+            Repr::Sparse(indices) => match (indices.binary_search(&idx), flag) {
+                (Ok(position), false) => {
+                    indices.remove(position);
+                }
+                (Err(position), true) => {
+                    indices.insert(position, idx);
+                    if too_dense(indices.len(), self.len) {
+                        self.densify();
+                    }
+                }
+                _ => {}
+            },
+            Repr::Dense(dense) => dense.set(idx, flag),
+        }
+    }
+
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        (idx < self.len).then(|| self.repr.contains(idx))
+    }
+
+    fn xor_inplace(&mut self, rhs: &Self) {
+        self.inplace(rhs, true)
+    }
+
+    fn or_inplace(&mut self, rhs: &Self) {
+        self.inplace(rhs, false)
+    }
+
+    // the AND has at most as many set bits as the sparser side, so a sparse side stays
+    // (or becomes) the result
+    fn and_inplace(&mut self, rhs: &Self) {
+        check_len(self, rhs);
+        match (&mut self.repr, &rhs.repr) {
+            (Repr::Sparse(lhs), Repr::Sparse(rhs)) => {
+                let mut rhs = rhs.iter().peekable();
+                lhs.retain(|idx| {
+                    while rhs.next_if(|r| *r < idx).is_some() {}
+                    rhs.peek() == Some(&idx)
+                });
+            }
+            (Repr::Sparse(lhs), rhs @ Repr::Dense(_)) => {
+                lhs.retain(|idx| rhs.contains(*idx));
+            }
+            (lhs @ Repr::Dense(_), Repr::Sparse(rhs)) => {
+                let indices =
+                    rhs.iter().copied().filter(|idx| lhs.contains(*idx)).collect();
+                *lhs = Repr::Sparse(indices);
+            }
+            (Repr::Dense(lhs), Repr::Dense(rhs)) => {
+                lhs.and_inplace(rhs);
+                // the and might have cleared most bits
+                self.adapt();
+            }
+        }
+    }
+
+    fn resize(&mut self, len: usize, flag: bool) {
+        let old_len = self.len;
+        self.len = len;
+        match &mut self.repr {
+            Repr::Sparse(indices) => {
+                if len <= old_len {
+                    indices.truncate(indices.partition_point(|idx| *idx < len));
+                } else if flag {
+                    if too_dense(indices.len() + len - old_len, len) {
+                        self.len = old_len;
+                        self.densify().resize(len, flag);
+                        self.len = len;
+                    } else {
+                        indices.extend(old_len..len);
+                    }
+                }
+            }
+            Repr::Dense(dense) => {
+                dense.resize(len, flag);
+                if len < old_len || (!flag && crossed_power_of_two(old_len, len)) {
+                    self.adapt();
+                }
+            }
+        }
+    }
+
+    fn push(&mut self, flag: bool) {
+        match &mut self.repr {
+            Repr::Sparse(indices) => {
+                if flag {
+                    indices.push(self.len);
+                }
+                self.len += 1;
+                if flag && too_dense(indices.len(), self.len) {
+                    self.densify();
+                }
+            }
+            Repr::Dense(dense) => {
+                dense.push(flag);
+                self.len += 1;
+                if crossed_power_of_two(self.len - 1, self.len) {
+                    self.adapt();
+                }
+            }
+        }
+    }
+
+    fn extend_from_word(&mut self, word: u64, num: usize) {
+        assert!(num <= 64, "a word has only 64 bits");
+        match &mut self.repr {
+            Repr::Sparse(indices) => {
+                let mut rest = if num == 64 { word } else { word & ((1 << num) - 1) };
+                while rest != 0 {
+                    indices.push(self.len + rest.trailing_zeros() as usize);
+                    rest &= rest - 1;
+                }
+                self.len += num;
+                if too_dense(indices.len(), self.len) {
+                    self.densify();
+                }
+            }
+            Repr::Dense(dense) => {
+                dense.extend_from_word(word, num);
+                self.len += num;
+                if crossed_power_of_two(self.len - num, self.len) {
+                    self.adapt();
+                }
+            }
+        }
+    }
+
+    fn to_words(&self) -> Cow<'_, [u64]> {
+        match &self.repr {
+            Repr::Sparse(indices) => {
+                let mut words = vec![0; (self.len + WORD_BITS - 1) / WORD_BITS];
+                for idx in indices {
+                    words[idx / WORD_BITS] |= 1 << (idx % WORD_BITS);
+                }
+                Cow::Owned(words)
+            }
+            Repr::Dense(dense) => dense.to_words(),
+        }
+    }
+
+    fn get_word(&self, idx: usize) -> Option<u64> {
+        let start = idx.checked_mul(WORD_BITS).filter(|start| *start < self.len)?;
+        match &self.repr {
+            Repr::Sparse(indices) => {
+                let first = indices.partition_point(|i| *i < start);
+                Some(
+                    indices[first..]
+                        .iter()
+                        .take_while(|i| **i < start + WORD_BITS)
+                        .fold(0, |word, i| word | 1 << (i % WORD_BITS)),
+                )
+            }
+            Repr::Dense(dense) => dense.get_word(idx),
+        }
+    }
+
+    fn pop(&mut self) -> Option<bool> {
+        if self.len == 0 {
+            return None;
+        }
+        self.len -= 1;
+        match &mut self.repr {
+            Repr::Sparse(indices) => {
+                if indices.last() == Some(&self.len) {
+                    indices.pop();
+                    Some(true)
+                } else {
+                    Some(false)
+                }
+            }
+            Repr::Dense(dense) => dense.pop(),
+        }
+    }
+
+    #[inline]
+    fn len(&self) -> usize {
+        self.len
+    }
+
+    fn iter_vals(&self) -> Self::IterVals<'_> {
+        match &self.repr {
+            Repr::Sparse(indices) => Iter {
+                inner: IterInner::Sparse(indices.iter().peekable()),
+                current: 0,
+                len: self.len,
+            },
+            Repr::Dense(dense) => Iter {
+                inner: IterInner::Dense(dense.iter_vals()),
+                current: 0,
+                len: self.len,
+            },
+        }
+    }
+
+    fn sum_up(&self, filter: &[bool]) -> u8 {
+        match &self.repr {
+            Repr::Sparse(indices) => {
+                (indices.iter().filter(|idx| filter[**idx]).count() % 2) as u8
+            }
+            Repr::Dense(dense) => dense.sum_up(filter),
+        }
+    }
+
+    fn sum_up_filter(&self, filter: &Self) -> u8 {
+        let count = match (&self.repr, &filter.repr) {
+            (Repr::Dense(dense), Repr::Dense(mask)) => {
+                return dense.sum_up_filter(mask);
+            }
+            (Repr::Sparse(indices), other) | (other, Repr::Sparse(indices)) => {
+                indices.iter().filter(|idx| other.contains(**idx)).count()
+            }
+        };
+        (count % 2) as u8
+    }
+}
+
+impl FromIterator<bool> for SparseBitVec {
+    fn from_iter<T: IntoIterator<Item = bool>>(iter: T) -> Self {
+        let mut ret = Self::new();
+        for flag in iter {
+            ret.push(flag);
+        }
+        // a dense vector is only checked for sparsity when its length crosses a power
+        // of two while pushing, so we check it once more for the final length
+        ret.adapt();
+        ret
+    }
+}
+
+/// An [Iterator] over the indices of the set bits of a [SparseBitVec]. Created with
+/// [SparseBitVec::ones].
+#[derive(Clone, Debug)]
+pub struct Ones<'l> {
+    inner: OnesInner<'l>,
+}
+
+#[derive(Clone, Debug)]
+enum OnesInner<'l> {
+    Sparse(slice::Iter<'l, usize>),
+    Dense {
+        words: &'l [u64],
+        idx: usize,
+        current: u64,
+    },
+}
+
+impl Iterator for Ones<'_> {
+    type Item = usize;
+    fn next(&mut self) -> Option<Self::Item> {
+        match &mut self.inner {
+            OnesInner::Sparse(iter) => iter.next().copied(),
+            OnesInner::Dense { words, idx, current } => {
+                while *current == 0 {
+                    *idx += 1;
+                    *current = *words.get(*idx)?;
+                }
+                let ret = *idx * WORD_BITS + current.trailing_zeros() as usize;
+                *current &= *current - 1;
+                Some(ret)
+            }
+        }
+    }
+}
+
+#[derive(Clone, Debug)]
+enum IterInner<'l> {
+    Sparse(Peekable<slice::Iter<'l, usize>>),
+    Dense(packed::Iter<'l>),
+}
+
+/// An [Iterator] over &[SparseBitVec]. Created with [BooleanVector::iter_vals].
+#[derive(Clone, Debug)]
+pub struct Iter<'l> {
+    inner: IterInner<'l>,
+    current: usize,
+    len: usize,
+}
+
+impl Iterator for Iter<'_> {
+    type Item = bool;
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.current == self.len {
+            return None;
+        }
+        let ret = match &mut self.inner {
+            IterInner::Sparse(indices) => indices.next_if_eq(&&self.current).is_some(),
+            IterInner::Dense(iter) => iter.next()?,
+        };
+        self.current += 1;
+        Some(ret)
+    }
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let rest = self.len - self.current;
+        (rest, Some(rest))
+    }
+}
+impl ExactSizeIterator for Iter<'_> {}
+
+#[derive(Clone, Debug)]
+enum IntoIterInner {
+    Sparse(Peekable<vec::IntoIter<usize>>),
+    Dense(packed::IntoIter),
+}
+
+/// An [Iterator] over [SparseBitVec]. Created with [IntoIterator].
+#[derive(Clone, Debug)]
+pub struct IntoIter {
+    inner: IntoIterInner,
+    current: usize,
+    len: usize,
+}
+
+impl Iterator for IntoIter {
+    type Item = bool;
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.current == self.len {
+            return None;
+        }
+        let ret = match &mut self.inner {
+            IntoIterInner::Sparse(indices) => {
+                indices.next_if_eq(&self.current).is_some()
+            }
+            IntoIterInner::Dense(iter) => iter.next()?,
+        };
+        self.current += 1;
+        Some(ret)
+    }
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let rest = self.len - self.current;
+        (rest, Some(rest))
+    }
+}
+impl ExactSizeIterator for IntoIter {}
+
+impl IntoIterator for SparseBitVec {
+    type Item = bool;
+    type IntoIter = IntoIter;
+    fn into_iter(self) -> Self::IntoIter {
+        let inner = match self.repr {
+            Repr::Sparse(indices) => {
+                IntoIterInner::Sparse(indices.into_iter().peekable())
+            }
+            Repr::Dense(dense) => IntoIterInner::Dense(dense.into_iter()),
+        };
+        IntoIter { inner, current: 0, len: self.len }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn bits(len: usize, period: usize, offset: usize) -> Vec<bool> {
+        (0..len).map(|i| (i + offset) % period == 0).collect()
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn check(sparse: &SparseBitVec, expected: &[bool]) {
+        assert_eq!(sparse.len(), expected.len());
+        assert_eq!(sparse.iter_vals().collect::<Vec<_>>(), expected);
+        assert_eq!(sparse.clone().into_iter().collect::<Vec<_>>(), expected);
+        assert_eq!(
+            sparse.ones().collect::<Vec<_>>(),
+            (0..expected.len()).filter(|i| expected[*i]).collect::<Vec<_>>()
+        );
+        for (idx, flag) in expected.iter().enumerate() {
+            assert_eq!(sparse.get_val(idx), Some(*flag));
+        }
+        assert_eq!(sparse.get_val(expected.len()), None);
+        let expected = expected.to_vec();
+        let words = expected.to_words();
+        for (idx, word) in words.iter().enumerate() {
+            assert_eq!(sparse.get_word(idx), Some(*word));
+            assert_eq!(expected.get_word(idx), Some(*word));
+        }
+        assert_eq!(sparse.get_word(words.len()), None);
+    }
+
+    #[test]
+    fn compare_with_vec() {
+        let len = 1000;
+        // (period, expected sparse)
+        let cases = [(500, true), (3, false), (70, true), (2, false)];
+        for (i, (period_a, sparse_a)) in cases.into_iter().enumerate() {
+            let a = bits(len, period_a, i);
+            let sparse = a.iter().copied().collect::<SparseBitVec>();
+            assert_eq!(sparse.is_sparse(), sparse_a);
+            check(&sparse, &a);
+            for (j, (period_b, _)) in cases.into_iter().enumerate() {
+                let b = bits(len, period_b, j);
+                let rhs = b.iter().copied().collect::<SparseBitVec>();
+
+                let (mut xor, mut expected) = (sparse.clone(), a.clone());
+                xor.xor_inplace(&rhs);
+                expected.xor_inplace(&b);
+                check(&xor, &expected);
+
+                let (mut or, mut expected) = (sparse.clone(), a.clone());
+                or.or_inplace(&rhs);
+                expected.or_inplace(&b);
+                check(&or, &expected);
+
+                let (mut and, mut expected) = (sparse.clone(), a.clone());
+                and.and_inplace(&rhs);
+                expected.and_inplace(&b);
+                check(&and, &expected);
+
+                let filter = bits(len, period_b, j + 1);
+                assert_eq!(sparse.sum_up(&filter), a.sum_up(&filter));
+                let mask = filter.iter().copied().collect::<SparseBitVec>();
+                assert_eq!(sparse.sum_up_filter(&mask), a.sum_up(&filter));
+                assert_eq!(mask.sum_up_filter(&sparse), a.sum_up(&filter));
+            }
+        }
+    }
+
+    #[test]
+    fn adapt() {
+        let mut vec = SparseBitVec::zeros(640);
+        for i in 0..10 {
+            vec.set(i * 64, true);
+        }
+        assert!(vec.is_sparse());
+        vec.set(1, true);
+        assert!(!vec.is_sparse());
+        let copy = vec.clone();
+        vec.xor_inplace(&copy);
+        assert!(vec.is_sparse());
+        assert_eq!(vec, SparseBitVec::zeros(640));
+        assert_eq!(
+            SparseBitVec::from_indices([3, 1, 3], 10),
+            [false, true, false, true]
+                .into_iter()
+                .chain([false; 6])
+                .collect::<SparseBitVec>()
+        );
+    }
+
+    #[test]
+    fn resize_push_pop() {
+        for period in [1, 100] {
+            let mut sparse = bits(300, period, 0).into_iter().collect::<SparseBitVec>();
+            let mut expected = bits(300, period, 0);
+            for (len, flag) in [(310, false), (200, true), (400, true), (3, false)] {
+                sparse.resize(len, flag);
+                expected.resize(len, flag);
+                check(&sparse, &expected);
+            }
+            sparse.extend_from_word(0b1011 | 1 << 63, 64);
+            expected.extend_from_word(0b1011 | 1 << 63, 64);
+            sparse.extend_from_word(u64::MAX, 5);
+            expected.extend_from_word(u64::MAX, 5);
+            sparse.push(true);
+            expected.push(true);
+            check(&sparse, &expected);
+            while let Some(flag) = expected.pop() {
+                assert_eq!(sparse.pop(), Some(flag));
+            }
+            assert_eq!(sparse.pop(), None);
+        }
+    }
+
+    #[test]
+    fn frames_growth() {
+        use crate::tracker::{
+            frames::{
+                storage::{
+                    StackStorage,
+                    Vector,
+                },
+                Frames,
+            },
+            Tracker,
+        };
+        let mut frames = Frames::<Vector<SparseBitVec>>::init(4);
+        // qubit 1 gets many Paulis early, so it's dense at first
+        frames.track_x(0);
+        for _ in 0..500 {
+            frames.track_x(1);
+        }
+        assert!(!frames.as_storage().get(1).unwrap().left.is_sparse());
+        for _ in 0..99_500 {
+            frames.track_x(2);
+        }
+        frames.cx(1, 3);
+        let storage = frames.as_storage();
+        let stack = |bit| &storage.get(bit).unwrap().left;
+        assert_eq!(stack(0).len(), 100_001);
+        assert_eq!(stack(0).count_ones(), 1);
+        assert!(stack(0).is_sparse());
+        assert!(stack(1).is_sparse());
+        assert!(!stack(2).is_sparse());
+        assert!(stack(3).is_sparse());
+        assert_eq!(stack(3).count_ones(), 500);
+        assert!(storage.get(0).unwrap().right.is_sparse());
+    }
+
+    #[cfg(feature = "analyse")]
+    #[test]
+    fn dependency_graph() {
+        use crate::{
+            analyse::create_dependency_graph,
+            pauli::PauliVec,
+            tracker::frames::storage::{
+                StackStorage,
+                Vector,
+            },
+        };
+        let frames = [("", ""), ("10", "00"), ("01", "10"), ("1", "0")];
+        let sparse = Vector {
+            frames: frames
+                .iter()
+                .map(|(l, r)| PauliVec::<SparseBitVec>::try_from_str(l, r).unwrap())
+                .collect(),
+        };
+        let dense = Vector {
+            frames: frames
+                .iter()
+                .map(|(l, r)| PauliVec::<Vec<bool>>::try_from_str(l, r).unwrap())
+                .collect(),
+        };
+        let map = [0, 3];
+        assert_eq!(
+            create_dependency_graph(sparse.iter(), &map),
+            create_dependency_graph(dense.iter(), &map)
+        );
+    }
+}
@@ -14,6 +14,14 @@ impl BooleanVector for Vec<bool> {
         Vec::new()
     }
 
+    fn with_capacity(capacity: usize) -> Self {
+        Vec::with_capacity(capacity)
+    }
+
+    fn reserve(&mut self, additional: usize) {
+        self.reserve(additional)
+    }
+
     fn zeros(len: usize) -> Self {
         vec![false; len]
     }
@@ -22,6 +30,10 @@ impl BooleanVector for Vec<bool> {
         *self.get_mut(idx).unwrap() = flag;
     }
 
+    fn get_val(&self, idx: usize) -> Option<bool> {
+        self.get(idx).copied()
+    }
+
     fn xor_inplace(&mut self, rhs: &Self) {
         check_len(self, rhs);
         for (l, r) in self.iter_mut().zip(rhs) {
@@ -36,6 +48,13 @@ impl BooleanVector for Vec<bool> {
         }
     }
 
+    fn and_inplace(&mut self, rhs: &Self) {
+        check_len(self, rhs);
+        for (l, r) in self.iter_mut().zip(rhs) {
+            *l &= r;
+        }
+    }
+
     fn resize(&mut self, len: usize, flag: bool) {
         self.resize(len, flag);
     }
@@ -55,6 +74,11 @@ impl BooleanVector for Vec<bool> {
     fn iter_vals(&self) -> Self::IterVals<'_> {
         self.iter().copied()
     }
+
+    fn get_word(&self, idx: usize) -> Option<u64> {
+        let chunk = self.chunks(64).nth(idx)?;
+        Some(chunk.iter().rev().fold(0, |word, flag| word << 1 | *flag as u64))
+    }
 }
 
 fn check_len<T>(lhs: &[T], rhs: &[T]) {
@@ -8,8 +8,6 @@ directly by providing an appropriate circuit simulator (should implement
 provides two pseudo circuit simulators that can be used to test the Pauli tracking.
 */
 
-use std::mem;
-
 use crate::tracker::{
     frames::{
         storage::StackStorage,
@@ -42,6 +40,73 @@ pub trait CliffordCircuit {
     fn cx(&mut self, control: usize, target: usize);
     /// Apply the **Control Z** gate
     fn cz(&mut self, bit_a: usize, bit_b: usize);
+    /// Apply the **S dagger** gate; by default as S·S·S
+    #[inline]
+    fn sdg(&mut self, bit: usize) {
+        self.s(bit);
+        self.s(bit);
+        self.s(bit);
+    }
+    /// Apply the **square root of X** gate; by default as H·S·H
+    #[inline]
+    fn sx(&mut self, bit: usize) {
+        self.h(bit);
+        self.s(bit);
+        self.h(bit);
+    }
+    /// Apply the **inverse of the square root of X** gate; by default as H·S†·H
+    #[inline]
+    fn sxdg(&mut self, bit: usize) {
+        self.h(bit);
+        self.sdg(bit);
+        self.h(bit);
+    }
+    /// Apply the **square root of Y** gate; by default as Z followed by H
+    #[inline]
+    fn sy(&mut self, bit: usize) {
+        self.z(bit);
+        self.h(bit);
+    }
+    /// Apply the **inverse of the square root of Y** gate; by default as H followed by Z
+    #[inline]
+    fn sydg(&mut self, bit: usize) {
+        self.h(bit);
+        self.z(bit);
+    }
+    /// Apply the **SWAP** gate; by default with three CX gates
+    #[inline]
+    fn swap(&mut self, bit_a: usize, bit_b: usize) {
+        self.cx(bit_a, bit_b);
+        self.cx(bit_b, bit_a);
+        self.cx(bit_a, bit_b);
+    }
+    /// Apply the **Control Y** gate; by default as CX conjugated with S on the `target`
+    #[inline]
+    fn cy(&mut self, control: usize, target: usize) {
+        self.sdg(target);
+        self.cx(control, target);
+        self.s(target);
+    }
+    /// Apply the **iSWAP** gate; by default with H, CX and S gates
+    #[inline]
+    fn iswap(&mut self, bit_a: usize, bit_b: usize) {
+        self.h(bit_a);
+        self.cx(bit_a, bit_b);
+        self.cx(bit_b, bit_a);
+        self.h(bit_b);
+        self.s(bit_a);
+        self.s(bit_b);
+    }
+    /// Apply the **inverse of the iSWAP** gate; by default with H, CX and S† gates
+    #[inline]
+    fn iswapdg(&mut self, bit_a: usize, bit_b: usize) {
+        self.sdg(bit_a);
+        self.sdg(bit_b);
+        self.h(bit_b);
+        self.cx(bit_b, bit_a);
+        self.cx(bit_a, bit_b);
+        self.h(bit_a);
+    }
     /// **Measure** (unspecified)
     fn measure(&mut self, bit: usize) -> Self::Outcome;
 }
@@ -50,6 +115,10 @@ mod dummy;
 pub use dummy::DummyCircuit;
 mod random_measurement;
 pub use random_measurement::RandomMeasurementCircuit;
+mod batched_random_measurement;
+pub use batched_random_measurement::BatchedRandomMeasurementCircuit;
+mod peephole;
+pub use peephole::Peephole;
 
 /// A Wrapper around a Clifford circuit (simulator) and a Pauli tracker.
 ///
@@ -59,6 +128,9 @@ pub use random_measurement::RandomMeasurementCircuit;
 /// The type can be used to build up the underlining circuit, while keeping track of the
 /// Pauli gates that shall be extracted from the (quantum) simulation, e.g., the Pauli
 /// corrections in [MBQC](https://doi.org/10.48550/arXiv.0910.1116).
+///
+/// To cancel and merge redundant gates before they reach the tracker, wrap the tracker
+/// into a [Peephole] buffer.
 #[derive(Clone, PartialEq, Eq, PartialOrd, Ord, Hash, Default, Debug)]
 pub struct TrackedCircuit<Circuit, Tracker, Storage> {
     /// The underlining circuit (simulator). Should implement [CliffordCircuit]
@@ -253,10 +325,22 @@ where
     C: CliffordCircuit,
     T: Tracker,
 {
-    single_gate!((h, "H"), (s, "S"),);
+    single_gate!(
+        (h, "H"),
+        (s, "S"),
+        (sdg, "S dagger"),
+        (sx, "square root of X"),
+        (sxdg, "inverse of the square root of X"),
+        (sy, "square root of Y"),
+        (sydg, "inverse of the square root of Y"),
+    );
 
     double_gate!(cx, "Control X (Control Not)", control, target);
     double_gate!(cz, "Control Z");
+    double_gate!(swap, "SWAP");
+    double_gate!(cy, "Control Y", control, target);
+    double_gate!(iswap, "iSWAP");
+    double_gate!(iswapdg, "inverse iSWAP");
 }
 
 impl<C, A, S> TrackedCircuit<C, Frames<A>, S>
@@ -272,11 +356,7 @@ where
         &mut self,
         bit: usize,
     ) -> (C::Outcome, Result<(), StoreError<S::BoolVec>>) {
-        let outcome = self.circuit.measure(bit);
-        match self.tracker.measure_and_store(bit, &mut self.storage) {
-            Ok(_) => (outcome, Ok(())),
-            Err(e) => (outcome, Err(e)),
-        }
+        measure_and_store(&mut self.circuit, &mut self.tracker, &mut self.storage, bit)
     }
 
     /// Measure all remaining qubits and put the according stack of Paulis into the
@@ -287,20 +367,84 @@ where
     pub fn measure_and_store_all(
         &mut self,
     ) -> (Vec<(usize, C::Outcome)>, Result<(), OverwriteStack<S::BoolVec>>) {
-        let mut outcome = Vec::<(usize, C::Outcome)>::new();
-        let num_frames = self.tracker.frames_num();
-        let mut storage = mem::replace(&mut self.tracker, Frames::<A>::init(0))
-            .into_storage()
-            .into_iter();
-        while let Some((bit, pauli)) = storage.next() {
-            outcome.push((bit, self.circuit.measure(bit)));
-            if let Some(stack) = self.storage.insert_pauli(bit, pauli) {
-                self.tracker = Frames::new(storage.collect(), num_frames);
-                return (outcome, Err(OverwriteStack { bit, stack }));
-            }
+        measure_and_store_all(&mut self.circuit, &mut self.tracker, &mut self.storage)
+    }
+}
+
+impl<C, A, S> TrackedCircuit<C, Peephole<Frames<A>>, S>
+where
+    C: CliffordCircuit,
+    A: StackStorage,
+    S: StackStorage<BoolVec = A::BoolVec>,
+{
+    /// Like [TrackedCircuit::measure_and_store] without the [Peephole] buffer; the
+    /// pending gates on the qu`bit` are applied before.
+    pub fn measure_and_store(
+        &mut self,
+        bit: usize,
+    ) -> (C::Outcome, Result<(), StoreError<S::BoolVec>>) {
+        self.tracker.flush_qubit(bit);
+        measure_and_store(
+            &mut self.circuit,
+            self.tracker.unflushed_mut(),
+            &mut self.storage,
+            bit,
+        )
+    }
+
+    /// Like [TrackedCircuit::measure_and_store_all] without the [Peephole] buffer; all
+    /// pending gates are applied before.
+    #[allow(clippy::type_complexity)] // cos Result is basically two types
+    pub fn measure_and_store_all(
+        &mut self,
+    ) -> (Vec<(usize, C::Outcome)>, Result<(), OverwriteStack<S::BoolVec>>) {
+        measure_and_store_all(
+            &mut self.circuit,
+            self.tracker.tracker_mut(),
+            &mut self.storage,
+        )
+    }
+}
+
+fn measure_and_store<C, A, S>(
+    circuit: &mut C,
+    tracker: &mut Frames<A>,
+    storage: &mut S,
+    bit: usize,
+) -> (C::Outcome, Result<(), StoreError<S::BoolVec>>)
+where
+    C: CliffordCircuit,
+    A: StackStorage,
+    S: StackStorage<BoolVec = A::BoolVec>,
+{
+    let outcome = circuit.measure(bit);
+    match tracker.measure_and_store(bit, storage) {
+        Ok(_) => (outcome, Ok(())),
+        Err(e) => (outcome, Err(e)),
+    }
+}
+
+#[allow(clippy::type_complexity)] // cos Result is basically two types
+fn measure_and_store_all<C, A, S>(
+    circuit: &mut C,
+    tracker: &mut Frames<A>,
+    storage: &mut S,
+) -> (Vec<(usize, C::Outcome)>, Result<(), OverwriteStack<S::BoolVec>>)
+where
+    C: CliffordCircuit,
+    A: StackStorage,
+    S: StackStorage<BoolVec = A::BoolVec>,
+{
+    let mut outcome = Vec::<(usize, C::Outcome)>::new();
+    let mut stacks = tracker.take_stacks().into_iter();
+    while let Some((bit, pauli)) = stacks.next() {
+        outcome.push((bit, circuit.measure(bit)));
+        if let Some(stack) = storage.insert_pauli(bit, pauli) {
+            tracker.restore_stacks(stacks);
+            return (outcome, Err(OverwriteStack { bit, stack }));
         }
-        (outcome, Ok(()))
     }
+    (outcome, Ok(()))
 }
 
 #[cfg(test)]
@@ -310,8 +454,13 @@ mod tests {
 
     use super::*;
     use crate::{
-        boolean_vector::bitvec_simd::SimdBitVec,
+        boolean_vector::{
+            bitvec_simd::SimdBitVec,
+            packed::PackedBitVec,
+            BooleanVector,
+        },
         circuit::{
+            BatchedRandomMeasurementCircuit,
             DummyCircuit,
             RandomMeasurementCircuit,
         },
@@ -326,7 +475,10 @@ mod tests {
                 },
                 Frames,
             },
-            live::LiveVector,
+            live::{
+                LiveShots,
+                LiveVector,
+            },
             MissingStack,
         },
     };
@@ -385,6 +537,88 @@ mod tests {
         r.unwrap()
     }
 
+    #[test]
+    fn peephole() {
+        type Storage = Map<Vec<bool>>;
+        let mut plain = TrackedCircuit {
+            circuit: DummyCircuit {},
+            tracker: Frames::<Storage>::init(4),
+            storage: Storage::default(),
+        };
+        let mut buffered = TrackedCircuit {
+            circuit: DummyCircuit {},
+            tracker: Peephole::<Frames<Storage>>::init(4),
+            storage: Storage::default(),
+        };
+
+        macro_rules! both {
+            ($($gate:ident($($bit:expr),*);)*) => {$(
+                plain.$gate($($bit),*);
+                buffered.$gate($($bit),*);
+            )*};
+        }
+        both!(
+            track_z(0);
+            track_x(1);
+            h(0);
+            h(0);
+            cx(0, 1);
+            s(1);
+            cx(0, 1);
+            cz(2, 3);
+            cz(3, 2);
+            track_y(2);
+            cx(2, 3);
+            sx(3);
+            cx(1, 3);
+        );
+        plain.measure_and_store(3).1.unwrap();
+        buffered.measure_and_store(3).1.unwrap();
+        both!(
+            cx(0, 2);
+            cx(0, 2);
+            h(1);
+        );
+        buffered.measure_and_store_all().1.unwrap();
+        plain.measure_and_store_all().1.unwrap();
+        assert!(buffered.tracker.is_flushed());
+        assert_eq!(
+            storage::into_sorted_by_bit(buffered.storage),
+            storage::into_sorted_by_bit(plain.storage)
+        );
+    }
+
+    #[test]
+    fn lazy_measure_and_store_all() {
+        type Storage = Map<Vec<bool>>;
+        let mut circ = TrackedCircuit {
+            circuit: DummyCircuit {},
+            tracker: Frames::<Storage>::init(3),
+            storage: Storage::default(),
+        };
+        circ.tracker.set_lazy_cliffords(true);
+        circ.track_x(0);
+        circ.h(0);
+        circ.track_x(1);
+        circ.s(1);
+        // qubit 2 is already in the storage, so storing fails when we reach it
+        circ.storage.insert(2, PauliVec::new());
+        let (_, result) = circ.measure_and_store_all();
+        assert_eq!(result.unwrap_err().bit, 2);
+        assert!(circ.tracker.lazy_cliffords());
+        assert_eq!(circ.tracker.frames_num(), 2);
+        assert!(circ.tracker.as_storage().get(&2).is_none());
+        circ.measure_and_store_all().1.unwrap();
+        assert_eq!(
+            storage::into_sorted_by_bit(circ.storage),
+            vec![
+                (0, PauliVec::try_from_str("00", "10").unwrap()),
+                (1, PauliVec::try_from_str("01", "01").unwrap()),
+                (2, PauliVec::try_from_str("00", "00").unwrap()),
+            ]
+        );
+    }
+
     #[test]
     fn single_rotation_teleportation() {
         let mut circ = TrackedCircuit {
@@ -515,6 +749,89 @@ mod tests {
         assert_eq!(circ.tracker, check);
     }
 
+    #[test]
+    fn toffoli_shots() {
+        const NUM_SHOTS: usize = 100;
+        type Circuit = BatchedRandomMeasurementCircuit<PackedBitVec>;
+        let mut circ = TrackedCircuit {
+            circuit: Circuit::new(NUM_SHOTS),
+            tracker: LiveShots::<PackedBitVec>::new(10, NUM_SHOTS),
+            storage: (),
+        };
+
+        trait TTele {
+            fn t_tele(&mut self, origin: usize, new: usize) -> PackedBitVec;
+        }
+        impl TTele for TrackedCircuit<Circuit, LiveShots<PackedBitVec>, ()> {
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn t_tele(&mut self, origin: usize, new: usize) -> PackedBitVec {
+                self.cx(origin, new);
+                self.move_z_to_z(origin, new);
+                let result = self.circuit.measure(origin);
+                self.tracker.track_z_masked(new, &result);
+                result
+            }
+        }
+
+        // the same circuit as in toffoli_live
+        let mut results = Vec::new();
+        results.push(circ.t_tele(0, 3));
+        results.push(circ.t_tele(1, 4));
+        circ.h(2);
+        circ.cx(3, 4);
+        results.push(circ.t_tele(2, 5));
+        circ.cx(4, 5);
+        results.push(circ.t_tele(4, 6));
+        results.push(circ.t_tele(5, 7));
+        circ.cx(3, 6);
+        circ.cx(6, 7);
+        circ.cx(3, 6);
+        results.push(circ.t_tele(7, 8));
+        circ.cx(6, 8);
+        circ.cx(3, 6);
+        results.push(circ.t_tele(8, 9));
+        circ.cx(6, 9);
+        circ.h(9);
+
+        assert!(results.iter().all(|result| result.len() == NUM_SHOTS));
+        let sum = |indices: [usize; 4]| {
+            let mut sum = PackedBitVec::zeros(NUM_SHOTS);
+            for i in indices {
+                sum.xor_inplace(&results[i]);
+            }
+            sum
+        };
+        let zeros = PackedBitVec::zeros(NUM_SHOTS);
+        for bit in [0, 1, 2, 4, 5, 7, 8] {
+            assert_eq!(
+                circ.tracker.get(bit).unwrap(),
+                &PauliVec::zeros(NUM_SHOTS),
+                "{bit}"
+            );
+        }
+        assert_eq!(
+            circ.tracker.get(3).unwrap(),
+            &PauliVec {
+                left: zeros.clone(),
+                right: sum([0, 3, 4, 5]),
+            }
+        );
+        assert_eq!(
+            circ.tracker.get(6).unwrap(),
+            &PauliVec {
+                left: zeros.clone(),
+                right: sum([1, 3, 4, 6]),
+            }
+        );
+        assert_eq!(
+            circ.tracker.get(9).unwrap(),
+            &PauliVec {
+                left: sum([2, 4, 5, 6]),
+                right: zeros,
+            }
+        );
+    }
+
     #[test]
     fn another_graph_test() {
         let mut circ = TrackedCircuit {
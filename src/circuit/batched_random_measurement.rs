@@ -0,0 +1,52 @@
+use std::marker::PhantomData;
+
+use super::CliffordCircuit;
+use crate::boolean_vector::BooleanVector;
+
+/// Like [RandomMeasurementCircuit](super::RandomMeasurementCircuit), but for
+/// `num_shots` shots at once: the measurements return a boolean vector of independent
+/// random bools, one for each shot. It fits to the
+/// [LiveShots](crate::tracker::live::LiveShots) tracker.
+#[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Default, Debug)]
+pub struct BatchedRandomMeasurementCircuit<B> {
+    /// The number of shots, i.e., the length of the outcomes.
+    pub num_shots: usize,
+    phantom: PhantomData<fn() -> B>,
+}
+
+impl<B> BatchedRandomMeasurementCircuit<B> {
+    /// Create a circuit for `num_shots` shots.
+    pub fn new(num_shots: usize) -> Self {
+        Self { num_shots, phantom: PhantomData }
+    }
+}
+
+impl<B: BooleanVector> CliffordCircuit for BatchedRandomMeasurementCircuit<B> {
+    type Outcome = B;
+
+    #[inline(always)]
+    fn x(&mut self, _: usize) {}
+    #[inline(always)]
+    fn y(&mut self, _: usize) {}
+    #[inline(always)]
+    fn z(&mut self, _: usize) {}
+    #[inline(always)]
+    fn h(&mut self, _: usize) {}
+    #[inline(always)]
+    fn s(&mut self, _: usize) {}
+    #[inline(always)]
+    fn cx(&mut self, _: usize, _: usize) {}
+    #[inline(always)]
+    fn cz(&mut self, _: usize, _: usize) {}
+
+    fn measure(&mut self, _: usize) -> B {
+        let mut outcome = B::with_capacity(self.num_shots);
+        let mut rest = self.num_shots;
+        while rest > 0 {
+            let num = rest.min(64);
+            outcome.extend_from_word(rand::random::<u64>(), num);
+            rest -= num;
+        }
+        outcome
+    }
+}
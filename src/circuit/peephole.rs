@@ -0,0 +1,557 @@
+use crate::{
+    collection::IntMap,
+    pauli::Pauli,
+    tracker::{
+        sequence::LocalClifford,
+        MissingStack,
+        PauliString,
+        Tracker,
+    },
+};
+
+/// A [Tracker] wrapper that buffers the gates in a short window per qubit, to cancel
+/// and merge redundant gates before they reach the wrapped tracker.
+///
+/// It is meant to be used as tracker in a [TrackedCircuit](super::TrackedCircuit),
+/// where the circuit still gets every gate immediately, but the gates on the tracker,
+/// which are full passes over the stacks for [Frames](crate::tracker::frames::Frames),
+/// are buffered:
+/// - the single-qubit gates on a qubit are composed into one pending [LocalClifford],
+///   i.e., sequences like H·H or S·S (= Z, which is absorbed) cost nothing
+/// - a CX or CZ gate is kept pending until another gate touches one of its qubits; if
+///   that's the same gate on the same qubits, both cancel
+///
+/// The pending gates of a qubit are applied, at most one two-qubit gate followed by
+/// one [LocalClifford], when the qubit is measured, tracked, moved, or touched by a
+/// two-qubit gate that cannot be buffered. When the qubit is re-created with
+/// [new_qubit](Tracker::new_qubit), only its pending two-qubit gate is applied, since
+/// the [LocalClifford] acts only on the replaced stack. Gates on other qubits commute with them,
+/// so the tracked frames are the same as without the buffer, as soon as they are
+/// [flush]ed. Note that this also means that using a missing qubit may only panic when
+/// the gates are flushed, or not at all, if the gates cancel.
+///
+/// [flush]: Peephole::flush
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     circuit::{
+///         DummyCircuit,
+///         Peephole,
+///         TrackedCircuit,
+///     },
+///     pauli::PauliVec,
+///     tracker::{
+///         frames::{
+///             storage::Map,
+///             Frames,
+///         },
+///         Tracker,
+///     },
+/// };
+/// let mut circ = TrackedCircuit {
+///     circuit: DummyCircuit {},
+///     tracker: Peephole::<Frames<Map<Vec<bool>>>>::init(2),
+///     storage: Map::<_>::default(),
+/// };
+/// circ.track_x(0);
+/// circ.h(0);
+/// circ.h(0);
+/// circ.cx(0, 1);
+/// circ.cx(0, 1);
+/// circ.s(1);
+/// circ.s(1);
+/// // nothing has been applied on the frames yet, and all gates cancel
+/// assert!(circ.tracker.is_flushed());
+/// circ.cx(0, 1);
+/// circ.measure_and_store(1).1.unwrap();
+/// assert_eq!(circ.storage[&1], PauliVec::try_from_str("1", "0").unwrap());
+/// # }
+/// ```
+#[derive(Clone, PartialEq, Eq, Default, Debug)]
+pub struct Peephole<T> {
+    tracker: T,
+    // the pending single-qubit gates, applied after the pending two-qubit gate on the
+    // same qubit; only non-identities are stored
+    singles: IntMap<usize, LocalClifford>,
+    // the pending two-qubit gates, stored for both of their qubits
+    doubles: IntMap<usize, Double>,
+}
+
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+enum Double {
+    Cx { control: usize, target: usize },
+    // the qubits are ordered, since CZ is symmetric
+    Cz(usize, usize),
+}
+
+impl Double {
+    fn cz(bit_a: usize, bit_b: usize) -> Self {
+        Double::Cz(bit_a.min(bit_b), bit_a.max(bit_b))
+    }
+
+    fn bits(self) -> (usize, usize) {
+        match self {
+            Double::Cx { control, target } => (control, target),
+            Double::Cz(bit_a, bit_b) => (bit_a, bit_b),
+        }
+    }
+
+    fn apply<T: Tracker>(self, tracker: &mut T) {
+        match self {
+            Double::Cx { control, target } => tracker.cx(control, target),
+            Double::Cz(bit_a, bit_b) => tracker.cz(bit_a, bit_b),
+        }
+    }
+}
+
+// apply the clifford with at most one pass over the stack for Frames (H is only a
+// swap of the stack's components)
+fn apply_local<T: Tracker>(tracker: &mut T, bit: usize, clifford: LocalClifford) {
+    let (h, s) = (LocalClifford::h(), LocalClifford::s());
+    if clifford.is_identity() {
+    } else if clifford == h {
+        tracker.h(bit);
+    } else if clifford == s {
+        tracker.s(bit);
+    } else if clifford == LocalClifford::sx() {
+        tracker.sx(bit);
+    } else if clifford == h.then(s) {
+        tracker.h(bit);
+        tracker.s(bit);
+    } else {
+        debug_assert_eq!(clifford, s.then(h), "there are only six LocalCliffords");
+        tracker.s(bit);
+        tracker.h(bit);
+    }
+}
+
+impl<T> Peephole<T> {
+    /// Wrap the `tracker`.
+    pub fn new(tracker: T) -> Self {
+        Self {
+            tracker,
+            singles: IntMap::default(),
+            doubles: IntMap::default(),
+        }
+    }
+
+    /// Get a reference to the wrapped tracker. Note that the pending gates are not
+    /// applied; use [tracker_mut](Self::tracker_mut) for that.
+    pub fn as_tracker(&self) -> &T {
+        &self.tracker
+    }
+
+    /// Check whether there are no pending gates.
+    pub fn is_flushed(&self) -> bool {
+        self.singles.is_empty() && self.doubles.is_empty()
+    }
+
+    // the tracker, with only the qubits that have been flushed being valid
+    pub(super) fn unflushed_mut(&mut self) -> &mut T {
+        &mut self.tracker
+    }
+}
+
+impl<T: Tracker> Peephole<T> {
+    /// Apply the pending gates on the qu`bit`.
+    pub fn flush_qubit(&mut self, bit: usize) {
+        if let Some(double) = self.doubles.remove(&bit) {
+            let (bit_a, bit_b) = double.bits();
+            self.doubles.remove(if bit_a == bit { &bit_b } else { &bit_a });
+            double.apply(&mut self.tracker);
+        }
+        if let Some(clifford) = self.singles.remove(&bit) {
+            apply_local(&mut self.tracker, bit, clifford);
+        }
+    }
+
+    /// Apply all pending gates.
+    pub fn flush(&mut self) {
+        let bits = self
+            .doubles
+            .keys()
+            .chain(self.singles.keys())
+            .copied()
+            .collect::<Vec<_>>();
+        for bit in bits {
+            self.flush_qubit(bit);
+        }
+    }
+
+    /// Apply all pending gates and get a mutable reference to the wrapped tracker.
+    pub fn tracker_mut(&mut self) -> &mut T {
+        self.flush();
+        &mut self.tracker
+    }
+
+    /// Apply all pending gates and return the wrapped tracker.
+    pub fn into_tracker(mut self) -> T {
+        self.flush();
+        self.tracker
+    }
+
+    fn single(&mut self, bit: usize, clifford: LocalClifford) {
+        let pending = self.singles.remove(&bit).unwrap_or_default().then(clifford);
+        if !pending.is_identity() {
+            self.singles.insert(bit, pending);
+        }
+    }
+
+    fn double(&mut self, double: Double) {
+        let (bit_a, bit_b) = double.bits();
+        if !self.singles.contains_key(&bit_a)
+            && !self.singles.contains_key(&bit_b)
+            && self.doubles.get(&bit_a) == Some(&double)
+        {
+            self.doubles.remove(&bit_a);
+            self.doubles.remove(&bit_b);
+            return;
+        }
+        self.flush_qubit(bit_a);
+        self.flush_qubit(bit_b);
+        if bit_a == bit_b {
+            // let the tracker handle (panic) that case
+            double.apply(&mut self.tracker);
+        } else {
+            self.doubles.insert(bit_a, double);
+            self.doubles.insert(bit_b, double);
+        }
+    }
+}
+
+macro_rules! single {
+    ($(($name:ident, $clifford:ident),)*) => {$(
+        fn $name(&mut self, bit: usize) {
+            self.single(bit, LocalClifford::$clifford());
+        }
+    )*};
+}
+
+macro_rules! flushed {
+    ($(($name:ident, $bit_a:ident, $bit_b:ident),)*) => {$(
+        fn $name(&mut self, $bit_a: usize, $bit_b: usize) {
+            self.flush_qubit($bit_a);
+            self.flush_qubit($bit_b);
+            self.tracker.$name($bit_a, $bit_b);
+        }
+    )*};
+}
+
+impl<T: Tracker> Tracker for Peephole<T> {
+    type Stack = T::Stack;
+
+    fn init(num_bits: usize) -> Self {
+        Self::new(T::init(num_bits))
+    }
+
+    fn new_qubit(&mut self, bit: usize) -> Option<usize> {
+        // the pending single-qubit gates act only on the replaced stack, but the pending
+        // two-qubit gate acts on the other qubit, too
+        self.singles.remove(&bit);
+        self.flush_qubit(bit);
+        self.tracker.new_qubit(bit)
+    }
+
+    fn track_pauli(&mut self, bit: usize, pauli: Pauli) {
+        self.flush_qubit(bit);
+        self.tracker.track_pauli(bit, pauli);
+    }
+
+    fn track_pauli_string(&mut self, string: PauliString) {
+        for (bit, _) in string.iter() {
+            self.flush_qubit(*bit);
+        }
+        self.tracker.track_pauli_string(string);
+    }
+
+    // up to Paulis, sdg = s, sxdg = sx and sy = sydg = h, cf. Tracker
+    single!((h, h), (s, s), (sdg, s), (sx, sx), (sxdg, sx), (sy, h), (sydg, h),);
+
+    fn cx(&mut self, control: usize, target: usize) {
+        self.double(Double::Cx { control, target });
+    }
+
+    fn cz(&mut self, bit_a: usize, bit_b: usize) {
+        self.double(Double::cz(bit_a, bit_b));
+    }
+
+    flushed!(
+        (swap, bit_a, bit_b),
+        (cy, control, target),
+        (iswap, bit_a, bit_b),
+        (iswapdg, bit_a, bit_b),
+        (move_x_to_x, source, destination),
+        (move_x_to_z, source, destination),
+        (move_z_to_x, source, destination),
+        (move_z_to_z, source, destination),
+    );
+
+    fn measure(&mut self, bit: usize) -> Result<Self::Stack, MissingStack> {
+        self.flush_qubit(bit);
+        self.tracker.measure(bit)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        pauli::PauliVec,
+        tracker::{
+            frames::{
+                storage::{
+                    self,
+                    Map,
+                },
+                Frames,
+            },
+            live::LiveVector,
+            test::impl_utils::{
+                self,
+                DoubleAction,
+                DoubleResults,
+                SingleAction,
+                SingleResults,
+            },
+        },
+    };
+
+    type ThisTracker = Peephole<Frames<Map<Vec<bool>>>>;
+
+    #[test]
+    fn single_actions() {
+        let actions: [SingleAction<ThisTracker>; impl_utils::N_SINGLES] = [
+            ThisTracker::h,
+            ThisTracker::s,
+            ThisTracker::sdg,
+            ThisTracker::sx,
+            ThisTracker::sxdg,
+            ThisTracker::sy,
+            ThisTracker::sydg,
+        ];
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn runner(action: SingleAction<ThisTracker>, result: SingleResults) {
+            for (input, check) in (0u8..).zip(result.1) {
+                let mut tracker = ThisTracker::init(2);
+                tracker.track_pauli_string(impl_utils::single_init(input));
+                (action)(&mut tracker, 0);
+                assert_eq!(
+                    tracker.measure(0).unwrap().pop().unwrap().storage(),
+                    check,
+                    "{}, {}",
+                    result.0,
+                    input
+                );
+            }
+        }
+        impl_utils::single_check(runner, actions);
+    }
+
+    #[test]
+    fn double_actions() {
+        let actions: [DoubleAction<ThisTracker>; impl_utils::N_DOUBLES] = [
+            ThisTracker::cx,
+            ThisTracker::cz,
+            ThisTracker::move_x_to_x,
+            ThisTracker::move_x_to_z,
+            ThisTracker::move_z_to_x,
+            ThisTracker::move_z_to_z,
+            ThisTracker::swap,
+            ThisTracker::cy,
+            ThisTracker::iswap,
+            ThisTracker::iswapdg,
+        ];
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn runner(action: DoubleAction<ThisTracker>, result: DoubleResults) {
+            for (input, check) in (0u8..).zip(result.1) {
+                let mut tracker = ThisTracker::init(2);
+                tracker.track_pauli_string(impl_utils::double_init(input));
+                (action)(&mut tracker, 0, 1);
+                let frames = tracker.into_tracker();
+                let output = impl_utils::double_output(frames.frame(0).unwrap());
+                assert_eq!(output, check, "{}, {}", result.0, input);
+            }
+        }
+        impl_utils::double_check(runner, actions);
+    }
+
+    #[test]
+    fn cancellation() {
+        let mut tracker = Peephole::<LiveVector>::init(3);
+        tracker.track_x(0);
+        tracker.h(0);
+        tracker.sy(0);
+        tracker.s(1);
+        tracker.sdg(1);
+        assert!(tracker.is_flushed());
+        // (SX·H)³ = I, up to Paulis
+        for _ in 0..2 {
+            tracker.sx(0);
+            tracker.h(0);
+            assert!(!tracker.is_flushed());
+        }
+        tracker.sx(0);
+        tracker.h(0);
+        assert!(tracker.is_flushed());
+        tracker.cx(0, 1);
+        tracker.cx(0, 1);
+        tracker.cz(1, 2);
+        tracker.cz(2, 1);
+        assert!(tracker.is_flushed());
+        // the X on qubit 0 has not been touched
+        assert_eq!(tracker.as_tracker().get(0), Some(&Pauli::new_x()));
+
+        // gates in between prevent the cancellation
+        tracker.cx(0, 1);
+        tracker.h(1);
+        tracker.cx(0, 1);
+        tracker.cx(1, 0);
+        tracker.cx(0, 1);
+        assert!(!tracker.is_flushed());
+        let mut expected = LiveVector::init(3);
+        expected.track_x(0);
+        expected.cx(0, 1);
+        expected.h(1);
+        expected.cx(0, 1);
+        expected.cx(1, 0);
+        expected.cx(0, 1);
+        assert_eq!(tracker.into_tracker(), expected);
+    }
+
+    #[test]
+    fn recreate_qubit() {
+        type Unbuffered = Frames<Map<Vec<bool>>>;
+        let mut buffered = ThisTracker::init(2);
+        let mut unbuffered = Unbuffered::init(2);
+        buffered.track_z(0);
+        unbuffered.track_z(0);
+        buffered.h(0);
+        unbuffered.h(0);
+        buffered.cx(0, 1);
+        unbuffered.cx(0, 1);
+        assert!(!buffered.is_flushed());
+        assert_eq!(buffered.new_qubit(0), unbuffered.new_qubit(0));
+        // the H does not act on the new qubit, but the CX did act on qubit 1
+        assert!(buffered.is_flushed());
+        assert_eq!(
+            buffered.as_tracker().as_storage()[&1],
+            PauliVec::try_from_str("1", "0").unwrap()
+        );
+        assert_eq!(
+            storage::into_sorted_by_bit(buffered.into_tracker().into_storage()),
+            storage::into_sorted_by_bit(unbuffered.into_storage())
+        );
+    }
+
+    #[test]
+    fn same_as_unbuffered() {
+        const NUM_QUBITS: usize = 5;
+        type Unbuffered = Frames<Map<Vec<bool>>>;
+        let mut buffered = ThisTracker::init(NUM_QUBITS);
+        let mut unbuffered = Unbuffered::init(NUM_QUBITS);
+
+        // a simple deterministic pseudo random generator, biased to repeat two-qubit
+        // gates, so that some of them cancel; the moves are only done right before the
+        // measurement of their source, since moved stacks are not meant to be used
+        // otherwise
+        let mut state = 0x2545_f491_4f6c_dd1du64;
+        let mut next = |max: usize| {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            state as usize % max
+        };
+        let singles: [SingleAction<ThisTracker>; 7] = [
+            ThisTracker::h,
+            ThisTracker::s,
+            ThisTracker::sdg,
+            ThisTracker::sx,
+            ThisTracker::sxdg,
+            ThisTracker::sy,
+            ThisTracker::sydg,
+        ];
+        let doubles: [DoubleAction<ThisTracker>; 10] = [
+            ThisTracker::cx,
+            ThisTracker::cz,
+            ThisTracker::swap,
+            ThisTracker::cy,
+            ThisTracker::iswap,
+            ThisTracker::iswapdg,
+            ThisTracker::move_x_to_x,
+            ThisTracker::move_x_to_z,
+            ThisTracker::move_z_to_x,
+            ThisTracker::move_z_to_z,
+        ];
+        let references: [DoubleAction<Unbuffered>; 10] = [
+            Unbuffered::cx,
+            Unbuffered::cz,
+            Unbuffered::swap,
+            Unbuffered::cy,
+            Unbuffered::iswap,
+            Unbuffered::iswapdg,
+            Unbuffered::move_x_to_x,
+            Unbuffered::move_x_to_z,
+            Unbuffered::move_z_to_x,
+            Unbuffered::move_z_to_z,
+        ];
+        let single_references: [SingleAction<Unbuffered>; 7] = [
+            Unbuffered::h,
+            Unbuffered::s,
+            Unbuffered::sdg,
+            Unbuffered::sx,
+            Unbuffered::sxdg,
+            Unbuffered::sy,
+            Unbuffered::sydg,
+        ];
+
+        let mut last = (0, 0, 1);
+        for _ in 0..2000 {
+            let bit = next(NUM_QUBITS);
+            match next(10) {
+                0..=3 => {
+                    let gate = next(singles.len());
+                    singles[gate](&mut buffered, bit);
+                    single_references[gate](&mut unbuffered, bit);
+                }
+                4..=6 => {
+                    let (gate, a, b) = if next(2) == 0 {
+                        last
+                    } else {
+                        let other = (bit + 1 + next(NUM_QUBITS - 1)) % NUM_QUBITS;
+                        // mostly CX and CZ
+                        let gate = if next(3) == 0 { next(6) } else { next(2) };
+                        (gate, bit, other)
+                    };
+                    last = (gate, a, b);
+                    doubles[gate](&mut buffered, a, b);
+                    references[gate](&mut unbuffered, a, b);
+                }
+                7..=8 => {
+                    let pauli = Pauli::try_from(next(4) as u8).unwrap();
+                    buffered.track_pauli(bit, pauli);
+                    unbuffered.track_pauli(bit, pauli);
+                }
+                _ => {
+                    if next(2) == 0 {
+                        let other = (bit + 1 + next(NUM_QUBITS - 1)) % NUM_QUBITS;
+                        let gate = 6 + next(4);
+                        doubles[gate](&mut buffered, bit, other);
+                        references[gate](&mut unbuffered, bit, other);
+                    }
+                    assert_eq!(buffered.measure(bit), unbuffered.measure(bit));
+                    buffered.new_qubit(bit);
+                    unbuffered.new_qubit(bit);
+                }
+            }
+        }
+        assert_eq!(
+            storage::into_sorted_by_bit(buffered.into_tracker().into_storage()),
+            storage::into_sorted_by_bit(unbuffered.into_storage())
+        );
+    }
+}
@@ -0,0 +1,191 @@
+/*!
+Hash maps and sets with a fast hasher for integer keys.
+
+The qubits are [usize]s, and the storages and the analysis look them up in hash maps
+all the time, e.g., for every gate applied on [Frames](crate::tracker::frames::Frames)
+with a [Map](crate::tracker::frames::storage::Map) storage. The default hasher of
+[HashMap], SipHash, is resistant against HashDoS attacks, but that costs a lot of time
+compared to the lookup itself. Since the keys are usually not chosen by an attacker,
+we use the [IntHasher] instead, which needs only one multiplication per integer.
+
+[HashMap] is already an open-addressing hash table (a SwissTable, cf.
+[hashbrown](https://docs.rs/hashbrown)), which looks up the buckets with the low bits
+of the hash and compares the high bits in groups. The [IntHasher] multiplies the key
+with an odd constant, which mixes the key only into the higher bits of the product;
+the low bits of a key that is a multiple of 2^k stay zero. Strided keys, like
+`layer * 64 + logical` qubit numbers, would therefore all end up in a few buckets.
+Hence, [Hasher::finish] rotates the well mixed middle bits of the product into the low
+bits, so that dense and strided keys are spread over the buckets.
+*/
+
+use std::{
+    collections::{
+        HashMap,
+        HashSet,
+    },
+    hash::{
+        BuildHasherDefault,
+        Hasher,
+    },
+};
+
+/// A fast, non-cryptographic [Hasher] for integer keys, cf. the [module](self)
+/// documentation.
+///
+/// It is the hasher of FxHash (used in rustc and Firefox): each integer is folded into
+/// the state with a rotation, an XOR and a multiplication. Other input is folded in as
+/// little endian words. Like rustc-hash 2, [finish](Hasher::finish) rotates the state
+/// as final mixing step. Note that it is not resistant against HashDoS attacks.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::collection::IntMap;
+/// let mut map = IntMap::default();
+/// map.insert(3, "three");
+/// assert_eq!(map.get(&3), Some(&"three"));
+/// # }
+/// ```
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Default, Debug)]
+pub struct IntHasher {
+    hash: u64,
+}
+
+// 2^64 divided by the golden ratio, like in Fibonacci hashing; it's odd
+const SEED: u64 = 0x9e37_79b9_7f4a_7c15;
+// the rotation in finish, moving the best mixed bits of the product to the low bits
+// (the same as in rustc-hash 2)
+const FINISH_ROTATION: u32 = 26;
+
+impl IntHasher {
+    #[inline]
+    fn add(&mut self, word: u64) {
+        self.hash = (self.hash.rotate_left(5) ^ word).wrapping_mul(SEED);
+    }
+}
+
+macro_rules! write_int {
+    ($(($name:ident, $int:ty),)*) => {$(
+        #[inline]
+        fn $name(&mut self, i: $int) {
+            self.add(i as u64);
+        }
+    )*};
+}
+
+impl Hasher for IntHasher {
+    #[inline]
+    fn finish(&self) -> u64 {
+        self.hash.rotate_left(FINISH_ROTATION)
+    }
+
+    fn write(&mut self, bytes: &[u8]) {
+        let mut chunks = bytes.chunks_exact(8);
+        for chunk in chunks.by_ref() {
+            self.add(u64::from_le_bytes(chunk.try_into().expect("chunk of 8 bytes")));
+        }
+        let rest = chunks.remainder();
+        if !rest.is_empty() {
+            let mut word = [0; 8];
+            word[..rest.len()].copy_from_slice(rest);
+            self.add(u64::from_le_bytes(word));
+        }
+    }
+
+    write_int!(
+        (write_u8, u8),
+        (write_u16, u16),
+        (write_u32, u32),
+        (write_u64, u64),
+        (write_usize, usize),
+    );
+
+    #[inline]
+    fn write_u128(&mut self, i: u128) {
+        self.add(i as u64);
+        self.add((i >> 64) as u64);
+    }
+}
+
+/// The [BuildHasher](std::hash::BuildHasher) for [IntHasher].
+pub type BuildIntHasher = BuildHasherDefault<IntHasher>;
+
+/// A [HashMap] with the [IntHasher]. Create it with [Default] or, e.g.,
+/// [HashMap::with_capacity_and_hasher]; [HashMap::new] is only available for the
+/// default hasher of [HashMap].
+pub type IntMap<K, V> = HashMap<K, V, BuildIntHasher>;
+
+/// A [HashSet] with the [IntHasher], cf. [IntMap].
+pub type IntSet<K> = HashSet<K, BuildIntHasher>;
+
+#[cfg(test)]
+mod tests {
+    use std::hash::Hash;
+
+    use coverage_helper::test;
+
+    use super::*;
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn hash(value: impl Hash) -> u64 {
+        let mut hasher = IntHasher::default();
+        value.hash(&mut hasher);
+        hasher.finish()
+    }
+
+    // the maximum number of keys that end up in the same of 2^10 buckets, which are
+    // chosen by the low bits of the hash
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn max_bucket_load(keys: impl IntoIterator<Item = usize>) -> usize {
+        let mask = (1 << 10) - 1;
+        let mut load = vec![0; 1 << 10];
+        for key in keys {
+            load[(hash(key) & mask) as usize] += 1;
+        }
+        load.into_iter().max().unwrap_or(0)
+    }
+
+    #[test]
+    fn dense_keys() {
+        // the low bits of the hashes of dense keys spread them over the buckets (1024
+        // random hashes would have a maximum load of about 5)
+        assert!(max_bucket_load(0..1 << 10) <= 4);
+        // and the high bits are mixed, too
+        let high = (0..1 << 7)
+            .map(|key: usize| hash(key) >> 57)
+            .collect::<IntSet<_>>();
+        assert!(high.len() > 64);
+    }
+
+    #[test]
+    fn strided_keys() {
+        // without the final rotation, the low 6 bits of the hashes would be zero, i.e.,
+        // all keys would end up in 16 buckets, 64 keys in each
+        assert!(max_bucket_load((0..1 << 10).map(|layer| layer * 64)) <= 4);
+        assert!(max_bucket_load((0..1 << 10).map(|layer| layer * 1024)) <= 4);
+        let keys =
+            (0..32).flat_map(|layer| (0..32).map(move |logical| layer * 64 + logical));
+        assert!(max_bucket_load(keys) <= 4);
+    }
+
+    #[test]
+    fn bytes() {
+        assert_eq!(hash(0u64), 0);
+        assert_ne!(hash(1u8), hash(2u8));
+        assert_ne!(hash(1u128), hash(1u128 << 64));
+        // the words are folded in as little endian words, padded with zeros
+        let mut hasher = IntHasher::default();
+        hasher.write(&[1, 0, 0, 0, 0, 0, 0, 0, 2]);
+        let mut expected = IntHasher::default();
+        expected.write_u64(1);
+        expected.write_u64(2);
+        assert_eq!(hasher.finish(), expected.finish());
+        assert_ne!(hash("pauli"), hash("tracker"));
+
+        let map = (0..100)
+            .map(|key| (key, key * 2))
+            .collect::<IntMap<usize, usize>>();
+        assert!((0..100).all(|key| map[&key] == key * 2));
+    }
+}
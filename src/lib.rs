@@ -42,6 +42,10 @@ general brief introduction to Pauli tracking is given in the repository's
 * **circuit**
   Includes the [circuit] module which contains tools to combine the Pauli tracking
   mechanism with a circuit simulator/description.
+* **metrics**
+  Includes the [metrics] module, which instruments the hot paths of the trackers and
+  the analysis with counters and timers. Without the feature, the instrumentation
+  compiles to nothing.
 * **bitvec**
   Implement [BooleanVector](boolean_vector::BooleanVector) for
   [bitvec::vec::BitVec](https://docs.rs/bitvec/latest/bitvec/vec/struct.BitVec.html)
@@ -508,8 +512,35 @@ assert_eq!(
 [paper]: https://arxiv.org/abs/2209.07345v2
 */
 
+// record a metric with the according function of the metrics module; without the
+// "metrics" feature, this expands to nothing, i.e., the arguments are not evaluated
+#[cfg(feature = "metrics")]
+macro_rules! metric {
+    (gate($name:expr)) => {{
+        const GATE: usize = $crate::metrics::gate_index($name);
+        $crate::metrics::gate(GATE)
+    }};
+    // the timer runs until the end of the enclosing block
+    (time($timing:ident)) => {
+        let _timer = $crate::metrics::timer($crate::metrics::Timing::$timing);
+    };
+    ($function:ident($($arg:expr),*)) => {
+        $crate::metrics::$function($($arg),*)
+    };
+}
+#[cfg(not(feature = "metrics"))]
+macro_rules! metric {
+    ($function:ident($($arg:expr),*)) => {
+        ()
+    };
+}
+
+pub mod binary;
+
 pub mod boolean_vector;
 
+pub mod collection;
+
 #[cfg(feature = "circuit")]
 #[cfg_attr(docsrs, doc(cfg(feature = "circuit")))]
 pub mod circuit;
@@ -518,6 +549,10 @@ pub mod circuit;
 #[cfg_attr(docsrs, doc(cfg(feature = "analyse")))]
 pub mod analyse;
 
+#[cfg(feature = "metrics")]
+#[cfg_attr(docsrs, doc(cfg(feature = "metrics")))]
+pub mod metrics;
+
 pub mod pauli;
 
 mod slice_extension;
@@ -0,0 +1,345 @@
+/*!
+Opt-in instrumentation of the hot paths of the trackers and the analysis, to see what
+they spend their time and memory on.
+
+The hot paths record into global counters, which can be read with [snapshot] and
+exported, e.g., to a monitoring system. The counters are process-wide relaxed atomics,
+i.e., all trackers, also from different threads, record into the same counters; use
+[Snapshot::since] to get the counts of a certain section. Without the "metrics"
+feature, the instrumentation compiles to nothing.
+
+# Examples
+```
+# #[cfg_attr(coverage_nightly, no_coverage)]
+# fn main() {
+use pauli_tracker::{
+    metrics,
+    tracker::{
+        frames::{
+            storage::Map,
+            Frames,
+        },
+        Tracker,
+    },
+};
+let start = metrics::snapshot();
+let mut tracker = Frames::<Map<Vec<bool>>>::init(2);
+tracker.track_x(0);
+tracker.h(0);
+tracker.cx(0, 1);
+let metrics = metrics::snapshot().since(&start);
+// the counters are global, so other threads could have recorded into them, too
+assert!(metrics.gate("cx").unwrap() >= 1);
+assert!(metrics.frames_pushed >= 1);
+assert!(metrics::storage_bytes(tracker.as_storage()) >= 1);
+# }
+```
+*/
+
+use std::{
+    sync::atomic::{
+        AtomicU64,
+        Ordering,
+    },
+    time::{
+        Duration,
+        Instant,
+    },
+};
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use crate::{
+    boolean_vector::BooleanVector,
+    pauli::PauliVec,
+    tracker::frames::storage::StackStorage,
+};
+
+/// The names of the counted gates, in the order of [Snapshot::gates]. The gates are
+/// counted when they are applied on [Frames](crate::tracker::frames::Frames) via the
+/// [Tracker](crate::tracker::Tracker) methods; gates without an own implementation are
+/// counted as the gates they are composed of.
+pub const GATES: [&str; 16] = [
+    "h",
+    "s",
+    "sdg",
+    "sx",
+    "sxdg",
+    "sy",
+    "sydg",
+    "cx",
+    "cz",
+    "swap",
+    "cy",
+    "iswap",
+    "move_x_to_x",
+    "move_x_to_z",
+    "move_z_to_x",
+    "move_z_to_z",
+];
+
+#[allow(clippy::declare_interior_mutable_const)] // only used to initialize the statics
+const ZERO: AtomicU64 = AtomicU64::new(0);
+
+static GATE_COUNTS: [AtomicU64; GATES.len()] = [ZERO; GATES.len()];
+static FRAMES_PUSHED: AtomicU64 = ZERO;
+static LOOKUPS: AtomicU64 = ZERO;
+static MISSES: AtomicU64 = ZERO;
+static STACK_RESERVATIONS: AtomicU64 = ZERO;
+static STORED_BYTES: AtomicU64 = ZERO;
+static DEPENDENCY_GRAPH_NANOS: AtomicU64 = ZERO;
+static SWEEP_NANOS: AtomicU64 = ZERO;
+
+/// A snapshot of the counters, cf. the [module](self) documentation.
+#[derive(Clone, Copy, PartialEq, Eq, Default, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct Snapshot {
+    /// The number of applied gates, in the order of [GATES].
+    pub gates: [u64; GATES.len()],
+    /// The number of frames that have been pushed onto the stacks of
+    /// [Frames](crate::tracker::frames::Frames).
+    pub frames_pushed: u64,
+    /// The number of qubit lookups in the storages of the trackers by the gates, the
+    /// tracking and the measurements.
+    pub lookups: u64,
+    /// The number of those lookups where the qubit was missing.
+    pub misses: u64,
+    /// The number of times a stack of [Frames](crate::tracker::frames::Frames)
+    /// reserved more memory for new frames, i.e., the number of reallocations of the
+    /// [PauliVec]s.
+    pub stack_reservations: u64,
+    /// The number of bytes of the stacks that have been moved into other storages by
+    /// [measure_and_store](crate::tracker::frames::Frames::measure_and_store) and
+    /// [measure_and_store_all](crate::tracker::frames::Frames::measure_and_store_all),
+    /// cf. [stack_bytes]. The bytes of the stacks that are still in a tracker can be
+    /// computed with [storage_bytes].
+    pub stored_bytes: u64,
+    /// The time spent in
+    /// [create_dependency_graph](crate::analyse::create_dependency_graph) and
+    /// [try_create_dependency_graph](crate::analyse::try_create_dependency_graph).
+    pub dependency_graph_time: Duration,
+    /// The time spent in the sweeps of the
+    /// [Scheduler](crate::analyse::schedule::Scheduler).
+    pub sweep_time: Duration,
+}
+
+impl Snapshot {
+    /// Get the count of the gate with the `name` (one of [GATES]).
+    pub fn gate(&self, name: &str) -> Option<u64> {
+        GATES
+            .iter()
+            .position(|gate| *gate == name)
+            .map(|idx| self.gates[idx])
+    }
+
+    /// Get the differences of the counters to an `earlier` snapshot. The differences
+    /// saturate at zero, e.g., if the counters have been [reset] in between.
+    pub fn since(&self, earlier: &Snapshot) -> Snapshot {
+        let mut gates = self.gates;
+        for (count, earlier) in gates.iter_mut().zip(earlier.gates) {
+            *count = count.saturating_sub(earlier);
+        }
+        Snapshot {
+            gates,
+            frames_pushed: self.frames_pushed.saturating_sub(earlier.frames_pushed),
+            lookups: self.lookups.saturating_sub(earlier.lookups),
+            misses: self.misses.saturating_sub(earlier.misses),
+            stack_reservations: self
+                .stack_reservations
+                .saturating_sub(earlier.stack_reservations),
+            stored_bytes: self.stored_bytes.saturating_sub(earlier.stored_bytes),
+            dependency_graph_time: self
+                .dependency_graph_time
+                .saturating_sub(earlier.dependency_graph_time),
+            sweep_time: self.sweep_time.saturating_sub(earlier.sweep_time),
+        }
+    }
+}
+
+/// Take a snapshot of the counters.
+pub fn snapshot() -> Snapshot {
+    let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+    let mut gates = [0; GATES.len()];
+    for (count, counter) in gates.iter_mut().zip(GATE_COUNTS.iter()) {
+        *count = load(counter);
+    }
+    Snapshot {
+        gates,
+        frames_pushed: load(&FRAMES_PUSHED),
+        lookups: load(&LOOKUPS),
+        misses: load(&MISSES),
+        stack_reservations: load(&STACK_RESERVATIONS),
+        stored_bytes: load(&STORED_BYTES),
+        dependency_graph_time: Duration::from_nanos(load(&DEPENDENCY_GRAPH_NANOS)),
+        sweep_time: Duration::from_nanos(load(&SWEEP_NANOS)),
+    }
+}
+
+/// Reset all counters to zero.
+///
+/// Note that this affects all threads; to measure a certain section, prefer
+/// [Snapshot::since].
+pub fn reset() {
+    for counter in GATE_COUNTS.iter().chain([
+        &FRAMES_PUSHED,
+        &LOOKUPS,
+        &MISSES,
+        &STACK_RESERVATIONS,
+        &STORED_BYTES,
+        &DEPENDENCY_GRAPH_NANOS,
+        &SWEEP_NANOS,
+    ]) {
+        counter.store(0, Ordering::Relaxed);
+    }
+}
+
+/// The number of bytes needed to store the bits of the `stack`, i.e., without the
+/// overhead and the spare capacity of the boolean vectors.
+pub fn stack_bytes<B: BooleanVector>(stack: &PauliVec<B>) -> usize {
+    (stack.left.len() + stack.right.len() + 7) / 8
+}
+
+/// The sum of the [stack_bytes] of all stacks in the `storage`.
+pub fn storage_bytes<S: StackStorage>(storage: &S) -> usize {
+    storage.iter().map(|(_, stack)| stack_bytes(stack)).sum()
+}
+
+// the recording functions, called through the crate's metric! macro
+
+// evaluated at compile time by the metric! macro
+pub(crate) const fn gate_index(name: &str) -> usize {
+    let name = name.as_bytes();
+    let mut idx = 0;
+    while idx < GATES.len() {
+        let gate = GATES[idx].as_bytes();
+        if gate.len() == name.len() {
+            let mut i = 0;
+            while i < gate.len() && gate[i] == name[i] {
+                i += 1;
+            }
+            if i == gate.len() {
+                return idx;
+            }
+        }
+        idx += 1;
+    }
+    panic!("unknown gate");
+}
+
+#[inline]
+pub(crate) fn gate(idx: usize) {
+    GATE_COUNTS[idx].fetch_add(1, Ordering::Relaxed);
+}
+
+#[inline]
+pub(crate) fn frames_pushed(num: usize) {
+    FRAMES_PUSHED.fetch_add(num as u64, Ordering::Relaxed);
+}
+
+#[inline]
+pub(crate) fn lookups(num: usize) {
+    LOOKUPS.fetch_add(num as u64, Ordering::Relaxed);
+}
+
+#[inline]
+pub(crate) fn misses(num: usize) {
+    MISSES.fetch_add(num as u64, Ordering::Relaxed);
+}
+
+#[inline]
+pub(crate) fn stack_reservations(num: usize) {
+    STACK_RESERVATIONS.fetch_add(num as u64, Ordering::Relaxed);
+}
+
+#[inline]
+pub(crate) fn stored_bytes(bytes: usize) {
+    STORED_BYTES.fetch_add(bytes as u64, Ordering::Relaxed);
+}
+
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+#[cfg_attr(not(feature = "analyse"), allow(dead_code))]
+pub(crate) enum Timing {
+    DependencyGraph,
+    Sweep,
+}
+
+/// Adds the time until it is dropped to its counter.
+#[derive(Debug)]
+pub(crate) struct Timer {
+    timing: Timing,
+    start: Instant,
+}
+
+impl Drop for Timer {
+    fn drop(&mut self) {
+        let counter = match self.timing {
+            Timing::DependencyGraph => &DEPENDENCY_GRAPH_NANOS,
+            Timing::Sweep => &SWEEP_NANOS,
+        };
+        counter.fetch_add(self.start.elapsed().as_nanos() as u64, Ordering::Relaxed);
+    }
+}
+
+#[inline]
+#[cfg_attr(not(feature = "analyse"), allow(dead_code))]
+pub(crate) fn timer(timing: Timing) -> Timer {
+    Timer { timing, start: Instant::now() }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        pauli::Pauli,
+        tracker::{
+            frames::{
+                storage::Map,
+                Frames,
+            },
+            Tracker,
+        },
+    };
+
+    #[test]
+    fn gate_names() {
+        for (idx, name) in GATES.iter().enumerate() {
+            assert_eq!(gate_index(name), idx);
+        }
+    }
+
+    #[test]
+    fn frames() {
+        let start = snapshot();
+        let mut tracker = Frames::<Map<Vec<bool>>>::init(3);
+        tracker.track_x(0);
+        tracker.track_pauli_string(vec![(1, Pauli::new_z()), (7, Pauli::new_x())]);
+        tracker.h(0);
+        tracker.sdg(1);
+        tracker.cx(0, 1);
+        tracker.move_z_to_z(1, 2);
+        assert!(tracker.measure(5).is_err());
+        let live = storage_bytes(tracker.as_storage());
+        // three stacks with four bits each
+        assert_eq!(live, 3);
+        let mut stored = Map::<_>::default();
+        tracker.measure_and_store_all(&mut stored);
+
+        // other tests might run in parallel, so we can only check lower bounds
+        let metrics = snapshot().since(&start);
+        for gate in ["h", "sdg", "cx", "move_z_to_z"] {
+            assert!(metrics.gate(gate).unwrap() >= 1, "{gate}");
+        }
+        assert_eq!(metrics.gate("foo"), None);
+        assert!(metrics.frames_pushed >= 2);
+        assert!(metrics.lookups >= 6);
+        assert!(metrics.misses >= 2);
+        assert!(metrics.stack_reservations >= 3);
+        assert!(metrics.stored_bytes >= live as u64);
+    }
+}
@@ -216,6 +216,10 @@ impl Pauli {
     pub fn s(&mut self) {
         self.storage ^= (self.storage & 2) >> 1;
     }
+    /// Conjugate the Pauli with the square root of X Gate ignoring phases.
+    pub fn sx(&mut self) {
+        self.storage ^= (self.storage & 1) << 1;
+    }
 
     // is mask the correct word here?
     // write examples
@@ -56,6 +56,15 @@ impl<T: BooleanVector> PauliVec<T> {
         Self { left: T::new(), right: T::new() }
     }
 
+    /// Create a new empty [PauliVec] with enough capacity to hold `capacity` Paulis
+    /// without reallocating, cf. [BooleanVector::with_capacity].
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            left: T::with_capacity(capacity),
+            right: T::with_capacity(capacity),
+        }
+    }
+
     /// Create a [PauliVec] from two strings. `left` (`right`) corresponds to
     /// [PauliVec]s `left` (`right`) field.
     ///
@@ -126,6 +135,32 @@ impl<T: BooleanVector> PauliVec<T> {
         self.right.push(pauli.get_z());
     }
 
+    /// Reserve capacity for at least `additional` more Paulis, cf.
+    /// [BooleanVector::reserve].
+    pub fn reserve(&mut self, additional: usize) {
+        self.left.reserve(additional);
+        self.right.reserve(additional);
+    }
+
+    /// Push `num` identities onto the stack. As in [push](Self::push), a shorter part
+    /// of the stack is filled up first.
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// # use pauli_tracker::pauli::PauliVec;
+    /// let mut pauli = PauliVec::<Vec<bool>>::try_from_str("1", "").unwrap();
+    /// pauli.extend_zeros(2);
+    /// assert_eq!(pauli, PauliVec::try_from_str("100", "000").unwrap());
+    /// # }
+    /// ```
+    pub fn extend_zeros(&mut self, num: usize) {
+        let len = self.left.len().max(self.right.len());
+        self.left.extend_zeros(len + num - self.left.len());
+        self.right.extend_zeros(len + num - self.right.len());
+    }
+
     /// Pop the last element from the stack and return it. If one part of the stack,
     /// i.e., `left` or `right` is shorter than the other, it `false/0` is substituted
     /// for the missing value. Returns [None] if both parts of the stacks are empty.
@@ -186,6 +221,12 @@ impl<T: BooleanVector> PauliVec<T> {
         self.right.xor_inplace(&self.left);
     }
 
+    /// Apply the square root of X gate.
+    #[inline]
+    pub fn sx(&mut self) {
+        self.left.xor_inplace(&self.right);
+    }
+
     /// Multiply the Paulis, i.e., summing them up mod 2 in the tableau representation,
     /// with a `filter`, while neglecting any phases. An element `e` is filtered if
     /// `filter[i] = true` where `i` is `e`'s index in
@@ -221,6 +262,30 @@ impl<T: BooleanVector> PauliVec<T> {
             )
         }
     }
+
+    /// Like [sum_up](Self::sum_up), but with the `filter` given as boolean vector, e.g.,
+    /// the measurement outcomes. Compare [BooleanVector::sum_up_filter].
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// # use pauli_tracker::{pauli::{Pauli, PauliVec}, boolean_vector::BooleanVector};
+    /// let paulis = [Pauli::new_x(), Pauli::new_y(), Pauli::new_z(), Pauli::new_x()]
+    ///     .into_iter()
+    ///     .collect::<PauliVec<Vec<bool>>>();
+    /// let filter = vec![true, false, true, true];
+    /// assert_eq!(paulis.sum_up_filter(&filter), Pauli::new_z());
+    /// # }
+    /// ```
+    pub fn sum_up_filter(&self, filter: &T) -> Pauli {
+        // Safety: BooleanVector::sum_up_filter returns u8 <= 1
+        unsafe {
+            Pauli::from_unchecked(
+                self.right.sum_up_filter(filter) + self.left.sum_up_filter(filter) * 2,
+            )
+        }
+    }
 }
 
 impl<T: BooleanVector> FromIterator<Pauli> for PauliVec<T> {
@@ -106,8 +106,11 @@ macro_rules! track_pauli {
 ///
 /// For extensive examples, please refer to the [library documentation](crate#examples).
 ///
-/// *currently, the set of supported Cliffords is very limited, it will be extended over
-/// time*
+/// Besides the generators H, S and CX (or CZ), some other common Cliffords, like SWAP
+/// or iSWAP, are provided with default implementations in terms of the generators. The
+/// implementors in this library override them with fused implementations, which need
+/// less (or no) passes over the tracked Paulis. The conjugation rules are documented in
+/// [conjugation_rules.md](https://github.com/taeruh/pauli_tracker/blob/main/docs/conjugation_rules.md).
 pub trait Tracker {
     /// The storage type used to store the tracked Paulis for each qubit, e.g.,
     /// [PauliVec](crate::pauli::PauliVec) for the [Frames](frames::Frames) tracker.
@@ -135,6 +138,80 @@ pub trait Tracker {
     double!(cx, "Control X (Control Not)", control, target);
     double!(cz, "Control Z");
 
+    /// Update the tracked frames according to the S dagger gate on qu`bit`. Up to
+    /// Paulis, it is the same as the S gate.
+    #[inline]
+    fn sdg(&mut self, bit: usize) {
+        self.s(bit);
+    }
+
+    /// Update the tracked frames according to the square root of X gate on qu`bit`, i.e.,
+    /// H·S·H.
+    #[inline]
+    fn sx(&mut self, bit: usize) {
+        self.h(bit);
+        self.s(bit);
+        self.h(bit);
+    }
+
+    /// Update the tracked frames according to the inverse of the square root of X gate
+    /// on qu`bit`. Up to Paulis, it is the same as [Tracker::sx].
+    #[inline]
+    fn sxdg(&mut self, bit: usize) {
+        self.sx(bit);
+    }
+
+    /// Update the tracked frames according to the square root of Y gate on qu`bit`. Up
+    /// to Paulis, it is the same as the Hadamard gate.
+    #[inline]
+    fn sy(&mut self, bit: usize) {
+        self.h(bit);
+    }
+
+    /// Update the tracked frames according to the inverse of the square root of Y gate
+    /// on qu`bit`. Up to Paulis, it is the same as the Hadamard gate.
+    #[inline]
+    fn sydg(&mut self, bit: usize) {
+        self.h(bit);
+    }
+
+    /// Update the tracked frames according to the SWAP gate on the `bit_a` and `bit_b`
+    /// qubits.
+    #[inline]
+    fn swap(&mut self, bit_a: usize, bit_b: usize) {
+        self.cx(bit_a, bit_b);
+        self.cx(bit_b, bit_a);
+        self.cx(bit_a, bit_b);
+    }
+
+    /// Update the tracked frames according to the Control Y gate on the `control` and
+    /// `target` qubits.
+    #[inline]
+    fn cy(&mut self, control: usize, target: usize) {
+        self.s(target);
+        self.cx(control, target);
+        self.s(target);
+    }
+
+    /// Update the tracked frames according to the iSWAP gate on the `bit_a` and `bit_b`
+    /// qubits.
+    #[inline]
+    fn iswap(&mut self, bit_a: usize, bit_b: usize) {
+        self.h(bit_a);
+        self.cx(bit_a, bit_b);
+        self.cx(bit_b, bit_a);
+        self.h(bit_b);
+        self.s(bit_a);
+        self.s(bit_b);
+    }
+
+    /// Update the tracked frames according to the inverse of the iSWAP gate on the
+    /// `bit_a` and `bit_b` qubits. Up to Paulis, it is the same as [Tracker::iswap].
+    #[inline]
+    fn iswapdg(&mut self, bit_a: usize, bit_b: usize) {
+        self.iswap(bit_a, bit_b);
+    }
+
     movements!(
         (move_x_to_x, "X", "X"),
         (move_x_to_z, "X", "Z"),
@@ -148,11 +225,12 @@ pub trait Tracker {
 
 // {{ some helpers for simpler gate implementations
 macro_rules! unwrap_get_mut {
-    ($inner:expr, $bit:expr, $gate:expr) => {
+    ($inner:expr, $bit:expr, $gate:expr) => {{
+        metric!(lookups(1));
         $inner
             .get_mut($bit)
             .unwrap_or_else(|| panic!("{}: qubit {} does not exist", $gate, $bit))
-    };
+    }};
 }
 use unwrap_get_mut;
 
@@ -173,20 +251,22 @@ use unwrap_get_mut;
 // use create_single;
 
 macro_rules! unwrap_get_two_mut {
-    ($inner:expr, $bit_a:expr, $bit_b:expr, $gate:expr) => {
+    ($inner:expr, $bit_a:expr, $bit_b:expr, $gate:expr) => {{
+        metric!(lookups(2));
         $inner.get_two_mut($bit_a, $bit_b).unwrap_or_else(|| {
             panic!("{}: qubit {} and/or {} do not exist", $gate, $bit_a, $bit_b)
         })
-    };
+    }};
 }
 use unwrap_get_two_mut;
 // }}
 
 pub mod frames;
 pub mod live;
+pub mod sequence;
 
 #[cfg(test)]
-mod test {
+pub(crate) mod test {
     pub mod impl_utils {
         use super::super::*;
         use crate::{
@@ -205,12 +285,19 @@ mod test {
 
         // the following expected results are proven in ./docs/conjugation_rules.md
 
-        pub const N_SINGLES: usize = 2;
-        const SINGLE_GENERATORS: [(&str, [u8; 2]); N_SINGLES] =
+        pub const N_SINGLES: usize = 7;
+        const SINGLE_GENERATORS: [(&str, [u8; 2]); N_SINGLES] = [
             // (name, [conjugate X, conjugate Z])
-            [("H", [1, 2]), ("S", [3, 1])];
+            ("H", [1, 2]),
+            ("S", [3, 1]),
+            ("SDG", [3, 1]),
+            ("SX", [2, 3]),
+            ("SXDG", [2, 3]),
+            ("SY", [1, 2]),
+            ("SYDG", [1, 2]),
+        ];
 
-        pub const N_DOUBLES: usize = 6;
+        pub const N_DOUBLES: usize = 10;
         const DOUBLE_GENERATORS: [(&str, [(u8, u8); 4]); N_DOUBLES] = [
             // (name, [conjugate X1, conjugate Z1, conjugate 1X, conjugate 1Z])
             ("cx", [(2, 2), (1, 0), (0, 2), (1, 1)]),
@@ -221,6 +308,10 @@ mod test {
             ("move_x_to_z", [(0, 1), (1, 0), (0, 2), (0, 1)]),
             ("move_z_to_x", [(2, 0), (0, 2), (0, 2), (0, 1)]),
             ("move_z_to_z", [(2, 0), (0, 1), (0, 2), (0, 1)]),
+            ("swap", [(0, 2), (0, 1), (2, 0), (1, 0)]),
+            ("cy", [(2, 3), (1, 0), (1, 2), (1, 1)]),
+            ("iswap", [(1, 3), (0, 1), (3, 1), (1, 0)]),
+            ("iswapdg", [(1, 3), (0, 1), (3, 1), (1, 0)]),
         ];
 
         #[cfg_attr(coverage_nightly, no_coverage)]
@@ -19,6 +19,8 @@ use std::{
         Display,
         Formatter,
     },
+    io,
+    iter,
     mem,
 };
 
@@ -30,18 +32,32 @@ use serde::{
 
 use self::storage::StackStorage;
 use super::{
+    sequence::{
+        GateSequence,
+        LocalClifford,
+    },
     MissingStack,
     PauliString,
     Tracker,
 };
 use crate::{
     boolean_vector::BooleanVector,
+    collection::IntMap,
     pauli::{
         Pauli,
         PauliVec,
     },
 };
+#[cfg(feature = "analyse")]
+use crate::analyse::{
+    GraphError,
+    IncrementalDependencyGraph,
+};
 
+pub mod batch;
+#[cfg(feature = "rayon")]
+#[cfg_attr(docsrs, doc(cfg(feature = "rayon")))]
+pub mod parallel;
 pub mod storage;
 
 /// A container of multiple Pauli frames, using a generic `Storage` type  as internal
@@ -52,13 +68,36 @@ pub mod storage;
 /// [StackStorage]. The explicit storage type should have the [PauliVec]s on it's minor
 /// axis (this is more or less enforced by [StackStorage]). The module [storage]
 /// provides some compatible storage types.
+///
+/// The memory for new frames is reserved in all stacks at once, growing geometrically;
+/// if the number of frames is known beforehand, use
+/// [init_with_capacity](Frames::init_with_capacity) or
+/// [reserve_frames](Frames::reserve_frames) to avoid the reallocations completely.
+///
+/// With [set_lazy_cliffords](Frames::set_lazy_cliffords), the H and S gates are not
+/// applied directly to the stacks, but composed into a pending [LocalClifford] per
+/// qubit, which is applied with at most one pass over the stack when the stack is
+/// actually needed, e.g., for a two-qubit gate or a measurement.
 #[derive(Clone, Debug, Default)]
 #[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
 pub struct Frames<Storage> {
     storage: Storage,
     frames_num: usize,
+    // the number of frames that have been reserved in all stacks; it's not a part of
+    // the actual data
+    #[cfg_attr(feature = "serde", serde(skip))]
+    frames_capacity: usize,
+    #[cfg_attr(feature = "serde", serde(default))]
+    lazy_cliffords: bool,
+    // the single-qubit gates that still have to be applied on the stacks; only
+    // non-identities are stored
+    #[cfg_attr(feature = "serde", serde(default))]
+    pending: IntMap<usize, LocalClifford>,
 }
 
+// the minimal number of frames that is reserved when the stacks have to grow
+const MIN_FRAMES_RESERVE: usize = 64;
+
 /// The Error when we overwrite a qubit's Pauli stack.
 #[derive(Clone, PartialEq, Eq, PartialOrd, Ord, Default, Debug)]
 #[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
@@ -115,13 +154,100 @@ impl<T> From<MissingStack> for StoreError<T> {
     }
 }
 
+/// The Error when one tries to measure a qubit and stream it into a
+/// [StreamStorage](storage::StreamStorage), as in
+/// [measure_and_stream](Frames::measure_and_stream).
+///
+/// It can be a [StoreError], or an I/O error if the stack could not be written.
+#[derive(Debug)]
+pub enum StreamError<T> {
+    /// If the stack could not be stored, cf. [StoreError].
+    Store(StoreError<T>),
+    /// If the stack could not be written to the file.
+    Io(io::Error),
+}
+impl<T> Display for StreamError<T> {
+    fn fmt(&self, f: &mut Formatter<'_>) -> fmt::Result {
+        match self {
+            StreamError::Store(e) => write!(f, "{e}"),
+            StreamError::Io(e) => write!(f, "{e}"),
+        }
+    }
+}
+impl<T: Debug> Error for StreamError<T> {}
+
+impl<T> From<StoreError<T>> for StreamError<T> {
+    fn from(value: StoreError<T>) -> Self {
+        StreamError::Store(value)
+    }
+}
+impl<T> From<MissingStack> for StreamError<T> {
+    fn from(value: MissingStack) -> Self {
+        StreamError::Store(value.into())
+    }
+}
+impl<T> From<io::Error> for StreamError<T> {
+    fn from(value: io::Error) -> Self {
+        StreamError::Io(value)
+    }
+}
+
+/// The Error when one tries to measure a qubit and insert it into a dependency graph,
+/// as in [measure_and_record](Frames::measure_and_record).
+///
+/// It can be either a [MissingStack] error, if the qubit is missing, or a [GraphError]
+/// if the qubit cannot be inserted into the graph.
+#[cfg(feature = "analyse")]
+#[cfg_attr(docsrs, doc(cfg(feature = "analyse")))]
+#[derive(Clone, PartialEq, Eq, Debug)]
+pub enum RecordError {
+    /// If the qubit and its stack are missing.
+    MissingStack(MissingStack),
+    /// If the qubit cannot be inserted into the graph.
+    Graph(GraphError),
+}
+#[cfg(feature = "analyse")]
+impl Display for RecordError {
+    fn fmt(&self, f: &mut Formatter<'_>) -> fmt::Result {
+        match self {
+            RecordError::MissingStack(e) => write!(f, "{e}"),
+            RecordError::Graph(e) => write!(f, "{e}"),
+        }
+    }
+}
+#[cfg(feature = "analyse")]
+impl Error for RecordError {}
+
+#[cfg(feature = "analyse")]
+impl From<MissingStack> for RecordError {
+    fn from(value: MissingStack) -> Self {
+        RecordError::MissingStack(value)
+    }
+}
+#[cfg(feature = "analyse")]
+impl From<GraphError> for RecordError {
+    fn from(value: GraphError) -> Self {
+        RecordError::Graph(value)
+    }
+}
+
 impl<Storage> Frames<Storage> {
     /// Create a new [Frames] instance.
     pub fn new(storage: Storage, frames_num: usize) -> Self {
-        Self { storage, frames_num }
+        Self {
+            storage,
+            frames_num,
+            frames_capacity: 0,
+            lazy_cliffords: false,
+            pending: IntMap::default(),
+        }
     }
 
     /// Get the underlining storage.
+    ///
+    /// Note that the pending single-qubit gates in the
+    /// [lazy](Frames::set_lazy_cliffords) mode are not applied to it; call
+    /// [flush_cliffords](Frames::flush_cliffords) before if necessary.
     pub fn as_storage(&self) -> &Storage {
         &self.storage
     }
@@ -131,7 +257,28 @@ impl<Storage> Frames<Storage> {
         self.frames_num
     }
 
+    /// Get the number of frames for which memory has been reserved in the stacks, cf.
+    /// [reserve_frames](Frames::reserve_frames).
+    pub fn frames_capacity(&self) -> usize {
+        self.frames_capacity
+    }
+
+    /// Check whether the H and S gates are applied lazily, cf.
+    /// [set_lazy_cliffords](Frames::set_lazy_cliffords).
+    pub fn lazy_cliffords(&self) -> bool {
+        self.lazy_cliffords
+    }
+
+    /// The single-qubit gate that is pending on the qu`bit` in the
+    /// [lazy](Frames::set_lazy_cliffords) mode; if there's none, it is the identity.
+    pub fn pending_clifford(&self, bit: usize) -> LocalClifford {
+        self.pending.get(&bit).copied().unwrap_or_default()
+    }
+
     /// Convert the object into the underlining storage.
+    ///
+    /// As for [as_storage](Frames::as_storage), the pending single-qubit gates are not
+    /// applied.
     pub fn into_storage(self) -> Storage {
         self.storage
     }
@@ -153,6 +300,220 @@ impl<Storage> Frames<Storage>
 where
     Storage: StackStorage,
 {
+    /// Like [Tracker::init], but reserve memory for `frames_capacity` frames in all
+    /// stacks, e.g., the expected number of frames.
+    pub fn init_with_capacity(num_qubits: usize, frames_capacity: usize) -> Self {
+        let mut frames = Self::init(num_qubits);
+        frames.reserve_frames(frames_capacity);
+        frames
+    }
+
+    /// Reserve memory for at least `additional` more frames in all stacks, and for the
+    /// stacks of new qubits.
+    pub fn reserve_frames(&mut self, additional: usize) {
+        let capacity = self.frames_num + additional;
+        if capacity <= self.frames_capacity {
+            return;
+        }
+        for (_, stack) in self.storage.iter_mut() {
+            metric!(stack_reservations(1));
+            stack.reserve(additional);
+        }
+        self.frames_capacity = capacity;
+    }
+
+    // take all stacks, with the pending gates applied, out of the tracker, keeping its
+    // settings, e.g., to measure all qubits
+    pub(crate) fn take_stacks(&mut self) -> Storage {
+        self.flush_cliffords();
+        mem::replace(&mut self.storage, Storage::init(0))
+    }
+
+    // put stacks back that have been taken with take_stacks, e.g., if storing them
+    // failed
+    pub(crate) fn restore_stacks(
+        &mut self,
+        stacks: impl IntoIterator<Item = (usize, PauliVec<Storage::BoolVec>)>,
+    ) {
+        for (bit, stack) in stacks {
+            self.storage.insert_pauli(bit, stack);
+        }
+    }
+
+    // reserve geometrically growing memory when the reserved frames are used up
+    fn grow_frames(&mut self) {
+        if self.frames_num >= self.frames_capacity {
+            self.reserve_frames(self.frames_capacity.max(MIN_FRAMES_RESERVE));
+        }
+    }
+
+    /// Switch the lazy application of the H and S gates on or off.
+    ///
+    /// Applying H or S to a stack is a full pass over all its frames. If `lazy` is true,
+    /// the gates are instead composed in constant time into a pending [LocalClifford]
+    /// per qubit, which is only applied, with at most one pass, when the stack is read
+    /// or changed otherwise: by two-qubit gates, moves, measurements,
+    /// [apply_sequence](Frames::apply_sequence) and the like. Tracking new Paulis and
+    /// [compact_frames](Frames::compact_frames) don't need to apply the pending gates.
+    /// Switching it off applies all pending gates.
+    ///
+    /// This pays off for circuits with many single-qubit gates between the two-qubit
+    /// gates. Note that [as_storage](Frames::as_storage) and
+    /// [into_storage](Frames::into_storage) don't apply the pending gates; use
+    /// [flush_cliffords](Frames::flush_cliffords) before.
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::{
+    ///     pauli::PauliVec,
+    ///     tracker::{
+    ///         frames::{
+    ///             storage::Map,
+    ///             Frames,
+    ///         },
+    ///         sequence::LocalClifford,
+    ///         Tracker,
+    ///     },
+    /// };
+    /// let mut tracker = Frames::<Map<Vec<bool>>>::init(2);
+    /// tracker.set_lazy_cliffords(true);
+    /// tracker.track_x(0);
+    /// tracker.h(0);
+    /// tracker.s(0);
+    /// tracker.s(0);
+    /// // the stack is not touched yet
+    /// assert_eq!(tracker.pending_clifford(0), LocalClifford::h());
+    /// assert_eq!(
+    ///     tracker.as_storage().get(&0).unwrap(),
+    ///     &PauliVec::try_from_str("1", "0").unwrap()
+    /// );
+    /// tracker.cx(0, 1);
+    /// assert!(tracker.pending_clifford(0).is_identity());
+    /// assert_eq!(
+    ///     tracker.measure(0).unwrap(),
+    ///     PauliVec::try_from_str("0", "1").unwrap()
+    /// );
+    /// # }
+    /// ```
+    pub fn set_lazy_cliffords(&mut self, lazy: bool) {
+        if !lazy {
+            self.flush_cliffords();
+        }
+        self.lazy_cliffords = lazy;
+    }
+
+    /// Apply the pending single-qubit gates of all qubits, cf.
+    /// [set_lazy_cliffords](Frames::set_lazy_cliffords).
+    pub fn flush_cliffords(&mut self) {
+        for (bit, clifford) in mem::take(&mut self.pending) {
+            if let Some(stack) = self.storage.get_mut(bit) {
+                clifford.apply(stack);
+            }
+        }
+    }
+
+    /// Apply the pending single-qubit gate of the qu`bit`, cf.
+    /// [set_lazy_cliffords](Frames::set_lazy_cliffords).
+    #[inline]
+    pub fn flush_clifford(&mut self, bit: usize) {
+        if let Some(clifford) = self.pending.remove(&bit) {
+            if let Some(stack) = self.storage.get_mut(bit) {
+                clifford.apply(stack);
+            }
+        }
+    }
+
+    /// Remove all frames that are identities on all qubits in the tracker, e.g., because
+    /// all the qubits that the frame affected have been measured. Returns the indices
+    /// of the remaining frames, i.e., the new frame `i` is the old frame `kept[i]`
+    /// (where `kept` is the returned vector).
+    ///
+    /// Note that the stacks that have been measured before the compaction, e.g., via
+    /// [measure_and_store](Self::measure_and_store), still refer to the old frames, so
+    /// they have to be analyzed with the old `map`, e.g., in
+    /// [create_dependency_graph](crate::analyse::create_dependency_graph).
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::{
+    ///     pauli::PauliVec,
+    ///     tracker::{
+    ///         frames::{
+    ///             storage::{
+    ///                 Map,
+    ///                 StackStorage,
+    ///             },
+    ///             Frames,
+    ///         },
+    ///         Tracker,
+    ///     },
+    /// };
+    /// let mut tracker = Frames::<Map<Vec<bool>>>::init(3);
+    /// // the frames are corrections for the measurements of the qubits 10, 11, 12
+    /// let map = vec![10, 11, 12];
+    /// tracker.track_z(0);
+    /// tracker.track_x(1);
+    /// tracker.track_z(2);
+    /// tracker.cx(1, 2);
+    /// let _ = tracker.measure(0).unwrap();
+    ///
+    /// let kept = tracker.compact_frames();
+    /// assert_eq!(kept, vec![1, 2]);
+    /// let map: Vec<usize> = kept.iter().map(|frame| map[*frame]).collect();
+    /// assert_eq!(map, vec![11, 12]);
+    /// assert_eq!(tracker.frames_num(), 2);
+    /// assert_eq!(
+    ///     tracker.as_storage().get(&2).unwrap(),
+    ///     &PauliVec::try_from_str("10", "01").unwrap()
+    /// );
+    /// # }
+    /// ```
+    pub fn compact_frames(&mut self) -> Vec<usize> {
+        let frames_num = self.frames_num;
+        let mut used = Storage::BoolVec::zeros(frames_num);
+        let mut buffer = Storage::BoolVec::new();
+        for (_, stack) in self.storage.iter() {
+            for side in [&stack.left, &stack.right] {
+                if side.len() == frames_num {
+                    used.or_inplace(side);
+                } else {
+                    // a stack might be shorter if it has been moved
+                    buffer.clone_from(side);
+                    buffer.resize(frames_num, false);
+                    used.or_inplace(&buffer);
+                }
+            }
+        }
+
+        let kept: Vec<usize> = used
+            .iter_vals()
+            .enumerate()
+            .filter_map(|(frame, flag)| flag.then_some(frame))
+            .collect();
+        if kept.len() == frames_num {
+            return kept;
+        }
+
+        let compact = |side: &Storage::BoolVec| -> Storage::BoolVec {
+            side.iter_vals()
+                .zip(used.iter_vals())
+                .filter_map(|(flag, used)| used.then_some(flag))
+                .collect()
+        };
+        for (_, stack) in self.storage.iter_mut() {
+            stack.left = compact(&stack.left);
+            stack.right = compact(&stack.right);
+        }
+        self.frames_num = kept.len();
+        // the collected stacks don't have any spare capacity
+        self.frames_capacity = self.frames_num;
+        kept
+    }
+
     /// Pop the last tracked Pauli frame.
     pub fn pop_frame(&mut self) -> Option<PauliString> {
         if self.storage.is_empty() || self.frames_num == 0 {
@@ -161,6 +522,10 @@ where
         let mut ret = Vec::new();
         for (i, p) in self.storage.iter_mut() {
             if let Some(pauli) = p.pop() {
+                let pauli = match self.pending.get(&i) {
+                    Some(clifford) => clifford.conjugate(pauli),
+                    None => pauli,
+                };
                 ret.push((i, pauli))
             }
         }
@@ -168,6 +533,26 @@ where
         Some(ret)
     }
 
+    /// Get a borrowed view of the `frame` across all qubits, without popping or copying
+    /// it, in the iteration order of the storage; cf.
+    /// [FrameColumn](storage::FrameColumn). Returns [None] if the `frame` is not
+    /// tracked. To pack the frame into words, use [ColumnWords](storage::ColumnWords)
+    /// on the [storage](Self::as_storage), after applying the pending lazy Cliffords
+    /// with [flush_cliffords](Self::flush_cliffords).
+    pub fn frame(
+        &self,
+        frame: usize,
+    ) -> Option<impl Iterator<Item = (usize, Pauli)> + '_> {
+        if frame >= self.frames_num {
+            return None;
+        }
+        let conjugate = |(bit, pauli): (usize, Pauli)| match self.pending.get(&bit) {
+            Some(clifford) => (bit, clifford.conjugate(pauli)),
+            None => (bit, pauli),
+        };
+        Some(storage::FrameColumn::new(self.storage.iter(), frame).map(conjugate))
+    }
+
     /// Measure a qu`bit` and store the according stack of tracked Paulis into
     /// `storage`. Errors when the qu`bit` is not present in the tracker.
     pub fn measure_and_store(
@@ -175,30 +560,157 @@ where
         bit: usize,
         storage: &mut impl StackStorage<BoolVec = Storage::BoolVec>,
     ) -> Result<(), StoreError<Storage::BoolVec>> {
-        match storage.insert_pauli(bit, self.measure(bit)?) {
+        let stack = self.measure(bit)?;
+        metric!(stored_bytes(crate::metrics::stack_bytes(&stack)));
+        match storage.insert_pauli(bit, stack) {
             Some(p) => Err(OverwriteStack { bit, stack: p }.into()),
             None => Ok(()),
         }
     }
 
+    /// Like [measure_and_store](Self::measure_and_store), but the `storage` is shared
+    /// with other threads, e.g., other trackers that run on worker threads, cf.
+    /// [Sharded](storage::Sharded).
+    pub fn measure_and_store_shared(
+        &mut self,
+        bit: usize,
+        storage: &storage::Sharded<Storage::BoolVec>,
+    ) -> Result<(), StoreError<Storage::BoolVec>> {
+        let stack = self.measure(bit)?;
+        metric!(stored_bytes(crate::metrics::stack_bytes(&stack)));
+        match storage.insert_pauli(bit, stack) {
+            Some(p) => Err(OverwriteStack { bit, stack: p }.into()),
+            None => Ok(()),
+        }
+    }
+
+    /// Like [measure_and_store](Self::measure_and_store), but the stack is written to
+    /// a file-backed [StreamStorage](storage::StreamStorage). If writing fails, the
+    /// qu`bit` is not measured.
+    pub fn measure_and_stream(
+        &mut self,
+        bit: usize,
+        storage: &mut storage::StreamStorage<Storage::BoolVec>,
+    ) -> Result<(), StreamError<Storage::BoolVec>> {
+        let stack = self.measure(bit)?;
+        match storage.insert_ref(bit, &stack) {
+            Ok(Some(p)) => Err(StoreError::from(OverwriteStack { bit, stack: p }).into()),
+            Ok(None) => {
+                metric!(stored_bytes(crate::metrics::stack_bytes(&stack)));
+                Ok(())
+            }
+            Err(e) => {
+                self.storage.insert_pauli(bit, stack);
+                Err(e.into())
+            }
+        }
+    }
+
+    /// Measure a qu`bit`, insert it into the dependency `graph`, cf.
+    /// [IncrementalDependencyGraph::insert], and return the according stack of tracked
+    /// Paulis. Frame (i) belongs to the qubit `map`\[i\].
+    ///
+    /// If only the graph is needed, the returned stack can be dropped directly, so that
+    /// the memory only grows with the number of dependencies; otherwise, it can be put
+    /// into another storage, as in [measure_and_store](Self::measure_and_store).
+    ///
+    /// # Errors
+    /// Errors when the qu`bit` is not present in the tracker or when it cannot be
+    /// inserted into the `graph`. In both cases, the qu`bit` is not measured.
+    #[cfg(feature = "analyse")]
+    #[cfg_attr(docsrs, doc(cfg(feature = "analyse")))]
+    pub fn measure_and_record(
+        &mut self,
+        bit: usize,
+        graph: &mut IncrementalDependencyGraph,
+        map: &[usize],
+    ) -> Result<PauliVec<Storage::BoolVec>, RecordError> {
+        let stack = self.storage.get(bit).ok_or(MissingStack { bit })?;
+        graph.insert(bit, stack, map)?;
+        Ok(self.measure(bit).expect("we checked that the stack exists"))
+    }
+
     /// Measure all qubits and put the according stack of Paulis into `storage`, i.e.,
     /// do [Frames::measure_and_store] for all qubits.
     pub fn measure_and_store_all(
         &mut self,
         storage: &mut impl StackStorage<BoolVec = Storage::BoolVec>,
     ) {
-        for (bit, pauli) in
-            mem::replace(&mut self.storage, Storage::init(0)).into_iter()
-        {
+        for (bit, pauli) in self.take_stacks() {
+            metric!(stored_bytes(crate::metrics::stack_bytes(&pauli)));
             storage.insert_pauli(bit, pauli);
         }
     }
+
+    /// Measure all qubits and write the according stacks of Paulis into the
+    /// file-backed `storage`, i.e., do [Frames::measure_and_stream] for all qubits. If
+    /// writing fails, the qubits that have not been written yet stay in the tracker.
+    pub fn measure_and_stream_all(
+        &mut self,
+        storage: &mut storage::StreamStorage<Storage::BoolVec>,
+    ) -> io::Result<()> {
+        let mut stacks = self.take_stacks().into_iter();
+        while let Some((bit, pauli)) = stacks.next() {
+            if let Err(e) = storage.insert_ref(bit, &pauli) {
+                self.restore_stacks(iter::once((bit, pauli)).chain(stacks));
+                return Err(e);
+            }
+            metric!(stored_bytes(crate::metrics::stack_bytes(&pauli)));
+        }
+        Ok(())
+    }
+
+    /// Apply the gates of the `sequence`. This is equivalent to applying the gates one
+    /// after another, but each qubit is only looked up once in the storage, cf.
+    /// [sequence](super::sequence).
+    ///
+    /// # Panics
+    /// Panics if a qubit of the `sequence` does not exist. In that case, no gate is
+    /// applied.
+    pub fn apply_sequence(&mut self, sequence: &GateSequence) {
+        for bit in sequence.qubits() {
+            if self.storage.get(*bit).is_none() {
+                panic!("apply_sequence: qubit {bit} does not exist");
+            }
+        }
+        for bit in sequence.qubits() {
+            self.flush_clifford(*bit);
+        }
+        let mut stacks: Vec<PauliVec<Storage::BoolVec>> = sequence
+            .qubits()
+            .iter()
+            .map(|bit| {
+                mem::replace(
+                    unwrap_get_mut!(self.storage, *bit, "apply_sequence"),
+                    PauliVec::new(),
+                )
+            })
+            .collect();
+        sequence.run(&mut stacks);
+        for (bit, stack) in sequence.qubits().iter().zip(stacks) {
+            *unwrap_get_mut!(self.storage, *bit, "apply_sequence") = stack;
+        }
+    }
 }
 
+// the gate and the equivalent (up to Paulis) gate of PauliVec and LocalClifford
 macro_rules! single {
-    ($($name:ident),*) => {$(
+    ($(($name:ident, $gate:ident)),*) => {$(
         fn $name(&mut self, bit: usize) {
-            unwrap_get_mut!(self.storage, bit, stringify!($name)).$name()
+            metric!(gate(stringify!($name)));
+            if !self.lazy_cliffords {
+                return unwrap_get_mut!(self.storage, bit, stringify!($name)).$gate();
+            }
+            metric!(lookups(1));
+            if self.storage.get(bit).is_none() {
+                panic!("{}: qubit {} does not exist", stringify!($name), bit);
+            }
+            let clifford = self.pending_clifford(bit).then(LocalClifford::$gate());
+            if clifford.is_identity() {
+                self.pending.remove(&bit);
+            } else {
+                self.pending.insert(bit, clifford);
+            }
         }
     )*};
 }
@@ -221,6 +733,9 @@ macro_rules! movements {
         /// be used directly before the `origin` qubit is measured; otherwise it breaks
         /// the logic of other methods and might cause panics.
         fn $name(&mut self, source: usize, destination: usize) {
+            metric!(gate(stringify!($name)));
+            self.flush_clifford(source);
+            self.flush_clifford(destination);
             let (s, d) = unwrap_get_two_mut!(
                 self.storage,
                 source,
@@ -245,19 +760,30 @@ where
         Self {
             storage: Storage::init(num_qubits),
             frames_num: 0,
+            frames_capacity: 0,
+            lazy_cliffords: false,
+            pending: IntMap::default(),
         }
     }
 
     fn new_qubit(&mut self, qubit: usize) -> Option<usize> {
-        self.storage
-            .insert_pauli(qubit, Self::Stack::zeros(self.frames_num))
-            .map(|_| qubit)
+        let mut stack = Self::Stack::with_capacity(self.frames_capacity);
+        stack.extend_zeros(self.frames_num);
+        self.pending.remove(&qubit);
+        self.storage.insert_pauli(qubit, stack).map(|_| qubit)
     }
 
     fn track_pauli(&mut self, qubit: usize, pauli: Pauli) {
         if self.storage.is_empty() {
             return;
         }
+        self.grow_frames();
+        // instead of applying the pending gate, we push the Pauli that it maps to
+        // `pauli`; on the other qubits, the identity is invariant anyway
+        let pauli = match self.pending.get(&qubit) {
+            Some(clifford) => clifford.inverse().conjugate(pauli),
+            None => pauli,
+        };
         for (i, p) in self.storage.iter_mut() {
             if i == qubit {
                 p.push(pauli);
@@ -265,6 +791,7 @@ where
                 p.push(Pauli::new_i());
             }
         }
+        metric!(frames_pushed(1));
         self.frames_num += 1;
     }
 
@@ -272,35 +799,89 @@ where
         if self.storage.is_empty() {
             return;
         }
+        self.grow_frames();
         for (_, p) in self.storage.iter_mut() {
             p.push(Pauli::new_i());
         }
         for (i, p) in string {
+            let p = match self.pending.get(&i) {
+                Some(clifford) => clifford.inverse().conjugate(p),
+                None => p,
+            };
+            metric!(lookups(1));
             match self.storage.get_mut(i) {
                 Some(pauli) => {
                     pauli.left.set(self.frames_num, p.get_x());
                     pauli.right.set(self.frames_num, p.get_z());
                 }
-                None => continue,
+                None => {
+                    metric!(misses(1));
+                    continue;
+                }
             }
         }
+        metric!(frames_pushed(1));
         self.frames_num += 1;
     }
 
-    single!(h, s);
+    single!((h, h), (s, s), (sdg, s), (sx, sx), (sxdg, sx), (sy, h), (sydg, h));
 
     fn cx(&mut self, control: usize, target: usize) {
+        metric!(gate("cx"));
+        self.flush_clifford(control);
+        self.flush_clifford(target);
         let (c, t) = unwrap_get_two_mut!(self.storage, control, target, "cx");
         t.left.xor_inplace(&c.left);
         c.right.xor_inplace(&t.right);
     }
 
     fn cz(&mut self, bit_a: usize, bit_b: usize) {
+        metric!(gate("cz"));
+        self.flush_clifford(bit_a);
+        self.flush_clifford(bit_b);
         let (a, b) = unwrap_get_two_mut!(self.storage, bit_a, bit_b, "cz");
         a.right.xor_inplace(&b.left);
         b.right.xor_inplace(&a.left);
     }
 
+    fn swap(&mut self, bit_a: usize, bit_b: usize) {
+        metric!(gate("swap"));
+        let (a, b) = unwrap_get_two_mut!(self.storage, bit_a, bit_b, "swap");
+        // only the pointers are swapped, so the pending gates can just be swapped, too
+        mem::swap(a, b);
+        let pending_a = self.pending.remove(&bit_a);
+        if let Some(clifford) = self.pending.remove(&bit_b) {
+            self.pending.insert(bit_a, clifford);
+        }
+        if let Some(clifford) = pending_a {
+            self.pending.insert(bit_b, clifford);
+        }
+    }
+
+    fn cy(&mut self, control: usize, target: usize) {
+        metric!(gate("cy"));
+        self.flush_clifford(control);
+        self.flush_clifford(target);
+        let (c, t) = unwrap_get_two_mut!(self.storage, control, target, "cy");
+        c.right.xor_inplace(&t.left);
+        c.right.xor_inplace(&t.right);
+        t.left.xor_inplace(&c.left);
+        t.right.xor_inplace(&c.left);
+    }
+
+    fn iswap(&mut self, bit_a: usize, bit_b: usize) {
+        metric!(gate("iswap"));
+        self.flush_clifford(bit_a);
+        self.flush_clifford(bit_b);
+        let (a, b) = unwrap_get_two_mut!(self.storage, bit_a, bit_b, "iswap");
+        // = SWAP, then S on both and CZ
+        mem::swap(a, b);
+        a.right.xor_inplace(&a.left);
+        a.right.xor_inplace(&b.left);
+        b.right.xor_inplace(&b.left);
+        b.right.xor_inplace(&a.left);
+    }
+
     movements!(
         (move_x_to_x, left, left, "X", "X"),
         (move_x_to_z, left, right, "X", "Z"),
@@ -312,7 +893,12 @@ where
         &mut self,
         bit: usize,
     ) -> Result<PauliVec<Storage::BoolVec>, MissingStack> {
-        self.storage.remove_pauli(bit).ok_or(MissingStack { bit })
+        self.flush_clifford(bit);
+        metric!(lookups(1));
+        self.storage.remove_pauli(bit).ok_or_else(|| {
+            metric!(misses(1));
+            MissingStack { bit }
+        })
     }
 }
 
@@ -325,6 +911,208 @@ mod tests {
     // we only check the basic functionality here, more complicated circuits are tested
     // in [super::circuit] to test the tracker and the circuit at once
 
+    #[cfg(feature = "analyse")]
+    #[test]
+    fn compact_frames() {
+        type ThisTracker = Frames<storage::Map<Vec<bool>>>;
+        let mut tracker = ThisTracker::init(4);
+        let mut measured = storage::Map::<_>::default();
+        let map = vec![10, 11, 12, 13, 14];
+        tracker.track_z(0);
+        tracker.track_x(1);
+        tracker.track_z(2);
+        tracker.track_z(3);
+        tracker.cx(3, 1);
+        tracker.move_z_to_z(2, 3);
+        tracker.track_z(0);
+        tracker.measure_and_store(0, &mut measured).unwrap();
+        tracker.measure_and_store(2, &mut measured).unwrap();
+
+        // the measured qubits that the remaining frames belong to
+        let empty = PauliVec::<Vec<bool>>::new();
+        let origins = [11, 12, 13];
+        let graph = |tracker: &ThisTracker, map: &[usize]| {
+            crate::analyse::create_dependency_graph(
+                tracker
+                    .storage
+                    .iter()
+                    .map(|(bit, stack)| (*bit, stack))
+                    .chain(origins.iter().map(|bit| (*bit, &empty))),
+                map,
+            )
+        };
+        let expected = graph(&tracker, &map);
+        let kept = tracker.compact_frames();
+        assert_eq!(kept, vec![1, 2, 3]);
+        assert_eq!(tracker.frames_num(), 3);
+        let new_map: Vec<usize> = kept.iter().map(|frame| map[*frame]).collect();
+        assert_eq!(graph(&tracker, &new_map), expected);
+        assert_eq!(
+            storage::into_sorted_by_bit(tracker.clone().into_storage()),
+            vec![
+                (1, PauliVec::try_from_str("100", "000").unwrap()),
+                (3, PauliVec::try_from_str("000", "011").unwrap()),
+            ]
+        );
+        assert_eq!(tracker.compact_frames(), vec![0, 1, 2]);
+
+        tracker.track_z(1);
+        assert_eq!(tracker.pop_frame().unwrap().len(), 2);
+        assert_eq!(tracker.frames_num(), 3);
+    }
+
+    #[test]
+    fn reserve_frames() {
+        type ThisTracker = Frames<storage::Map<Vec<bool>>>;
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn capacity(tracker: &ThisTracker, bit: usize) -> usize {
+            let stack = tracker.as_storage().get(&bit).unwrap();
+            stack.left.capacity().min(stack.right.capacity())
+        }
+
+        let mut tracker = ThisTracker::init_with_capacity(2, 100);
+        assert_eq!(tracker.frames_capacity(), 100);
+        assert!(capacity(&tracker, 1) >= 100);
+        for i in 0..150 {
+            tracker.track_x(i % 2);
+        }
+        assert!(tracker.frames_capacity() >= 150);
+        tracker.new_qubit(2);
+        let stack = tracker.as_storage().get(&2).unwrap();
+        assert_eq!(stack, &PauliVec::zeros(150));
+        assert!(capacity(&tracker, 2) >= tracker.frames_capacity());
+
+        let mut tracker = ThisTracker::init(1);
+        tracker.track_z(0);
+        assert_eq!(tracker.frames_capacity(), MIN_FRAMES_RESERVE);
+        assert!(capacity(&tracker, 0) >= MIN_FRAMES_RESERVE);
+        let capacity = tracker.frames_capacity();
+        tracker.reserve_frames(3);
+        assert_eq!(tracker.frames_capacity(), capacity);
+    }
+
+    #[test]
+    fn measure_and_store_shared() {
+        type ThisTracker = Frames<storage::Map<Vec<bool>>>;
+        // each tracker owns 4 qubits, shifted by the thread index
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn track(thread: usize) -> ThisTracker {
+            let mut tracker = ThisTracker::new(storage::Map::default(), 0);
+            for bit in 4 * thread..4 * thread + 4 {
+                tracker.new_qubit(bit);
+            }
+            tracker.track_x(4 * thread);
+            tracker.cx(4 * thread, 4 * thread + 1);
+            tracker.track_z(4 * thread + 2);
+            tracker.h(4 * thread + 2);
+            tracker
+        }
+
+        let sink = storage::Sharded::default();
+        std::thread::scope(|scope| {
+            for thread in 0..4 {
+                let sink = &sink;
+                scope.spawn(move || {
+                    let mut tracker = track(thread);
+                    for bit in 4 * thread..4 * thread + 4 {
+                        tracker.measure_and_store_shared(bit, sink).unwrap();
+                    }
+                    assert!(tracker.measure_and_store_shared(0, sink).is_err());
+                });
+            }
+        });
+
+        let mut expected = storage::Map::<_>::default();
+        for thread in 0..4 {
+            track(thread).measure_and_store_all(&mut expected);
+        }
+        assert_eq!(
+            storage::into_sorted_by_bit(sink.into_storage::<storage::Map<_>>()),
+            storage::into_sorted_by_bit(expected)
+        );
+
+        let sink = storage::Sharded::new(2);
+        sink.insert_pauli(0, PauliVec::new());
+        assert_eq!(
+            track(0).measure_and_store_shared(0, &sink),
+            Err(StoreError::OverwriteStack(OverwriteStack {
+                bit: 0,
+                stack: PauliVec::new()
+            }))
+        );
+    }
+
+    #[test]
+    fn lazy_cliffords() {
+        type ThisTracker = Frames<storage::Map<Vec<bool>>>;
+        const NUM_BITS: usize = 5;
+        let mut eager = ThisTracker::init(NUM_BITS);
+        let mut lazy = ThisTracker::init(NUM_BITS);
+        lazy.set_lazy_cliffords(true);
+        assert!(lazy.lazy_cliffords());
+
+        for i in 0..300usize {
+            let a = (i * 7 + 3) % NUM_BITS;
+            let b = (a + 1 + i % (NUM_BITS - 1)) % NUM_BITS;
+            for tracker in [&mut eager, &mut lazy] {
+                match (i * 5) % 16 {
+                    0..=2 => tracker.h(a),
+                    3..=5 => tracker.s(a),
+                    6 => tracker.sx(a),
+                    7 => tracker.sy(a),
+                    8 => tracker.cx(a, b),
+                    9 => tracker.cz(a, b),
+                    10 => tracker.swap(a, b),
+                    11 => tracker.cy(a, b),
+                    12 => tracker.iswap(a, b),
+                    13 => tracker
+                        .track_pauli(a, Pauli::try_from((i % 3 + 1) as u8).unwrap()),
+                    14 => tracker.track_pauli_string(vec![
+                        (a, Pauli::new_y()),
+                        (b, Pauli::new_x()),
+                    ]),
+                    _ => {
+                        tracker.pop_frame();
+                    }
+                }
+            }
+        }
+        let view = |tracker: &ThisTracker| {
+            let mut frame = tracker
+                .frame(tracker.frames_num() - 1)
+                .unwrap()
+                .collect::<Vec<_>>();
+            frame.sort_by_key(|(bit, _)| *bit);
+            frame
+        };
+        let pop = |tracker: &mut ThisTracker| {
+            let mut frame = tracker.pop_frame().unwrap();
+            frame.sort_by_key(|(bit, _)| *bit);
+            frame
+        };
+        assert!(lazy.frame(lazy.frames_num()).is_none());
+        let viewed = view(&lazy);
+        assert_eq!(viewed, view(&eager));
+        assert_eq!(pop(&mut lazy), viewed);
+        assert_eq!(pop(&mut eager), viewed);
+        assert_eq!(lazy.compact_frames(), eager.compact_frames());
+        assert_eq!(lazy.measure(3), eager.measure(3));
+
+        let mut flushed = lazy.clone();
+        flushed.flush_cliffords();
+        assert!(flushed.lazy_cliffords());
+        assert_eq!(
+            storage::into_sorted_by_bit(flushed.into_storage()),
+            storage::into_sorted_by_bit(eager.clone().into_storage())
+        );
+        lazy.set_lazy_cliffords(false);
+        assert!((0..NUM_BITS).all(|bit| lazy.pending_clifford(bit).is_identity()));
+        assert_eq!(
+            storage::into_sorted_by_bit(lazy.into_storage()),
+            storage::into_sorted_by_bit(eager.into_storage())
+        );
+    }
+
     #[cfg(feature = "bitvec")]
     // #[cfg(feature = "bitvec_simd")]
     mod action_definition_check {
@@ -358,7 +1146,15 @@ mod tests {
         fn single() {
             type Action = SingleAction<ThisTracker>;
 
-            const ACTIONS: [Action; N_SINGLES] = [Frames::h, Frames::s];
+            const ACTIONS: [Action; N_SINGLES] = [
+                Frames::h,
+                Frames::s,
+                Frames::sdg,
+                Frames::sx,
+                Frames::sxdg,
+                Frames::sy,
+                Frames::sydg,
+            ];
 
             #[cfg_attr(coverage_nightly, no_coverage)]
             fn runner(action: Action, result: SingleResults) {
@@ -393,6 +1189,10 @@ mod tests {
                 Frames::move_x_to_z,
                 Frames::move_z_to_x,
                 Frames::move_z_to_z,
+                Frames::swap,
+                Frames::cy,
+                Frames::iswap,
+                Frames::iswapdg,
             ];
 
             #[cfg_attr(coverage_nightly, no_coverage)]
@@ -0,0 +1,312 @@
+/*!
+A frame-major buffer for new frames, which can be added in bulk to [Frames].
+
+[Tracker::track_pauli] and [Tracker::track_pauli_string] push one bit onto every
+qubit's Pauli stack for every new frame, i.e., every new frame costs a scattered write
+over all stacks. A [FrameBatch] instead buffers the frames frame-major in blocks of
+64×64 bits (64 frames × 64 qubits). When the batch is added to [Frames] via
+[Frames::track_batch], each block is transposed and appended as whole words to the
+qubit-major [PauliVec](crate::pauli::PauliVec) stacks, which is especially efficient
+in combination with word storing bit-vectors, like
+[PackedBitVec](crate::boolean_vector::packed::PackedBitVec), that overwrite
+[BooleanVector::extend_from_word].
+
+[Tracker::track_pauli]: crate::tracker::Tracker::track_pauli
+[Tracker::track_pauli_string]: crate::tracker::Tracker::track_pauli_string
+*/
+
+use super::{
+    storage::StackStorage,
+    Frames,
+};
+use crate::{
+    boolean_vector::BooleanVector,
+    pauli::Pauli,
+    tracker::PauliString,
+};
+
+const BLOCK: usize = 64;
+
+type Matrix = [u64; BLOCK];
+
+/// A buffer of frames on the qubits 0, ..., `num_bits` - 1, cf. the
+/// [module](self) documentation.
+///
+/// Paulis on qubits that are not in this range are ignored when they are tracked.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::{
+///         Pauli,
+///         PauliVec,
+///     },
+///     tracker::{
+///         frames::{
+///             batch::FrameBatch,
+///             storage::{
+///                 self,
+///                 Vector,
+///             },
+///             Frames,
+///         },
+///         Tracker,
+///     },
+/// };
+/// let mut frames = Frames::<Vector<Vec<bool>>>::init(2);
+/// let mut batch = FrameBatch::new(2);
+/// batch.track_pauli(0, Pauli::new_x());
+/// batch.track_pauli_string(vec![(0, Pauli::new_z()), (1, Pauli::new_y())]);
+/// frames.track_batch(&mut batch);
+/// assert!(batch.is_empty());
+/// assert_eq!(frames.frames_num(), 2);
+/// assert_eq!(
+///     storage::into_sorted_by_bit(frames.into_storage()),
+///     vec![
+///         (0, PauliVec::try_from_str("10", "01").unwrap()),
+///         (1, PauliVec::try_from_str("01", "01").unwrap())
+///     ]
+/// );
+/// # }
+/// ```
+#[derive(Clone, PartialEq, Eq, Debug)]
+pub struct FrameBatch {
+    num_bits: usize,
+    num_frames: usize,
+    // x[chunk][group] is the 64×64 bit matrix of the frames 64*chunk .. 64*(chunk +
+    // 1) on the qubits 64*group .. 64*(group + 1); row = frame and column (bit in word)
+    // = qubit
+    x: Vec<Vec<Matrix>>,
+    z: Vec<Vec<Matrix>>,
+}
+
+impl FrameBatch {
+    /// Create a new empty batch for the qubits 0, ..., `num_bits` - 1.
+    pub fn new(num_bits: usize) -> Self {
+        Self {
+            num_bits,
+            num_frames: 0,
+            x: Vec::new(),
+            z: Vec::new(),
+        }
+    }
+
+    /// Get the number of buffered frames.
+    pub fn num_frames(&self) -> usize {
+        self.num_frames
+    }
+
+    /// Check whether the batch contains no frames.
+    pub fn is_empty(&self) -> bool {
+        self.num_frames == 0
+    }
+
+    /// Remove all frames, keeping the allocated memory.
+    pub fn clear(&mut self) {
+        for chunk in self.x.iter_mut().chain(self.z.iter_mut()) {
+            for matrix in chunk.iter_mut() {
+                *matrix = [0; BLOCK];
+            }
+        }
+        self.num_frames = 0;
+    }
+
+    /// Buffer a new frame consisting of the [Pauli] gate `pauli` at qu`bit`, cf.
+    /// [Tracker::track_pauli](crate::tracker::Tracker::track_pauli).
+    pub fn track_pauli(&mut self, bit: usize, pauli: Pauli) {
+        self.new_frame();
+        self.set(bit, pauli);
+    }
+
+    /// Buffer a new frame including multiple [Pauli] gates, cf.
+    /// [Tracker::track_pauli_string](crate::tracker::Tracker::track_pauli_string).
+    pub fn track_pauli_string(&mut self, string: PauliString) {
+        self.new_frame();
+        for (bit, pauli) in string {
+            self.set(bit, pauli);
+        }
+    }
+
+    fn new_frame(&mut self) {
+        if self.num_frames % BLOCK == 0 && self.num_frames / BLOCK == self.x.len() {
+            let groups = (self.num_bits + BLOCK - 1) / BLOCK;
+            self.x.push(vec![[0; BLOCK]; groups]);
+            self.z.push(vec![[0; BLOCK]; groups]);
+        }
+        self.num_frames += 1;
+    }
+
+    fn set(&mut self, bit: usize, pauli: Pauli) {
+        if bit >= self.num_bits {
+            return;
+        }
+        let frame = self.num_frames - 1;
+        let (chunk, row) = (frame / BLOCK, frame % BLOCK);
+        let (group, column) = (bit / BLOCK, bit % BLOCK);
+        let mask = 1 << column;
+        let (x, z) = (&mut self.x[chunk][group][row], &mut self.z[chunk][group][row]);
+        *x = (*x & !mask) | ((pauli.get_x() as u64) << column);
+        *z = (*z & !mask) | ((pauli.get_z() as u64) << column);
+    }
+}
+
+/// Transpose the 64×64 bit `matrix` inplace, where the rows are the words and the
+/// columns the bits in the words (least significant bit first).
+// the standard recursive block swap, cf. "Hacker's Delight", section 7-3
+pub(crate) fn transpose(matrix: &mut Matrix) {
+    let mut width = 32;
+    let mut mask: u64 = 0x0000_0000_ffff_ffff;
+    while width != 0 {
+        let mut k = 0;
+        while k < BLOCK {
+            let t = ((matrix[k] >> width) ^ matrix[k + width]) & mask;
+            matrix[k] ^= t << width;
+            matrix[k + width] ^= t;
+            k = (k + width + 1) & !width;
+        }
+        width >>= 1;
+        mask ^= mask << width;
+    }
+}
+
+impl<Storage> Frames<Storage>
+where
+    Storage: StackStorage,
+{
+    /// Add all frames buffered in `batch` to the tracked frames and clear the `batch`.
+    ///
+    /// This is equivalent to calling [Tracker::track_pauli_string] for every buffered
+    /// frame, but the bits are transposed and appended word-wise, cf. the
+    /// [module](self) documentation.
+    ///
+    /// [Tracker::track_pauli_string]: crate::tracker::Tracker::track_pauli_string
+    pub fn track_batch(&mut self, batch: &mut FrameBatch) {
+        if self.storage.is_empty() || batch.is_empty() {
+            batch.clear();
+            return;
+        }
+        // the new frames are written directly into the stacks
+        self.flush_cliffords();
+        self.reserve_frames(batch.num_frames);
+        let frames_num = self.frames_num;
+        for (_, stack) in self.storage.iter_mut() {
+            // the same as in PauliVec::push; a stack might be shorter if it has been
+            // moved
+            if stack.left.len() != frames_num {
+                stack.left.resize(frames_num, false);
+            }
+            if stack.right.len() != frames_num {
+                stack.right.resize(frames_num, false);
+            }
+        }
+
+        for (chunk_idx, (x_chunk, z_chunk)) in
+            batch.x.iter_mut().zip(batch.z.iter_mut()).enumerate()
+        {
+            let num = batch.num_frames.saturating_sub(chunk_idx * BLOCK).min(BLOCK);
+            if num == 0 {
+                break;
+            }
+            for matrix in x_chunk.iter_mut().chain(z_chunk.iter_mut()) {
+                transpose(matrix);
+            }
+            for (bit, stack) in self.storage.iter_mut() {
+                let (x, z) = if bit < batch.num_bits {
+                    let (group, row) = (bit / BLOCK, bit % BLOCK);
+                    (x_chunk[group][row], z_chunk[group][row])
+                } else {
+                    (0, 0)
+                };
+                stack.left.extend_from_word(x, num);
+                stack.right.extend_from_word(z, num);
+            }
+        }
+
+        metric!(frames_pushed(batch.num_frames));
+        self.frames_num += batch.num_frames;
+        batch.clear();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::packed::PackedBitVec,
+        tracker::{
+            frames::storage::{
+                self,
+                Map,
+                Vector,
+            },
+            Tracker,
+        },
+    };
+
+    #[test]
+    fn transpose_matrix() {
+        let mut matrix = [0; BLOCK];
+        for (i, row) in matrix.iter_mut().enumerate() {
+            *row = (i as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15) ^ (i as u64) << 3;
+        }
+        let mut transposed = matrix;
+        transpose(&mut transposed);
+        for (r, row) in matrix.iter().enumerate() {
+            for (c, column) in transposed.iter().enumerate() {
+                assert_eq!((row >> c) & 1, (column >> r) & 1, "{r}, {c}");
+            }
+        }
+        transpose(&mut transposed);
+        assert_eq!(transposed, matrix);
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn string(frame: usize, num_bits: usize) -> PauliString {
+        (0..num_bits + 3)
+            .filter(|bit| (bit * 13 + frame * 7) % 5 < 2)
+            .map(|bit| (bit, Pauli::try_from(((bit + frame) % 4) as u8).unwrap()))
+            .collect()
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn compare<S>(num_bits: usize)
+    where
+        S: StackStorage,
+        S::BoolVec: PartialEq,
+    {
+        let mut expected = Frames::<S>::init(num_bits);
+        let mut frames = Frames::<S>::init(num_bits);
+        let mut batch = FrameBatch::new(num_bits);
+        for round in 0..3 {
+            for frame in 0..(70 * round + 5) {
+                let string = string(frame, num_bits);
+                expected.track_pauli_string(string.clone());
+                batch.track_pauli_string(string);
+            }
+            expected.track_pauli(1, Pauli::new_y());
+            batch.track_pauli(1, Pauli::new_y());
+            expected.cx(0, 2);
+            expected.move_z_to_z(1, 0);
+            frames.track_batch(&mut batch);
+            frames.cx(0, 2);
+            frames.move_z_to_z(1, 0);
+            assert!(batch.is_empty());
+            assert_eq!(frames.frames_num(), expected.frames_num());
+        }
+        assert_eq!(
+            storage::into_sorted_by_bit(frames.into_storage()),
+            storage::into_sorted_by_bit(expected.into_storage())
+        );
+    }
+
+    #[test]
+    fn compare_with_track_pauli_string() {
+        compare::<Vector<PackedBitVec>>(130);
+        compare::<Vector<Vec<bool>>>(67);
+        compare::<Map<PackedBitVec>>(3);
+    }
+}
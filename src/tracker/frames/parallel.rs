@@ -0,0 +1,324 @@
+/*!
+Apply layers of gates on disjoint qubits with multiple threads, using [rayon].
+
+The [Tracker](crate::tracker::Tracker) methods apply the gates one after another,
+however, gates that act on disjoint qubits touch independent [PauliVec]s in [Frames].
+[Frames::par_apply_layer] splits the storage borrow into the disjoint stacks of such a
+layer and applies the gates in parallel. Additionally, every XOR operation is done via
+[BooleanVector::par_xor_inplace], which splits the work into word-chunks for long
+stacks (cf., e.g., [PackedBitVec](crate::boolean_vector::packed::PackedBitVec)).
+
+After the measurements, [par_sum_up_all] resolves the corrections of all stacks of a
+storage in parallel.
+*/
+
+use super::{
+    storage::StackStorage,
+    Frames,
+};
+use crate::{
+    boolean_vector::BooleanVector,
+    collection::IntMap,
+    pauli::{
+        Pauli,
+        PauliVec,
+    },
+    tracker::sequence::{
+        self,
+        DoubleGate,
+        Gate,
+        Instruction,
+        LocalClifford,
+    },
+};
+
+enum Job<'l, B> {
+    Single(LocalClifford, &'l mut PauliVec<B>),
+    Double(DoubleGate, &'l mut PauliVec<B>, &'l mut PauliVec<B>),
+}
+
+impl<B: BooleanVector> Job<'_, B> {
+    fn run(&mut self) {
+        match self {
+            Job::Single(clifford, stack) => {
+                clifford.apply_with(stack, B::par_xor_inplace)
+            }
+            Job::Double(gate, a, b) => {
+                sequence::double_with(*gate, a, b, B::par_xor_inplace)
+            }
+        }
+    }
+}
+
+fn run<B: BooleanVector + Send>(jobs: &mut [Job<'_, B>]) {
+    match jobs {
+        [] => {}
+        [job] => job.run(),
+        _ => {
+            let (a, b) = jobs.split_at_mut(jobs.len() / 2);
+            rayon::join(|| run(a), || run(b));
+        }
+    }
+}
+
+fn sum_up<B: BooleanVector + Sync>(
+    stacks: &[(usize, &PauliVec<B>)],
+    outcomes: &B,
+    results: &mut [(usize, Pauli)],
+) {
+    match stacks {
+        [] => {}
+        [(bit, stack)] => results[0] = (*bit, stack.sum_up_filter(outcomes)),
+        _ => {
+            let mid = stacks.len() / 2;
+            let (stacks_a, stacks_b) = stacks.split_at(mid);
+            let (results_a, results_b) = results.split_at_mut(mid);
+            rayon::join(
+                || sum_up(stacks_a, outcomes, results_a),
+                || sum_up(stacks_b, outcomes, results_b),
+            );
+        }
+    }
+}
+
+/// Like [storage::sum_up_all](super::storage::sum_up_all), but the stacks are summed up
+/// in parallel.
+pub fn par_sum_up_all<S>(storage: &S, outcomes: &S::BoolVec) -> Vec<(usize, Pauli)>
+where
+    S: StackStorage,
+    S::BoolVec: Sync,
+{
+    let stacks: Vec<(usize, &PauliVec<S::BoolVec>)> = storage.iter().collect();
+    let mut results = vec![(0, Pauli::new_i()); stacks.len()];
+    sum_up(&stacks, outcomes, &mut results);
+    results
+}
+
+impl<Storage> Frames<Storage>
+where
+    Storage: StackStorage,
+    Storage::BoolVec: Send,
+{
+    /// Apply the `layer` of gates, which have to act on pairwise different qubits, in
+    /// parallel, cf. the [module](self) documentation.
+    ///
+    /// This is equivalent to applying the gates one after another, in any order.
+    ///
+    /// # Panics
+    /// Panics if a qubit appears multiple times in the `layer` or if a qubit does not
+    /// exist. In that case, no gate is applied.
+    ///
+    /// # Examples
+    /// ```
+    /// # #[cfg_attr(coverage_nightly, no_coverage)]
+    /// # fn main() {
+    /// use pauli_tracker::{
+    ///     pauli::PauliVec,
+    ///     tracker::{
+    ///         frames::{
+    ///             storage::Vector,
+    ///             Frames,
+    ///         },
+    ///         sequence::Gate,
+    ///         Tracker,
+    ///     },
+    /// };
+    /// let mut frames = Frames::<Vector<Vec<bool>>>::init(4);
+    /// frames.track_x(0);
+    /// frames.track_x(3);
+    /// frames.par_apply_layer(&[Gate::Cx(0, 1), Gate::Cz(2, 3)]);
+    /// assert_eq!(
+    ///     frames.into_storage().frames,
+    ///     vec![
+    ///         PauliVec::try_from_str("10", "00").unwrap(),
+    ///         PauliVec::try_from_str("10", "00").unwrap(),
+    ///         PauliVec::try_from_str("00", "01").unwrap(),
+    ///         PauliVec::try_from_str("01", "00").unwrap(),
+    ///     ]
+    /// );
+    /// # }
+    /// ```
+    pub fn par_apply_layer(&mut self, layer: &[Gate]) {
+        let instructions: Vec<Instruction> =
+            layer.iter().map(|gate| Instruction::from(*gate)).collect();
+
+        // qubit -> slot
+        let mut slots = IntMap::default();
+        let mut insert = |bit: usize| {
+            let slot = slots.len();
+            if slots.insert(bit, slot).is_some() {
+                panic!(
+                    "par_apply_layer: qubit {bit} appears multiple times in the layer"
+                );
+            }
+        };
+        for instruction in instructions.iter() {
+            match *instruction {
+                Instruction::Single(bit, _) => insert(bit),
+                Instruction::Double(_, a, b) => {
+                    insert(a);
+                    insert(b);
+                }
+            }
+        }
+
+        for bit in slots.keys() {
+            self.flush_clifford(*bit);
+        }
+
+        // the storage can only hand out all the mutable references at once through
+        // iter_mut, so we split the borrow there instead of looking up each qubit
+        let mut stacks: Vec<Option<&mut PauliVec<Storage::BoolVec>>> =
+            (0..slots.len()).map(|_| None).collect();
+        for (bit, stack) in self.storage.iter_mut() {
+            if let Some(slot) = slots.get(&bit) {
+                stacks[*slot] = Some(stack);
+            }
+        }
+        if let Some((bit, _)) = slots.iter().find(|(_, slot)| stacks[**slot].is_none())
+        {
+            panic!("par_apply_layer: qubit {bit} does not exist");
+        }
+
+        let mut stacks = stacks
+            .into_iter()
+            .map(|stack| stack.expect("bug: we checked above that all stacks exist"));
+        let mut jobs: Vec<Job<'_, Storage::BoolVec>> = instructions
+            .into_iter()
+            .map(|instruction| match instruction {
+                // the slots have been assigned in the order of the instructions
+                Instruction::Single(_, clifford) => {
+                    Job::Single(clifford, stacks.next().unwrap())
+                }
+                Instruction::Double(gate, _, _) => {
+                    Job::Double(gate, stacks.next().unwrap(), stacks.next().unwrap())
+                }
+            })
+            .collect();
+
+        run(&mut jobs);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::packed::PackedBitVec,
+        pauli::Pauli,
+        tracker::{
+            frames::storage::{
+                self,
+                Map,
+                Vector,
+            },
+            Tracker,
+        },
+    };
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn layer(num_bits: usize, round: usize) -> Vec<Gate> {
+        (0..num_bits / 2)
+            .map(|i| {
+                let (a, b) =
+                    ((2 * i + round) % num_bits, (2 * i + 1 + round) % num_bits);
+                match (i + round) % 9 {
+                    0 => Gate::Cx(a, b),
+                    1 => Gate::Cz(a, b),
+                    2 => Gate::Cx(b, a),
+                    3 => Gate::H(a),
+                    4 => Gate::Cy(b, a),
+                    5 => Gate::Swap(a, b),
+                    6 => Gate::ISwap(a, b),
+                    7 => Gate::SX(a),
+                    _ => Gate::S(b),
+                }
+            })
+            .collect()
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn compare<S>(num_bits: usize, num_frames: usize)
+    where
+        S: StackStorage + Clone,
+        S::BoolVec: Send + PartialEq,
+    {
+        let mut expected = Frames::<S>::init(num_bits);
+        for frame in 0..num_frames {
+            expected.track_pauli_string(
+                (0..num_bits)
+                    .filter(|bit| (bit + frame) % 3 == 0)
+                    .map(|bit| {
+                        (bit, Pauli::try_from(((bit * 7 + frame) % 4) as u8).unwrap())
+                    })
+                    .collect(),
+            );
+        }
+        let mut frames = expected.clone();
+        for round in 0..6 {
+            let layer = layer(num_bits, round);
+            frames.par_apply_layer(&layer);
+            for gate in layer {
+                match gate {
+                    Gate::H(bit) => expected.h(bit),
+                    Gate::S(bit) => expected.s(bit),
+                    Gate::Cx(a, b) => expected.cx(a, b),
+                    Gate::Cz(a, b) => expected.cz(a, b),
+                    Gate::Cy(a, b) => expected.cy(a, b),
+                    Gate::Swap(a, b) => expected.swap(a, b),
+                    Gate::ISwap(a, b) => expected.iswap(a, b),
+                    Gate::SX(bit) => expected.sx(bit),
+                    _ => unreachable!(),
+                }
+            }
+        }
+        assert_eq!(
+            storage::into_sorted_by_bit(frames.into_storage()),
+            storage::into_sorted_by_bit(expected.into_storage())
+        );
+    }
+
+    #[test]
+    fn compare_with_sequential() {
+        compare::<Vector<PackedBitVec>>(10, 300);
+        compare::<Vector<Vec<bool>>>(7, 100);
+        compare::<Map<PackedBitVec>>(9, 70);
+    }
+
+    #[test]
+    fn sum_up_all() {
+        let outcomes = (0..500).map(|i| i % 3 != 1).collect::<PackedBitVec>();
+        let filter = outcomes.iter_vals().collect::<Vec<_>>();
+        let storage = Map::<PackedBitVec>::from_iter((0..20).map(|bit| {
+            (
+                bit,
+                (0..500)
+                    .map(|i| Pauli::try_from(((bit * 7 + i * i) % 4) as u8).unwrap())
+                    .collect::<PauliVec<_>>(),
+            )
+        }));
+        let expected = storage
+            .iter()
+            .map(|(bit, stack)| (*bit, stack.sum_up(&filter)))
+            .collect::<Vec<_>>();
+        assert_eq!(storage::sum_up_all(&storage, &outcomes), expected);
+        assert_eq!(par_sum_up_all(&storage, &outcomes), expected);
+        assert_eq!(par_sum_up_all(&Map::<PackedBitVec>::default(), &outcomes), vec![]);
+    }
+
+    #[test]
+    #[should_panic]
+    fn overlapping_qubits() {
+        let mut frames = Frames::<Vector<Vec<bool>>>::init(3);
+        frames.par_apply_layer(&[Gate::Cx(0, 1), Gate::H(1)]);
+    }
+
+    #[test]
+    #[should_panic]
+    fn missing_qubit() {
+        let mut frames = Frames::<Map<Vec<bool>>>::init(3);
+        frames.par_apply_layer(&[Gate::Cx(0, 3)]);
+    }
+}
@@ -5,7 +5,10 @@ analyze the storage.
 
 use crate::{
     boolean_vector::BooleanVector,
-    pauli::PauliVec,
+    pauli::{
+        Pauli,
+        PauliVec,
+    },
 };
 
 /// This trait describes the functionality that a storage of [PauliVec]s must provide to
@@ -100,6 +103,10 @@ pub trait StackStorage:
 }
 
 /// Sort the `storage` according to the qubits numbers.
+///
+/// This collects and sorts the stacks on each call. To iterate in qubit order
+/// repeatedly, use a [SortedIndex], [Slab::iter_sorted], or, for [Vector], simply
+/// [StackStorage::iter], which is already sorted.
 pub fn sort_by_bit<B: StackStorage>(
     storage: &B,
 ) -> Vec<(usize, &PauliVec<B::BoolVec>)> {
@@ -117,19 +124,108 @@ pub fn into_sorted_by_bit<B: StackStorage>(
     ret
 }
 
+/// Resolve the corrections of all qubits in the `storage` in one pass over it, given
+/// the `outcomes` of the measurements that belong to the frames, i.e., sum up each
+/// stack with [PauliVec::sum_up_filter]. The results are in the iteration order of the
+/// `storage`. With the "rayon" feature,
+/// [par_sum_up_all](super::parallel::par_sum_up_all) does the same in parallel.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     boolean_vector::packed::PackedBitVec,
+///     pauli::{
+///         Pauli,
+///         PauliVec,
+///     },
+///     tracker::frames::storage::{
+///         self,
+///         StackStorage,
+///         Vector,
+///     },
+/// };
+/// let storage = Vector::<PackedBitVec>::from_iter([
+///     (0, PauliVec::try_from_str("110", "011").unwrap()),
+///     (1, PauliVec::try_from_str("001", "100").unwrap()),
+/// ]);
+/// let outcomes = [true, false, true].into_iter().collect();
+/// assert_eq!(
+///     storage::sum_up_all(&storage, &outcomes),
+///     vec![(0, Pauli::new_y()), (1, Pauli::new_y())]
+/// );
+/// # }
+/// ```
+pub fn sum_up_all<S: StackStorage>(
+    storage: &S,
+    outcomes: &S::BoolVec,
+) -> Vec<(usize, Pauli)> {
+    storage
+        .iter()
+        .map(|(bit, stack)| (bit, stack.sum_up_filter(outcomes)))
+        .collect()
+}
+
 mod vector;
 pub use vector::Vector;
 
 mod map;
 pub use map::Map;
 
+mod stream;
+pub use stream::StreamStorage;
+
 mod mapped_vector;
-#[allow(unused)] // we're using it in some tests
-pub(crate) use mapped_vector::MappedVector;
+pub use mapped_vector::MappedVector;
+
+mod slab;
+pub use slab::Slab;
+
+mod sharded;
+pub use sharded::Sharded;
+
+mod view;
+pub use view::{
+    ColumnWords,
+    FrameColumn,
+    SortedIndex,
+    SortedIter,
+};
 
 #[cfg(test)]
 mod tests {
-    // use coverage_helper::test;
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::{
+            fixed::FixedBits,
+            packed::PackedBitVec,
+            sparse::SparseBitVec,
+        },
+        tracker::frames::Frames,
+    };
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn send_sync<T: Send + Sync>() {}
+
+    #[test]
+    fn auto_traits() {
+        macro_rules! check {
+            ($($bool:ty),*) => {$(
+                send_sync::<Vector<$bool>>();
+                send_sync::<Map<$bool>>();
+                send_sync::<MappedVector<$bool>>();
+                send_sync::<Slab<$bool>>();
+                send_sync::<StreamStorage<$bool>>();
+                send_sync::<Sharded<$bool>>();
+                send_sync::<SortedIndex>();
+                send_sync::<Frames<Map<$bool>>>();
+            )*};
+        }
+        check!(Vec<bool>, PackedBitVec, SparseBitVec, FixedBits<2>);
+    }
 
     // // First we test the methods of [FullMap] that are not just simple redirections.
     // // Then we use [FullMap] to as reference to test the other storages
@@ -3,6 +3,7 @@ use std::{
         hash_map,
         HashMap,
     },
+    hash::BuildHasher,
     iter,
 };
 
@@ -10,24 +11,32 @@ use super::{
     super::StackStorage,
     PauliVec,
 };
-use crate::boolean_vector::BooleanVector;
+use crate::{
+    boolean_vector::BooleanVector,
+    collection::BuildIntHasher,
+};
 
 /// A HashMap of [PauliVec]s. Much more flexible than [Vector], but for restricted use
 /// cases [Vector] might be more efficient.
 ///
+/// The qubits are hashed with the `S` hasher, by default the fast
+/// [IntHasher](crate::collection::IntHasher). Note that [HashMap::new] is only
+/// available for the std hasher; use [Default] instead, e.g., `Map::<_>::default()` if
+/// the hasher cannot be inferred.
+///
 ///[Vector]: super::vector::Vector
-pub type Map<B> = HashMap<usize, PauliVec<B>>;
+pub type Map<B, S = BuildIntHasher> = HashMap<usize, PauliVec<B>, S>;
 
-impl<B: BooleanVector> StackStorage for Map<B> {
+impl<B: BooleanVector, S: BuildHasher + Default> StackStorage for Map<B, S> {
     type BoolVec = B;
     type IterMut<'l> = iter::Map<
         hash_map::IterMut<'l, usize, PauliVec<B>>,
         fn((&usize, &'l mut PauliVec<B>)) -> (usize, &'l mut PauliVec<B>),
-    > where B: 'l;
+    > where B: 'l, S: 'l;
     type Iter<'l> = iter::Map<
         hash_map::Iter<'l, usize, PauliVec<B>>,
         fn((&usize, &'l PauliVec<B>)) -> (usize, &'l PauliVec<B>),
-    > where B: 'l;
+    > where B: 'l, S: 'l;
 
     #[inline]
     fn insert_pauli(
@@ -87,7 +96,7 @@ impl<B: BooleanVector> StackStorage for Map<B> {
     }
 
     fn init(num_qubits: usize) -> Self {
-        let mut ret = HashMap::with_capacity(num_qubits);
+        let mut ret = HashMap::with_capacity_and_hasher(num_qubits, S::default());
         for i in 0..num_qubits {
             ret.insert(i, PauliVec::<B>::new());
         }
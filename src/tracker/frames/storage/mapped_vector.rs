@@ -1,5 +1,4 @@
 use std::{
-    collections::HashMap,
     iter::{
         Map,
         Zip,
@@ -25,9 +24,14 @@ use super::{
 };
 use crate::{
     boolean_vector::BooleanVector,
+    collection::IntMap,
     slice_extension::GetTwoMutSlice,
 };
 
+/// A storage of [PauliVec]s in a [Vec], with an [IntMap] from the qubits to the
+/// positions in the [Vec]. More memory-efficient than [Map](super::Map) for many
+/// qubits, while, in contrast to [Vector](super::Vector), qubits can be removed in any
+/// order.
 #[derive(Debug, Default)]
 // this is basically a HashMap<key=usize, value=PauliVec> splitted into
 // HashMap<key=usize, position_in_vec_=usize> and Vec<value=PauliVec>; we do this
@@ -41,7 +45,7 @@ pub struct MappedVector<B> {
     // for us since we might continuesly add frames and remove qubits (when it is
     // measured) to reduce the required memory
     frames: Vec<PauliVec<B>>,
-    position: HashMap<usize, usize>,
+    position: IntMap<usize, usize>,
     inverse_position: Vec<usize>,
 }
 
@@ -176,10 +180,13 @@ impl<B: BooleanVector> StackStorage for MappedVector<B> {
 }
 
 impl<B> MappedVector<B> {
+    /// The inner storage of the [PauliVec]s.
     pub fn frames(&self) -> &Vec<PauliVec<B>> {
         &self.frames
     }
 
+    /// The qubits of the [PauliVec]s in the [frames](Self::frames), i.e., the
+    /// [PauliVec] at position `i` belongs to qubit `inverse_position()[i]`.
     pub fn inverse_position(&self) -> &Vec<usize> {
         &self.inverse_position
     }
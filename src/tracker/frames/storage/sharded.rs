@@ -0,0 +1,198 @@
+use std::{
+    sync::{
+        Mutex,
+        MutexGuard,
+        PoisonError,
+    },
+    thread,
+};
+
+use super::{
+    super::StackStorage,
+    Map,
+    PauliVec,
+};
+use crate::boolean_vector::BooleanVector;
+
+/// A storage of [PauliVec]s that can be written into from multiple threads at once
+/// through a shared reference, e.g., to collect the measured stacks of several
+/// [Frames](super::super::Frames) trackers that run on worker threads, cf.
+/// [Frames::measure_and_store_shared](super::super::Frames::measure_and_store_shared).
+///
+/// The stacks are distributed over multiple [Map]s, the shards, according to their
+/// qubit, and each shard is guarded by its own [Mutex], so that threads that insert
+/// different qubits rarely wait on each other. Since the stacks cannot be borrowed out
+/// of the locks, the type does not implement [StackStorage]; convert it with
+/// [into_storage](Self::into_storage) after the tracking is done.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use std::thread;
+///
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::frames::storage::{
+///         Sharded,
+///         Vector,
+///     },
+/// };
+/// let sink = Sharded::<Vec<bool>>::new(4);
+/// thread::scope(|scope| {
+///     for bit in 0..3 {
+///         let sink = &sink;
+///         scope.spawn(move || sink.insert_pauli(bit, PauliVec::new()));
+///     }
+/// });
+/// assert_eq!(sink.len(), 3);
+/// let storage: Vector<Vec<bool>> = sink.into_storage();
+/// assert_eq!(storage.frames.len(), 3);
+/// # }
+/// ```
+#[derive(Debug)]
+pub struct Sharded<B> {
+    shards: Vec<Mutex<Map<B>>>,
+}
+
+impl<B> Default for Sharded<B> {
+    /// A storage with as many shards as there are threads available, cf.
+    /// [thread::available_parallelism].
+    fn default() -> Self {
+        Self::new(thread::available_parallelism().map_or(1, |num| num.get()))
+    }
+}
+
+// a panic while a shard is locked cannot leave it in an inconsistent state, since
+// the shards are only modified through single HashMap operations
+fn lock<B>(shard: &Mutex<Map<B>>) -> MutexGuard<'_, Map<B>> {
+    shard.lock().unwrap_or_else(PoisonError::into_inner)
+}
+
+impl<B> Sharded<B> {
+    /// Create a new, empty storage with `num_shards` shards (at least one).
+    pub fn new(num_shards: usize) -> Self {
+        Self {
+            shards: (0..num_shards.max(1)).map(|_| Mutex::default()).collect(),
+        }
+    }
+
+    /// The number of shards.
+    pub fn num_shards(&self) -> usize {
+        self.shards.len()
+    }
+
+    #[inline]
+    fn shard(&self, bit: usize) -> &Mutex<Map<B>> {
+        &self.shards[bit % self.shards.len()]
+    }
+
+    /// Insert a `pauli` stack for qu`bit`. If the qu`bit` is already present, its stack
+    /// is overwritten and the old stack is returned, cf.
+    /// [StackStorage::insert_pauli].
+    pub fn insert_pauli(&self, bit: usize, pauli: PauliVec<B>) -> Option<PauliVec<B>> {
+        lock(self.shard(bit)).insert(bit, pauli)
+    }
+
+    /// Remove a qu`bit` and return its stack if it is present.
+    pub fn remove_pauli(&self, bit: usize) -> Option<PauliVec<B>> {
+        lock(self.shard(bit)).remove(&bit)
+    }
+
+    /// Check whether the qu`bit` is present.
+    pub fn contains(&self, bit: usize) -> bool {
+        lock(self.shard(bit)).contains_key(&bit)
+    }
+
+    /// The number of stored qubits. Note that other threads might change it at any
+    /// time.
+    pub fn len(&self) -> usize {
+        self.shards.iter().map(|shard| lock(shard).len()).sum()
+    }
+
+    /// Check whether there are no stored qubits, cf. [len](Self::len).
+    pub fn is_empty(&self) -> bool {
+        self.shards.iter().all(|shard| lock(shard).is_empty())
+    }
+
+    /// Move all stacks into another `storage`.
+    pub fn into_storage<S: StackStorage<BoolVec = B>>(self) -> S
+    where
+        B: BooleanVector,
+    {
+        self.into_iter().collect()
+    }
+}
+
+impl<B> IntoIterator for Sharded<B> {
+    type Item = (usize, PauliVec<B>);
+    type IntoIter = std::iter::Flatten<std::vec::IntoIter<Map<B>>>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.shards
+            .into_iter()
+            .map(|shard| shard.into_inner().unwrap_or_else(PoisonError::into_inner))
+            .collect::<Vec<_>>()
+            .into_iter()
+            .flatten()
+    }
+}
+
+impl<B> FromIterator<(usize, PauliVec<B>)> for Sharded<B> {
+    fn from_iter<T: IntoIterator<Item = (usize, PauliVec<B>)>>(iter: T) -> Self {
+        let ret = Self::default();
+        for (bit, pauli) in iter {
+            ret.insert_pauli(bit, pauli);
+        }
+        ret
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        pauli::Pauli,
+        tracker::frames::storage,
+    };
+
+    #[test]
+    fn concurrent_inserts() {
+        type B = Vec<bool>;
+        let stack = |bit: usize| {
+            let mut ret = PauliVec::<B>::new();
+            ret.push(Pauli::try_from((bit % 4) as u8).unwrap());
+            ret
+        };
+        let sink = Sharded::<B>::new(3);
+        assert!(sink.is_empty());
+        thread::scope(|scope| {
+            for thread in 0..4 {
+                let sink = &sink;
+                scope.spawn(move || {
+                    for bit in (thread..100).step_by(4) {
+                        assert_eq!(sink.insert_pauli(bit, stack(bit)), None);
+                    }
+                });
+            }
+        });
+        assert_eq!(sink.len(), 100);
+        assert!(sink.contains(42));
+        assert_eq!(sink.insert_pauli(42, stack(0)), Some(stack(42)));
+        assert_eq!(sink.remove_pauli(42), Some(stack(0)));
+        assert_eq!(sink.remove_pauli(42), None);
+        sink.insert_pauli(42, stack(42));
+
+        let expected = (0..100).map(|bit| (bit, stack(bit))).collect::<Vec<_>>();
+        let map: Map<B> = sink.into_storage();
+        assert_eq!(storage::into_sorted_by_bit(map.clone()), expected);
+        let sink = map.into_iter().collect::<Sharded<B>>();
+        assert_eq!(Sharded::<B>::new(0).num_shards(), 1);
+        assert_eq!(
+            storage::into_sorted_by_bit(sink.into_storage::<Map<B>>()),
+            expected
+        );
+    }
+}
@@ -0,0 +1,341 @@
+use std::{
+    iter::{
+        FilterMap,
+        Zip,
+    },
+    mem,
+    slice,
+    vec,
+};
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use super::{
+    super::StackStorage,
+    PauliVec,
+};
+use crate::{
+    boolean_vector::BooleanVector,
+    slice_extension::GetTwoMutSlice,
+};
+
+const FREE: usize = usize::MAX;
+
+/// A storage of [PauliVec]s in one contiguous [Vec] of slots, with a free-list of the
+/// slots of removed qubits, and a dense lookup table from the qubits to the slots.
+///
+/// In contrast to [MappedVector](super::MappedVector), the lookup is a plain index
+/// operation instead of hashing, and removing a qubit doesn't move any other stack;
+/// the slot is reused for the next inserted qubit. This fits well for many short-lived
+/// qubits, e.g., in a measurement based computation, where new qubits are continuously
+/// added and measured. The lookup table has the size of the largest qubit number, so
+/// the qubit numbers should be reasonably dense.
+///
+/// Note that the slab only manages the slots and the lookup: each slot owns the
+/// [PauliVec] that has been inserted, with the heap allocations of its two
+/// [BooleanVector]s. A removed stack is moved out to the caller, e.g., when
+/// [Frames](super::super::Frames) measures a qubit, and the next inserted stack brings
+/// its own allocations, i.e., the buffers of the stacks are not reused.
+///
+/// Iterating over the storage goes through the slots in order, i.e., it is
+/// deterministic, but not sorted by the qubits; [iter_sorted](Slab::iter_sorted)
+/// iterates in qubit order via the lookup table, without allocating.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::frames::storage::{
+///         Slab,
+///         StackStorage,
+///     },
+/// };
+/// let mut storage = Slab::<Vec<bool>>::init(3);
+/// let stack = PauliVec::try_from_str("1", "0").unwrap();
+/// assert_eq!(storage.remove_pauli(1), Some(PauliVec::new()));
+/// // qubit 5 gets the slot of qubit 1
+/// assert_eq!(storage.insert_pauli(5, stack.clone()), None);
+/// assert_eq!(storage.slot(5), Some(1));
+/// assert_eq!(storage.get(5), Some(&stack));
+/// assert_eq!(storage.len(), 3);
+/// # }
+/// ```
+#[derive(Clone, Debug, Default)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct Slab<B> {
+    stacks: Vec<PauliVec<B>>,
+    // the qubit of each slot, or FREE
+    bits: Vec<usize>,
+    // the slot of each qubit, or FREE
+    slots: Vec<usize>,
+    free: Vec<usize>,
+}
+
+type Live<T> = fn((&usize, T)) -> Option<(usize, T)>;
+type LiveOwned<T> = fn((usize, T)) -> Option<(usize, T)>;
+
+fn live<T>((bit, stack): (&usize, T)) -> Option<(usize, T)> {
+    (*bit != FREE).then_some((*bit, stack))
+}
+
+fn live_owned<T>((bit, stack): (usize, T)) -> Option<(usize, T)> {
+    (bit != FREE).then_some((bit, stack))
+}
+
+impl<B> IntoIterator for Slab<B> {
+    type Item = (usize, PauliVec<B>);
+    type IntoIter = FilterMap<
+        Zip<vec::IntoIter<usize>, vec::IntoIter<PauliVec<B>>>,
+        LiveOwned<PauliVec<B>>,
+    >;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.bits
+            .into_iter()
+            .zip(self.stacks)
+            .filter_map(live_owned as LiveOwned<PauliVec<B>>)
+    }
+}
+
+impl<'l, B> IntoIterator for &'l Slab<B> {
+    type Item = (usize, &'l PauliVec<B>);
+    type IntoIter = FilterMap<
+        Zip<slice::Iter<'l, usize>, slice::Iter<'l, PauliVec<B>>>,
+        Live<&'l PauliVec<B>>,
+    >;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.bits
+            .iter()
+            .zip(self.stacks.iter())
+            .filter_map(live as Live<&'l PauliVec<B>>)
+    }
+}
+
+impl<'l, B> IntoIterator for &'l mut Slab<B> {
+    type Item = (usize, &'l mut PauliVec<B>);
+    type IntoIter = FilterMap<
+        Zip<slice::Iter<'l, usize>, slice::IterMut<'l, PauliVec<B>>>,
+        Live<&'l mut PauliVec<B>>,
+    >;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.bits
+            .iter()
+            .zip(self.stacks.iter_mut())
+            .filter_map(live as Live<&'l mut PauliVec<B>>)
+    }
+}
+
+impl<B: BooleanVector> FromIterator<(usize, PauliVec<B>)> for Slab<B> {
+    fn from_iter<T: IntoIterator<Item = (usize, PauliVec<B>)>>(iter: T) -> Self {
+        let mut res = Slab::init(0);
+        for (bit, pauli) in iter {
+            res.insert_pauli(bit, pauli);
+        }
+        res
+    }
+}
+
+impl<B: BooleanVector> StackStorage for Slab<B> {
+    type BoolVec = B;
+    type IterMut<'l> = <&'l mut Self as IntoIterator>::IntoIter where B: 'l;
+    type Iter<'l> = <&'l Self as IntoIterator>::IntoIter where B: 'l;
+
+    fn insert_pauli(&mut self, bit: usize, pauli: PauliVec<B>) -> Option<PauliVec<B>> {
+        assert!(bit != FREE, "the qubit {FREE} is reserved");
+        if let Some(slot) = self.slot(bit) {
+            return Some(mem::replace(&mut self.stacks[slot], pauli));
+        }
+        if bit >= self.slots.len() {
+            self.slots.resize(bit + 1, FREE);
+        }
+        let slot = match self.free.pop() {
+            Some(slot) => {
+                self.stacks[slot] = pauli;
+                self.bits[slot] = bit;
+                slot
+            }
+            None => {
+                self.stacks.push(pauli);
+                self.bits.push(bit);
+                self.stacks.len() - 1
+            }
+        };
+        self.slots[bit] = slot;
+        None
+    }
+
+    fn remove_pauli(&mut self, bit: usize) -> Option<PauliVec<B>> {
+        let slot = self.slot(bit)?;
+        self.slots[bit] = FREE;
+        self.bits[slot] = FREE;
+        self.free.push(slot);
+        Some(mem::replace(&mut self.stacks[slot], PauliVec::new()))
+    }
+
+    #[inline]
+    fn get(&self, bit: usize) -> Option<&PauliVec<B>> {
+        Some(&self.stacks[self.slot(bit)?])
+    }
+
+    #[inline]
+    fn get_mut(&mut self, bit: usize) -> Option<&mut PauliVec<B>> {
+        let slot = self.slot(bit)?;
+        Some(&mut self.stacks[slot])
+    }
+
+    fn get_two_mut(
+        &mut self,
+        bit_a: usize,
+        bit_b: usize,
+    ) -> Option<(&mut PauliVec<B>, &mut PauliVec<B>)> {
+        let (slot_a, slot_b) = (self.slot(bit_a)?, self.slot(bit_b)?);
+        self.stacks.get_two_mut(slot_a, slot_b)
+    }
+
+    #[inline]
+    fn iter(&self) -> Self::Iter<'_> {
+        self.into_iter()
+    }
+
+    #[inline]
+    fn iter_mut(&mut self) -> Self::IterMut<'_> {
+        self.into_iter()
+    }
+
+    fn init(num_bits: usize) -> Self {
+        Self {
+            stacks: vec![PauliVec::new(); num_bits],
+            bits: (0..num_bits).collect(),
+            slots: (0..num_bits).collect(),
+            free: Vec::new(),
+        }
+    }
+
+    #[inline]
+    fn is_empty(&self) -> bool {
+        Slab::is_empty(self)
+    }
+}
+
+impl<B> Slab<B> {
+    /// The number of stored qubits.
+    pub fn len(&self) -> usize {
+        self.stacks.len() - self.free.len()
+    }
+
+    /// Check whether there are no stored qubits.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// The number of slots, i.e., the number of stored qubits plus the number of free
+    /// slots.
+    pub fn num_slots(&self) -> usize {
+        self.stacks.len()
+    }
+
+    /// The slot of the qu`bit`, if it is present.
+    #[inline]
+    pub fn slot(&self, bit: usize) -> Option<usize> {
+        match self.slots.get(bit) {
+            Some(&slot) if slot != FREE => Some(slot),
+            _ => None,
+        }
+    }
+
+    /// Get an [Iterator] over the tuples of qubits and references of the corresponding
+    /// Pauli stacks, sorted by the qubits.
+    pub fn iter_sorted(&self) -> impl Iterator<Item = (usize, &PauliVec<B>)> {
+        self.slots
+            .iter()
+            .enumerate()
+            .filter(|(_, slot)| **slot != FREE)
+            .map(|(bit, slot)| (bit, &self.stacks[*slot]))
+    }
+
+    /// Remove the free slots at the end and release the unused memory of the slots and
+    /// the lookup table.
+    pub fn shrink_to_fit(&mut self) {
+        while self.bits.last() == Some(&FREE) {
+            self.bits.pop();
+            self.stacks.pop();
+        }
+        let num_slots = self.stacks.len();
+        self.free.retain(|slot| *slot < num_slots);
+        while self.slots.last() == Some(&FREE) {
+            self.slots.pop();
+        }
+        self.stacks.shrink_to_fit();
+        self.bits.shrink_to_fit();
+        self.slots.shrink_to_fit();
+        self.free.shrink_to_fit();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        pauli::Pauli,
+        tracker::frames::storage::{
+            self,
+            Map,
+        },
+    };
+
+    #[test]
+    fn compare_with_map() {
+        type B = Vec<bool>;
+        let stack = |seed: usize| {
+            let mut ret = PauliVec::<B>::new();
+            ret.push(Pauli::try_from((seed % 4) as u8).unwrap());
+            ret
+        };
+        let mut slab = Slab::<B>::init(4);
+        let mut map = Map::<B>::init(4);
+        for (i, bit) in [1, 7, 3, 1, 9, 0, 7, 7, 2, 5, 12].into_iter().enumerate() {
+            if i % 3 == 0 {
+                assert_eq!(slab.remove_pauli(bit), map.remove_pauli(bit));
+            } else {
+                assert_eq!(
+                    slab.insert_pauli(bit, stack(i)),
+                    map.insert_pauli(bit, stack(i))
+                );
+            }
+            assert_eq!(slab.len(), map.len());
+            assert_eq!(storage::sort_by_bit(&slab), storage::sort_by_bit(&map), "{i}");
+            assert_eq!(
+                slab.iter_sorted().collect::<Vec<_>>(),
+                storage::sort_by_bit(&map)
+            );
+        }
+        // the removed slots are reused
+        assert_eq!(slab.num_slots(), 6);
+
+        let (a, b) = slab.get_two_mut(2, 12).unwrap();
+        a.push(Pauli::new_x());
+        b.push(Pauli::new_z());
+        let (a, b) = StackStorage::get_two_mut(&mut map, 2, 12).unwrap();
+        a.push(Pauli::new_x());
+        b.push(Pauli::new_z());
+        assert!(slab.get_two_mut(2, 1).is_none());
+        assert_eq!(slab.get(13), None);
+
+        assert_eq!(slab.remove_pauli(12), map.remove_pauli(12));
+        let expected = storage::into_sorted_by_bit(map);
+        slab.shrink_to_fit();
+        assert_eq!(slab.slot(12), None);
+        assert_eq!(slab.clone().into_iter().count(), slab.len());
+        assert_eq!(storage::into_sorted_by_bit(slab), expected);
+    }
+}
@@ -0,0 +1,751 @@
+use std::{
+    collections::hash_map,
+    env,
+    fs::{
+        self,
+        File,
+        OpenOptions,
+    },
+    io::{
+        self,
+        BufReader,
+        Read,
+        Seek,
+        SeekFrom,
+        Write,
+    },
+    mem,
+    path::{
+        Path,
+        PathBuf,
+    },
+    process,
+    sync::{
+        atomic::{
+            AtomicUsize,
+            Ordering,
+        },
+        Mutex,
+        PoisonError,
+    },
+};
+
+use super::{
+    super::StackStorage,
+    Map,
+    PauliVec,
+};
+use crate::{
+    boolean_vector::BooleanVector,
+    collection::IntMap,
+};
+
+const MAGIC: &[u8; 8] = b"PTSTACKS";
+const VERSION: u32 = 1;
+// magic, version, 4 reserved bytes
+const HEADER_LEN: u64 = 16;
+
+const STACK: u8 = 0;
+const TOMBSTONE: u8 = 1;
+// kind, bit
+const RECORD_HEAD_LEN: u64 = 9;
+
+/// A file-backed storage that streams the stacks to disk, e.g., to collect the measured
+/// stacks via [Frames::measure_and_stream](super::super::Frames::measure_and_stream)
+/// without keeping them in memory.
+///
+/// The file is an append-only log of records: after a 16 byte header (the magic bytes
+/// `PTSTACKS`, a little endian u32 version and 4 reserved bytes), each record is
+/// either a stack, i.e., the kind byte 0, the qubit, the lengths of the left and right
+/// boolean vectors (each a little endian u64) and then the bits of the two vectors
+/// packed into little endian u64 words (least significant bit first), or a tombstone,
+/// i.e., the kind byte 1 and the qubit, which marks the qubit as removed. The latest
+/// record of a qubit wins; [StreamStorage::compact] rewrites the file with only the
+/// latest records. The storage keeps an in-memory index of the file offsets and reads
+/// the stacks lazily back.
+///
+/// Inserting a stack via [StreamStorage::insert_pauli] directly writes it to the file.
+/// Accessing a stack mutably via [StreamStorage::get_mut] loads the stack into memory;
+/// [StreamStorage::flush] writes the loaded stacks back to the file and frees the
+/// memory (this also happens when the storage is dropped). Since the stacks cannot be
+/// borrowed from the file, the type does not implement [StackStorage]; read the stacks
+/// with [StreamStorage::load], [StreamStorage::iter] and [StreamStorage::load_all], or
+/// with the owning [IntoIterator] implementation.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::{
+///         frames::{
+///             storage::{
+///                 self,
+///                 Map,
+///                 StreamStorage,
+///             },
+///             Frames,
+///         },
+///         Tracker,
+///     },
+/// };
+/// let mut frames = Frames::<Map<Vec<bool>>>::init(2);
+/// frames.track_x(0);
+/// frames.cx(0, 1);
+/// let mut measured = StreamStorage::<Vec<bool>>::temporary().unwrap();
+/// frames.measure_and_stream(0, &mut measured).unwrap();
+/// frames.measure_and_stream_all(&mut measured).unwrap();
+/// assert_eq!(
+///     measured.load(0).unwrap(),
+///     Some(PauliVec::try_from_str("1", "0").unwrap())
+/// );
+/// let loaded: Map<Vec<bool>> = measured.load_all().unwrap();
+/// assert_eq!(
+///     storage::into_sorted_by_bit(loaded),
+///     vec![
+///         (0, PauliVec::try_from_str("1", "0").unwrap()),
+///         (1, PauliVec::try_from_str("1", "0").unwrap()),
+///     ]
+/// );
+/// # }
+/// ```
+#[derive(Debug)]
+pub struct StreamStorage<B: BooleanVector> {
+    // reading moves the file cursor, so the shared references (e.g., in load) have to
+    // lock it; the mutable references use Mutex::get_mut
+    file: Mutex<File>,
+    path: PathBuf,
+    temporary: bool,
+    end: u64,
+    // qubit -> offset of its latest record; the qubits in `resident` are not in here
+    index: IntMap<usize, u64>,
+    resident: Map<B>,
+}
+
+impl<B: BooleanVector> Drop for StreamStorage<B> {
+    fn drop(&mut self) {
+        // nothing we can do about it if any of this fails
+        if self.temporary {
+            let _ = fs::remove_file(&self.path);
+            return;
+        }
+        for (bit, stack) in mem::take(&mut self.resident) {
+            let Ok(record) = stack_record(bit, &stack) else { return };
+            if self.append(&record).is_err() {
+                return;
+            }
+        }
+        let _ = self.file_mut().flush();
+    }
+}
+
+#[cfg_attr(coverage_nightly, no_coverage)]
+fn panic_io(error: io::Error) -> ! {
+    panic!("StreamStorage: I/O error: {error}")
+}
+
+fn invalid_data(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.to_string())
+}
+
+fn read_u64(reader: &mut impl Read) -> io::Result<u64> {
+    let mut bytes = [0; 8];
+    reader.read_exact(&mut bytes)?;
+    Ok(u64::from_le_bytes(bytes))
+}
+
+fn read_head(reader: &mut impl Read) -> io::Result<(u8, usize)> {
+    let mut kind = [0];
+    reader.read_exact(&mut kind)?;
+    Ok((kind[0], read_u64(reader)? as usize))
+}
+
+// the number of bytes of the words of a stack record with a `left` and a `right`
+// vector; None if it overflows, which can only happen for corrupt files
+fn words_len(left: u64, right: u64) -> Option<u64> {
+    let num_words = |len: u64| len / 64 + u64::from(len % 64 != 0);
+    num_words(left).checked_add(num_words(right))?.checked_mul(8)
+}
+
+fn push_words<B: BooleanVector>(buf: &mut Vec<u8>, vec: &B) {
+    for word in vec.to_words().iter() {
+        buf.extend_from_slice(&word.to_le_bytes());
+    }
+}
+
+fn stack_record<B: BooleanVector>(
+    bit: usize,
+    stack: &PauliVec<B>,
+) -> io::Result<Vec<u8>> {
+    let (left, right) = (stack.left.len(), stack.right.len());
+    let words = words_len(left as u64, right as u64)
+        .ok_or_else(|| invalid_data("stack too large"))?;
+    let mut record = Vec::with_capacity(RECORD_HEAD_LEN as usize + 16 + words as usize);
+    record.push(STACK);
+    record.extend_from_slice(&(bit as u64).to_le_bytes());
+    record.extend_from_slice(&(left as u64).to_le_bytes());
+    record.extend_from_slice(&(right as u64).to_le_bytes());
+    push_words(&mut record, &stack.left);
+    push_words(&mut record, &stack.right);
+    Ok(record)
+}
+
+fn read_words<B: BooleanVector>(reader: &mut impl Read, len: usize) -> io::Result<B> {
+    let mut ret = B::new();
+    let mut remaining = len;
+    while remaining > 0 {
+        let num = remaining.min(64);
+        ret.extend_from_word(read_u64(reader)?, num);
+        remaining -= num;
+    }
+    Ok(ret)
+}
+
+impl<B: BooleanVector> StreamStorage<B> {
+    /// Create a new empty storage at `path`, truncating the file if it already exists.
+    pub fn create(path: impl AsRef<Path>) -> io::Result<Self> {
+        let path = path.as_ref().to_path_buf();
+        let mut file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(true)
+            .open(&path)?;
+        let mut header = Vec::with_capacity(HEADER_LEN as usize);
+        header.extend_from_slice(MAGIC);
+        header.extend_from_slice(&VERSION.to_le_bytes());
+        header.extend_from_slice(&[0; 4]);
+        file.write_all(&header)?;
+        Ok(Self {
+            file: Mutex::new(file),
+            path,
+            temporary: false,
+            end: HEADER_LEN,
+            index: IntMap::default(),
+            resident: Map::default(),
+        })
+    }
+
+    /// Create a new empty storage in a file in [env::temp_dir], which is deleted when
+    /// the storage is dropped.
+    pub fn temporary() -> io::Result<Self> {
+        static COUNTER: AtomicUsize = AtomicUsize::new(0);
+        let path = env::temp_dir().join(format!(
+            "pauli_tracker-{}-{}.stacks",
+            process::id(),
+            COUNTER.fetch_add(1, Ordering::Relaxed)
+        ));
+        let mut ret = Self::create(path)?;
+        ret.temporary = true;
+        Ok(ret)
+    }
+
+    /// Open an existing storage at `path`, e.g., one that has been created with
+    /// [StreamStorage::create] in a previous run. Errors with
+    /// [InvalidData](io::ErrorKind::InvalidData) if the file is not a valid storage.
+    pub fn open(path: impl AsRef<Path>) -> io::Result<Self> {
+        let path = path.as_ref().to_path_buf();
+        let file = OpenOptions::new().read(true).write(true).open(&path)?;
+        let end = file.metadata()?.len();
+        let mut reader = BufReader::new(&file);
+
+        let mut header = [0; HEADER_LEN as usize];
+        reader
+            .read_exact(&mut header)
+            .map_err(|_| invalid_data("missing header"))?;
+        if &header[..8] != MAGIC {
+            return Err(invalid_data("not a StreamStorage file"));
+        }
+        let version = u32::from_le_bytes(header[8..12].try_into().unwrap());
+        if version != VERSION {
+            return Err(invalid_data(&format!("unsupported version {version}")));
+        }
+
+        let mut index = IntMap::default();
+        let mut offset = HEADER_LEN;
+        let truncated = |error: io::Error| match error.kind() {
+            io::ErrorKind::UnexpectedEof => invalid_data("truncated record"),
+            _ => error,
+        };
+        while offset < end {
+            let (kind, bit) = read_head(&mut reader).map_err(truncated)?;
+            match kind {
+                STACK => {
+                    let left = read_u64(&mut reader).map_err(truncated)?;
+                    let right = read_u64(&mut reader).map_err(truncated)?;
+                    let record_end = words_len(left, right)
+                        .and_then(|words| words.checked_add(RECORD_HEAD_LEN + 16))
+                        .and_then(|len| len.checked_add(offset))
+                        .filter(|record_end| *record_end <= end)
+                        .ok_or_else(|| invalid_data("truncated record"))?;
+                    reader.seek_relative(
+                        (record_end - offset - RECORD_HEAD_LEN - 16) as i64,
+                    )?;
+                    index.insert(bit, offset);
+                    offset = record_end;
+                }
+                TOMBSTONE => {
+                    index.remove(&bit);
+                    offset += RECORD_HEAD_LEN;
+                }
+                _ => return Err(invalid_data(&format!("invalid record kind {kind}"))),
+            }
+        }
+        if offset != end {
+            return Err(invalid_data("truncated record"));
+        }
+
+        drop(reader);
+        Ok(Self {
+            file: Mutex::new(file),
+            path,
+            temporary: false,
+            end,
+            index,
+            resident: Map::default(),
+        })
+    }
+
+    /// Get the path of the underlining file.
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    /// Get the number of stacks in the storage.
+    pub fn len(&self) -> usize {
+        self.index.len() + self.resident.len()
+    }
+
+    /// Check whether the storage is empty.
+    pub fn is_empty(&self) -> bool {
+        self.index.is_empty() && self.resident.is_empty()
+    }
+
+    /// Check whether qu`bit` is in the storage.
+    pub fn contains(&self, bit: usize) -> bool {
+        self.index.contains_key(&bit) || self.resident.contains_key(&bit)
+    }
+
+    /// Insert a `pauli` stack for qu`bit`, writing it directly to the file. If the
+    /// qu`bit` is already present, its old stack is returned.
+    ///
+    /// If this fails, the storage is unchanged.
+    pub fn insert_pauli(
+        &mut self,
+        bit: usize,
+        pauli: PauliVec<B>,
+    ) -> io::Result<Option<PauliVec<B>>> {
+        self.insert_ref(bit, &pauli)
+    }
+
+    // like insert_pauli, but the caller keeps the stack if writing fails; the fallible
+    // parts come first, so that the storage is unchanged if they fail
+    pub(crate) fn insert_ref(
+        &mut self,
+        bit: usize,
+        pauli: &PauliVec<B>,
+    ) -> io::Result<Option<PauliVec<B>>> {
+        let old = self.load_indexed(bit)?;
+        let offset = self.append(&stack_record(bit, pauli)?)?;
+        self.index.insert(bit, offset);
+        Ok(self.resident.remove(&bit).or(old))
+    }
+
+    /// Remove qu`bit` from the storage and return its stack, if it was present.
+    ///
+    /// If this fails, the storage is unchanged.
+    pub fn remove_pauli(&mut self, bit: usize) -> io::Result<Option<PauliVec<B>>> {
+        if !self.contains(bit) {
+            return Ok(None);
+        }
+        let old = self.load_indexed(bit)?;
+        self.append_tombstone(bit)?;
+        self.index.remove(&bit);
+        Ok(self.resident.remove(&bit).or(old))
+    }
+
+    /// Get a mutable reference to qu`bit`'s stack, if present, otherwise return [None].
+    /// The stack is loaded into memory until the next [StreamStorage::flush].
+    pub fn get_mut(&mut self, bit: usize) -> io::Result<Option<&mut PauliVec<B>>> {
+        if let Some(offset) = self.index.get(&bit) {
+            let stack = self.read_stack(*offset)?;
+            self.index.remove(&bit);
+            self.resident.insert(bit, stack);
+        }
+        Ok(self.resident.get_mut(&bit))
+    }
+
+    /// Load a copy of qu`bit`'s stack, if present, otherwise return [None].
+    pub fn load(&self, bit: usize) -> io::Result<Option<PauliVec<B>>> {
+        if let Some(stack) = self.resident.get(&bit) {
+            return Ok(Some(stack.clone()));
+        }
+        self.load_indexed(bit)
+    }
+
+    /// Iterate over copies of all stacks, reading them lazily from the file.
+    pub fn iter(&self) -> Iter<'_, B> {
+        Iter {
+            storage: self,
+            resident: self.resident.iter(),
+            index: self.index.iter(),
+        }
+    }
+
+    /// Load copies of all stacks into another storage, e.g., to analyse them.
+    pub fn load_all<S: StackStorage<BoolVec = B>>(&self) -> io::Result<S> {
+        self.iter().collect()
+    }
+
+    /// Write all stacks that are loaded into memory back to the file, and free the
+    /// memory.
+    pub fn flush(&mut self) -> io::Result<()> {
+        while let Some(bit) = self.resident.keys().next().copied() {
+            let offset = self.append(&stack_record(bit, &self.resident[&bit])?)?;
+            self.resident.remove(&bit);
+            self.index.insert(bit, offset);
+        }
+        self.file_mut().flush()
+    }
+
+    /// Rewrite the file with only the latest record of each stack, dropping overwritten
+    /// stacks and tombstones. This also [flushes](StreamStorage::flush) the storage.
+    ///
+    /// The stacks are written into a new file next to the current one, which then
+    /// replaces the current file.
+    pub fn compact(&mut self) -> io::Result<()> {
+        self.flush()?;
+        let mut path = self.path.clone().into_os_string();
+        path.push(".compact");
+        // temporary, so that it is deleted if something fails
+        let mut compacted = Self::create(PathBuf::from(path))?;
+        compacted.temporary = true;
+        for (bit, offset) in self.index.iter() {
+            compacted.insert_ref(*bit, &self.read_stack(*offset)?)?;
+        }
+        compacted.file_mut().flush()?;
+        fs::rename(&compacted.path, &self.path)?;
+        compacted.temporary = false;
+        mem::swap(&mut self.file, &mut compacted.file);
+        mem::swap(&mut self.index, &mut compacted.index);
+        self.end = compacted.end;
+        Ok(())
+    }
+
+    fn file_mut(&mut self) -> &mut File {
+        // the file cursor is always set before it's used, so a panic while it was locked
+        // doesn't leave anything broken behind
+        self.file.get_mut().unwrap_or_else(PoisonError::into_inner)
+    }
+
+    // if this fails, a partially written record is truncated, since the records are
+    // read until the end of the file when it is opened
+    fn append(&mut self, record: &[u8]) -> io::Result<u64> {
+        let offset = self.end;
+        let file = self.file_mut();
+        if let Err(error) = file
+            .seek(SeekFrom::Start(offset))
+            .and_then(|_| file.write_all(record))
+        {
+            let _ = file.set_len(offset);
+            return Err(error);
+        }
+        self.end += record.len() as u64;
+        Ok(offset)
+    }
+
+    fn append_tombstone(&mut self, bit: usize) -> io::Result<u64> {
+        let mut record = [TOMBSTONE; RECORD_HEAD_LEN as usize];
+        record[1..].copy_from_slice(&(bit as u64).to_le_bytes());
+        self.append(&record)
+    }
+
+    fn read_stack(&self, offset: u64) -> io::Result<PauliVec<B>> {
+        let mut file = self.file.lock().unwrap_or_else(PoisonError::into_inner);
+        file.seek(SeekFrom::Start(offset))?;
+        let mut reader = BufReader::new(&mut *file);
+        let (kind, _) = read_head(&mut reader)?;
+        if kind != STACK {
+            return Err(invalid_data("index points to a non-stack record"));
+        }
+        let left = read_u64(&mut reader)? as usize;
+        let right = read_u64(&mut reader)? as usize;
+        Ok(PauliVec {
+            left: read_words(&mut reader, left)?,
+            right: read_words(&mut reader, right)?,
+        })
+    }
+
+    // load qu`bit`'s stack if it's not resident
+    fn load_indexed(&self, bit: usize) -> io::Result<Option<PauliVec<B>>> {
+        self.index
+            .get(&bit)
+            .map(|offset| self.read_stack(*offset))
+            .transpose()
+    }
+}
+
+/// An iterator over copies of the stacks of a [StreamStorage], reading them lazily
+/// from the file, cf. [StreamStorage::iter].
+#[derive(Debug)]
+pub struct Iter<'l, B: BooleanVector> {
+    storage: &'l StreamStorage<B>,
+    resident: hash_map::Iter<'l, usize, PauliVec<B>>,
+    index: hash_map::Iter<'l, usize, u64>,
+}
+
+impl<B: BooleanVector> Iterator for Iter<'_, B> {
+    type Item = io::Result<(usize, PauliVec<B>)>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if let Some((bit, stack)) = self.resident.next() {
+            return Some(Ok((*bit, stack.clone())));
+        }
+        let (bit, offset) = self.index.next()?;
+        Some(self.storage.read_stack(*offset).map(|stack| (*bit, stack)))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let len = self.resident.len() + self.index.len();
+        (len, Some(len))
+    }
+}
+
+impl<B: BooleanVector> ExactSizeIterator for Iter<'_, B> {}
+
+/// An owning iterator over the stacks of a [StreamStorage], reading them lazily from
+/// the file.
+///
+/// It panics on I/O errors.
+#[derive(Debug)]
+pub struct IntoIter<B: BooleanVector> {
+    storage: StreamStorage<B>,
+    resident: hash_map::IntoIter<usize, PauliVec<B>>,
+    index: hash_map::IntoIter<usize, u64>,
+}
+
+impl<B: BooleanVector> Iterator for IntoIter<B> {
+    type Item = (usize, PauliVec<B>);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if let Some(item) = self.resident.next() {
+            return Some(item);
+        }
+        let (bit, offset) = self.index.next()?;
+        let stack = self.storage.read_stack(offset).unwrap_or_else(|e| panic_io(e));
+        Some((bit, stack))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let len = self.resident.len() + self.index.len();
+        (len, Some(len))
+    }
+}
+
+impl<B: BooleanVector> ExactSizeIterator for IntoIter<B> {}
+
+impl<B: BooleanVector> IntoIterator for StreamStorage<B> {
+    type Item = (usize, PauliVec<B>);
+    type IntoIter = IntoIter<B>;
+
+    fn into_iter(mut self) -> Self::IntoIter {
+        let resident = mem::take(&mut self.resident).into_iter();
+        let index = mem::take(&mut self.index).into_iter();
+        IntoIter { storage: self, resident, index }
+    }
+}
+
+impl<B: BooleanVector> FromIterator<(usize, PauliVec<B>)> for StreamStorage<B> {
+    /// Collect the stacks into a [StreamStorage::temporary] storage.
+    ///
+    /// # Panics
+    /// Panics on I/O errors.
+    fn from_iter<T: IntoIterator<Item = (usize, PauliVec<B>)>>(iter: T) -> Self {
+        let mut ret = Self::temporary().unwrap_or_else(|e| panic_io(e));
+        for (bit, stack) in iter {
+            ret.insert_pauli(bit, stack).unwrap_or_else(|e| panic_io(e));
+        }
+        ret
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::packed::PackedBitVec,
+        pauli::Pauli,
+        tracker::{
+            frames::{
+                storage,
+                Frames,
+            },
+            Tracker,
+        },
+    };
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn stack(seed: usize, len: usize) -> PauliVec<PackedBitVec> {
+        let mut ret = PauliVec::new();
+        for i in 0..len {
+            ret.push(Pauli::try_from(((i * 7 + seed) % 4) as u8).unwrap());
+        }
+        ret
+    }
+
+    #[test]
+    fn measure_and_stream() {
+        let mut frames = Frames::<Map<PackedBitVec>>::init(5);
+        for bit in 0..5 {
+            for _ in 0..(bit * 31) {
+                frames.track_y(bit);
+            }
+            frames.cx(bit, (bit + 1) % 5);
+        }
+        let mut measured = StreamStorage::temporary().unwrap();
+        let mut expected = Map::<_>::default();
+        frames.clone().measure_and_stream(3, &mut measured).unwrap();
+        frames.clone().measure_and_store(3, &mut expected).unwrap();
+        frames.clone().measure_and_stream_all(&mut measured).unwrap();
+        frames.measure_and_store_all(&mut expected);
+        assert_eq!(measured.len(), 5);
+        assert!(measured.contains(0));
+        let loaded: Map<_> = measured.load_all().unwrap();
+        assert_eq!(loaded, expected);
+        assert_eq!(measured.iter().collect::<io::Result<Map<_>>>().unwrap(), expected);
+        let path = measured.path().to_path_buf();
+        assert!(path.exists());
+        let mut owned = measured.into_iter().collect::<Vec<_>>();
+        owned.sort_by_key(|(bit, _)| *bit);
+        assert_eq!(owned, storage::into_sorted_by_bit(expected));
+        assert!(!path.exists());
+    }
+
+    #[test]
+    fn reopen() {
+        let mut path = env::temp_dir();
+        path.push(format!("pauli_tracker-test-reopen-{}.stacks", process::id()));
+        let mut storage = StreamStorage::<PackedBitVec>::create(&path).unwrap();
+        for bit in 0..4 {
+            assert_eq!(storage.insert_pauli(bit, stack(bit, 70 * bit)).unwrap(), None);
+        }
+        assert_eq!(storage.insert_pauli(1, stack(9, 3)).unwrap(), Some(stack(1, 70)));
+        assert_eq!(storage.remove_pauli(2).unwrap(), Some(stack(2, 140)));
+        assert_eq!(storage.remove_pauli(2).unwrap(), None);
+        storage.get_mut(3).unwrap().unwrap().push(Pauli::new_x());
+        storage.flush().unwrap();
+        // not flushed explicitly, but when dropping the storage
+        storage.get_mut(0).unwrap().unwrap().push(Pauli::new_z());
+        drop(storage);
+
+        let mut storage = StreamStorage::<PackedBitVec>::open(&path).unwrap();
+        let mut expected = stack(3, 210);
+        expected.push(Pauli::new_x());
+        let mut first = stack(0, 0);
+        first.push(Pauli::new_z());
+        assert_eq!(storage.len(), 3);
+        assert_eq!(storage.load(0).unwrap(), Some(first.clone()));
+        assert_eq!(storage.load(1).unwrap(), Some(stack(9, 3)));
+        assert_eq!(storage.load(2).unwrap(), None);
+        assert_eq!(storage.load(3).unwrap(), Some(expected.clone()));
+        assert!(storage.get_mut(2).unwrap().is_none());
+        storage.get_mut(1).unwrap().unwrap().pop();
+
+        let before = fs::metadata(&path).unwrap().len();
+        storage.compact().unwrap();
+        let after = fs::metadata(&path).unwrap().len();
+        assert!(after < before);
+        assert_eq!(storage.len(), 3);
+        assert_eq!(storage.load(1).unwrap(), Some(stack(9, 2)));
+        drop(storage);
+        let storage = StreamStorage::<PackedBitVec>::open(&path).unwrap();
+        assert_eq!(fs::metadata(&path).unwrap().len(), after);
+        assert_eq!(
+            storage::into_sorted_by_bit(storage.load_all::<Map<_>>().unwrap()),
+            vec![(0, first), (1, stack(9, 2)), (3, expected)]
+        );
+        drop(storage);
+        fs::remove_file(&path).unwrap();
+    }
+
+    #[test]
+    fn concurrent_loads() {
+        let storage = (0..8)
+            .map(|bit| (bit, stack(bit, 100 + 50 * bit)))
+            .collect::<StreamStorage<_>>();
+        std::thread::scope(|scope| {
+            for thread in 0..4 {
+                let storage = &storage;
+                scope.spawn(move || {
+                    for round in 0..50 {
+                        let bit = (thread + round) % 8;
+                        assert_eq!(
+                            storage.load(bit).unwrap(),
+                            Some(stack(bit, 100 + 50 * bit))
+                        );
+                    }
+                    assert_eq!(storage.iter().count(), 8);
+                });
+            }
+        });
+    }
+
+    #[test]
+    fn failed_updates() {
+        let mut storage = StreamStorage::<PackedBitVec>::temporary().unwrap();
+        storage.insert_pauli(0, stack(0, 70)).unwrap();
+        storage.insert_pauli(1, stack(1, 70)).unwrap();
+        // corrupt the last record, so that reading the old stack fails
+        let len = fs::metadata(storage.path()).unwrap().len() - 8;
+        OpenOptions::new()
+            .write(true)
+            .open(storage.path())
+            .unwrap()
+            .set_len(len)
+            .unwrap();
+        assert!(storage.insert_pauli(1, stack(2, 3)).is_err());
+        assert!(storage.remove_pauli(1).is_err());
+        // neither the index nor the file changed
+        assert_eq!(storage.len(), 2);
+        assert!(storage.contains(1));
+        assert_eq!(fs::metadata(storage.path()).unwrap().len(), len);
+        assert_eq!(storage.remove_pauli(0).unwrap(), Some(stack(0, 70)));
+        assert_eq!(storage.len(), 1);
+    }
+
+    #[test]
+    fn invalid_file() {
+        let mut path = env::temp_dir();
+        path.push(format!("pauli_tracker-test-invalid-{}.stacks", process::id()));
+        fs::write(&path, b"not a storage").unwrap();
+        assert_eq!(
+            StreamStorage::<Vec<bool>>::open(&path).unwrap_err().kind(),
+            io::ErrorKind::InvalidData
+        );
+        let mut storage = StreamStorage::<Vec<bool>>::create(&path).unwrap();
+        storage
+            .insert_pauli(0, PauliVec::try_from_str("101", "1").unwrap())
+            .unwrap();
+        drop(storage);
+        let mut bytes = fs::read(&path).unwrap();
+        assert!(StreamStorage::<Vec<bool>>::open(&path).is_ok());
+        let invalid = |bytes: &[u8]| {
+            fs::write(&path, bytes).unwrap();
+            assert_eq!(
+                StreamStorage::<Vec<bool>>::open(&path).unwrap_err().kind(),
+                io::ErrorKind::InvalidData
+            );
+        };
+        // corrupt lengths that would overflow the size of the words
+        let mut huge = bytes.clone();
+        huge[HEADER_LEN as usize + 9..HEADER_LEN as usize + 17]
+            .copy_from_slice(&u64::MAX.to_le_bytes());
+        invalid(&huge);
+        bytes.pop();
+        invalid(&bytes);
+        fs::remove_file(&path).unwrap();
+    }
+}
@@ -27,6 +27,9 @@ use crate::{
 /// A newtype vector of [PauliVec]s. Restricted, since we don't have the flexibility of
 /// a hashmap, but if that is no problem, and the type is used correctly, it is more
 /// efficient than [Map](super::map::Map).
+///
+/// Iterating over the storage is always sorted by the qubits, so there's no need for
+/// [sort_by_bit](super::sort_by_bit).
 #[derive(Clone, PartialEq, Eq, PartialOrd, Ord, Default, Debug)]
 #[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
 pub struct Vector<B> {
@@ -0,0 +1,372 @@
+use std::slice;
+
+use super::StackStorage;
+use crate::{
+    boolean_vector::BooleanVector,
+    pauli::{
+        Pauli,
+        PauliVec,
+    },
+};
+
+/// A borrowed view of a single frame across all stacks of a storage, i.e., a column of
+/// the storage, without copying or popping anything.
+///
+/// It iterates over the tuples of the qubits and their Pauli in the `frame`, in the
+/// iteration order of the underlying stacks. Qubits whose stack is shorter than `frame`
+/// are yielded with the identity.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::{
+///         Pauli,
+///         PauliVec,
+///     },
+///     tracker::frames::storage::{
+///         FrameColumn,
+///         StackStorage,
+///         Vector,
+///     },
+/// };
+/// let storage = Vector::<Vec<bool>>::from_iter([
+///     (0, PauliVec::try_from_str("01", "11").unwrap()),
+///     (1, PauliVec::try_from_str("10", "00").unwrap()),
+/// ]);
+/// let column = FrameColumn::new(storage.iter(), 1).collect::<Vec<_>>();
+/// assert_eq!(column, vec![(0, Pauli::new_y()), (1, Pauli::new_i())]);
+/// # }
+/// ```
+#[derive(Clone, Debug)]
+pub struct FrameColumn<I> {
+    stacks: I,
+    frame: usize,
+}
+
+impl<I> FrameColumn<I> {
+    /// Create a view of the `frame` across the `stacks`, which is usually
+    /// [StackStorage::iter] or [SortedIndex::iter].
+    pub fn new(stacks: I, frame: usize) -> Self {
+        Self { stacks, frame }
+    }
+
+    /// The frame that is viewed.
+    pub fn frame(&self) -> usize {
+        self.frame
+    }
+
+    /// Pack the column into words, cf. [ColumnWords].
+    pub fn words<'l, B>(self) -> ColumnWords<I>
+    where
+        B: BooleanVector + 'l,
+        I: Iterator<Item = (usize, &'l PauliVec<B>)>,
+    {
+        ColumnWords::new(self.stacks, self.frame)
+    }
+}
+
+impl<'l, B, I> Iterator for FrameColumn<I>
+where
+    B: BooleanVector + 'l,
+    I: Iterator<Item = (usize, &'l PauliVec<B>)>,
+{
+    type Item = (usize, Pauli);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let (bit, stack) = self.stacks.next()?;
+        Some((
+            bit,
+            Pauli::new(
+                stack.left.get_val(self.frame).unwrap_or(false),
+                stack.right.get_val(self.frame).unwrap_or(false),
+            ),
+        ))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        self.stacks.size_hint()
+    }
+}
+
+/// An iterator that packs a frame across the stacks, i.e., a column as in
+/// [FrameColumn], into words.
+///
+/// Each item is a tuple of the X and the Z components of up to 64 consecutive stacks in
+/// the iteration order: the `k`-th bit of the words corresponds to the `k`-th stack
+/// of the chunk. For storages that iterate in qubit order without gaps, e.g.,
+/// [Vector](super::Vector), the `i`-th word covers the qubits `64 * i` to
+/// `64 * i + 63`. The bits are read from the words of the stacks' vectors, cf.
+/// [BooleanVector::get_word], and stacks that are shorter than the frame contribute
+/// the identity.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::frames::storage::{
+///         FrameColumn,
+///         StackStorage,
+///         Vector,
+///     },
+/// };
+/// let storage = Vector::<Vec<bool>>::from_iter((0..70).map(|bit| {
+///     let z = if bit % 2 == 0 { "0" } else { "1" };
+///     (bit, PauliVec::try_from_str("0", z).unwrap())
+/// }));
+/// let words = FrameColumn::new(storage.iter(), 0).words().collect::<Vec<_>>();
+/// assert_eq!(words, vec![(0, 0xaaaa_aaaa_aaaa_aaaa), (0, 0b10_1010)]);
+/// # }
+/// ```
+#[derive(Clone, Debug)]
+pub struct ColumnWords<I> {
+    stacks: I,
+    // the word of the frame in the stacks' vectors, and the frame's bit in it
+    word: usize,
+    shift: usize,
+}
+
+impl<I> ColumnWords<I> {
+    /// Pack the `frame` across the `stacks`, which are usually [StackStorage::iter] or
+    /// [SortedIndex::iter], into words.
+    pub fn new(stacks: I, frame: usize) -> Self {
+        Self {
+            stacks,
+            word: frame / 64,
+            shift: frame % 64,
+        }
+    }
+}
+
+impl<'l, B, I> Iterator for ColumnWords<I>
+where
+    B: BooleanVector + 'l,
+    I: Iterator<Item = (usize, &'l PauliVec<B>)>,
+{
+    type Item = (u64, u64);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let bit = |vec: &B| (vec.get_word(self.word).unwrap_or(0) >> self.shift) & 1;
+        let (_, first) = self.stacks.next()?;
+        let (mut x, mut z) = (bit(&first.left), bit(&first.right));
+        for (k, (_, stack)) in (1..64).zip(self.stacks.by_ref()) {
+            x |= bit(&stack.left) << k;
+            z |= bit(&stack.right) << k;
+        }
+        Some((x, z))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let (lower, upper) = self.stacks.size_hint();
+        ((lower + 63) / 64, upper.map(|upper| (upper + 63) / 64))
+    }
+}
+
+/// A cached, sorted index of the qubits of a storage, to iterate over storages that
+/// are not ordered, e.g., [Map](super::Map) or [MappedVector](super::MappedVector), in
+/// qubit order without collecting and sorting them again each time, as
+/// [sort_by_bit](super::sort_by_bit) does.
+///
+/// The index is not tied to the storage, since [Map](super::Map) is only an alias for a
+/// [HashMap](std::collections::HashMap) and cannot hold it: **the caller has to keep
+/// it in sync** by calling [insert](Self::insert) for every qubit that is added to the
+/// storage; qubits that are removed from the storage, but not from the index via
+/// [remove](Self::remove), are skipped when iterating. Since the qubits are kept in a
+/// sorted [Vec], inserting and removing a qubit is *O*(n), i.e., the index pays off if
+/// the storage is iterated in order more often than its qubits change.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::frames::storage::{
+///         Map,
+///         SortedIndex,
+///         StackStorage,
+///     },
+/// };
+/// let mut storage = Map::<Vec<bool>>::init(3);
+/// let mut index = SortedIndex::new(&storage);
+/// storage.remove_pauli(1);
+/// storage.insert_pauli(7, PauliVec::new());
+/// index.insert(7);
+/// let bits = index.iter(&storage).map(|(bit, _)| bit).collect::<Vec<_>>();
+/// assert_eq!(bits, vec![0, 2, 7]);
+/// # }
+/// ```
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct SortedIndex {
+    bits: Vec<usize>,
+}
+
+impl SortedIndex {
+    /// Create the index for the qubits in the `storage`.
+    pub fn new<S: StackStorage>(storage: &S) -> Self {
+        let mut bits = storage.iter().map(|(bit, _)| bit).collect::<Vec<_>>();
+        bits.sort_unstable();
+        Self { bits }
+    }
+
+    /// Insert the qu`bit` into the index. Returns false if it was already present.
+    pub fn insert(&mut self, bit: usize) -> bool {
+        match self.bits.binary_search(&bit) {
+            Ok(_) => false,
+            Err(position) => {
+                self.bits.insert(position, bit);
+                true
+            }
+        }
+    }
+
+    /// Remove the qu`bit` from the index. Returns false if it was not present.
+    pub fn remove(&mut self, bit: usize) -> bool {
+        match self.bits.binary_search(&bit) {
+            Ok(position) => {
+                self.bits.remove(position);
+                true
+            }
+            Err(_) => false,
+        }
+    }
+
+    /// The sorted qubits.
+    pub fn bits(&self) -> &[usize] {
+        &self.bits
+    }
+
+    /// Iterate over the qubits of the index that are present in the `storage`, together
+    /// with references to their stacks, in qubit order.
+    pub fn iter<'l, S: StackStorage>(&'l self, storage: &'l S) -> SortedIter<'l, S> {
+        SortedIter { bits: self.bits.iter(), storage }
+    }
+}
+
+/// An [Iterator] over a storage in qubit order, cf. [SortedIndex::iter].
+#[derive(Clone, Debug)]
+pub struct SortedIter<'l, S> {
+    bits: slice::Iter<'l, usize>,
+    storage: &'l S,
+}
+
+impl<'l, S: StackStorage> Iterator for SortedIter<'l, S> {
+    type Item = (usize, &'l PauliVec<S::BoolVec>);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.bits
+            .by_ref()
+            .find_map(|&bit| Some((bit, self.storage.get(bit)?)))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (0, self.bits.size_hint().1)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::tracker::frames::storage::{
+        self,
+        Map,
+        MappedVector,
+    };
+
+    type B = Vec<bool>;
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn stack(seed: usize, len: usize) -> PauliVec<B> {
+        let mut ret = PauliVec::new();
+        for i in 0..len {
+            ret.push(Pauli::try_from(((seed * 7 + i * 3) % 4) as u8).unwrap());
+        }
+        ret
+    }
+
+    #[test]
+    fn column() {
+        let mut map = Map::<B>::from_iter((0..100).map(|bit| (bit, stack(bit, 5))));
+        let index = SortedIndex::new(&map);
+        let sorted = index.iter(&map).collect::<Vec<_>>();
+        assert_eq!(sorted, storage::sort_by_bit(&map));
+
+        let column = FrameColumn::new(index.iter(&map), 4);
+        assert_eq!(column.frame(), 4);
+        let words = column.clone().words().collect::<Vec<_>>();
+        assert_eq!(words.len(), 2);
+        let column = column.collect::<Vec<_>>();
+        for (k, &(bit, pauli)) in column.iter().enumerate() {
+            let (x, z) = words[k / 64];
+            assert_eq!(((x >> (k % 64)) & 1 == 1, (z >> (k % 64)) & 1 == 1), {
+                (pauli.get_x(), pauli.get_z())
+            });
+            assert_eq!(bit, k);
+        }
+
+        // the last frame is the one that is popped
+        let mut popped = Vec::new();
+        for (bit, stack) in map.iter_mut() {
+            popped.push((*bit, stack.pop().unwrap()));
+        }
+        popped.sort_by_key(|(bit, _)| *bit);
+        assert_eq!(column, popped);
+        // shorter stacks are filled with identities
+        assert!(
+            FrameColumn::new(index.iter(&map), 4).all(|(_, p)| p == Pauli::new_i())
+        );
+
+        // a frame beyond the first word, with some stacks that are too short
+        let long = Map::<B>::from_iter((0..70).map(|bit| (bit, stack(bit, 60 + bit))));
+        let index = SortedIndex::new(&long);
+        let column = FrameColumn::new(index.iter(&long), 100).collect::<Vec<_>>();
+        let words = FrameColumn::new(index.iter(&long), 100)
+            .words()
+            .collect::<Vec<_>>();
+        assert_eq!(words.len(), 2);
+        for (k, (_, pauli)) in column.into_iter().enumerate() {
+            let (x, z) = words[k / 64];
+            assert_eq!((x >> (k % 64)) & 1 == 1, pauli.get_x());
+            assert_eq!((z >> (k % 64)) & 1 == 1, pauli.get_z());
+            if k <= 40 {
+                assert_eq!(pauli, Pauli::new_i());
+            }
+        }
+        assert_ne!(words[1], (0, 0));
+    }
+
+    #[test]
+    fn index() {
+        let mut storage = MappedVector::<B>::init(0);
+        let mut index = SortedIndex::default();
+        for (i, bit) in [5, 3, 9, 3, 0, 12, 5, 7].into_iter().enumerate() {
+            if storage.insert_pauli(bit, stack(i, 1)).is_none() {
+                assert!(index.insert(bit));
+            } else {
+                assert!(!index.insert(bit));
+            }
+            if i % 3 == 2 {
+                storage.remove_pauli(bit);
+                assert!(index.remove(bit));
+                assert!(!index.remove(bit));
+            }
+            assert_eq!(
+                index.iter(&storage).collect::<Vec<_>>(),
+                storage::sort_by_bit(&storage)
+            );
+        }
+        assert_eq!(index.bits(), [0, 3, 5, 7]);
+        assert_eq!(index, SortedIndex::new(&storage));
+        // removed qubits are skipped
+        storage.remove_pauli(3);
+        assert_eq!(
+            index.iter(&storage).map(|(bit, _)| bit).collect::<Vec<_>>(),
+            [0, 5, 7]
+        );
+    }
+}
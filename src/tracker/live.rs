@@ -8,6 +8,7 @@ use std::{
     self,
     cmp::Ordering,
     iter,
+    mem,
 };
 
 #[cfg(feature = "serde")]
@@ -17,6 +18,7 @@ use serde::{
 };
 
 use super::{
+    sequence::GateSequence,
     unwrap_get_mut,
     unwrap_get_two_mut,
     MissingStack,
@@ -28,7 +30,13 @@ use crate::{
     slice_extension::GetTwoMutSlice,
 };
 
-// todo: make it generic and also do it with a hashmap
+mod pauli_vec;
+pub use pauli_vec::LivePauliVec;
+
+mod shots;
+pub use shots::LiveShots;
+
+// todo: also do it with a hashmap
 
 /// An implementor of [Tracker], similar to [Frames](super::frames::Frames), with the
 /// difference, that instead of storing each Pauli frame, it adds the Pauli frames (mod
@@ -69,16 +77,52 @@ impl LiveVector {
     pub fn get_mut(&mut self, bit: usize) -> Option<&mut Pauli> {
         self.inner.get_mut(bit)
     }
+
+    /// Apply the gates of the `sequence`. This is equivalent to applying the gates one
+    /// after another, cf. [sequence](super::sequence).
+    ///
+    /// # Panics
+    /// Panics if a qubit of the `sequence` does not exist. In that case, no gate is
+    /// applied.
+    pub fn apply_sequence(&mut self, sequence: &GateSequence) {
+        let mut paulis: Vec<Pauli> = sequence
+            .qubits()
+            .iter()
+            .map(|bit| *unwrap_get_mut!(self.inner, *bit, "apply_sequence"))
+            .collect();
+        sequence.run(&mut paulis);
+        for (bit, pauli) in sequence.qubits().iter().zip(paulis) {
+            self.inner[*bit] = pauli;
+        }
+    }
 }
 
+// the gate and the equivalent (up to Paulis) gate of Pauli
 macro_rules! single {
-    ($($name:ident),*) => {$(
+    ($(($name:ident, $gate:ident)),*) => {$(
         fn $name(&mut self, bit: usize) {
-            unwrap_get_mut!(self.inner, bit, stringify!($name)).$name()
+            unwrap_get_mut!(self.inner, bit, stringify!($name)).$gate()
         }
     )*};
 }
 
+// the fused two-qubit gates on single Paulis, shared with LivePauliVec and the
+// sequences
+
+pub(crate) fn cy(c: &mut Pauli, t: &mut Pauli) {
+    c.xor_u8((t.xmask() >> 1) ^ t.zmask());
+    t.xor_u8(c.xmask() | (c.xmask() >> 1));
+}
+
+pub(crate) fn iswap(a: &mut Pauli, b: &mut Pauli) {
+    // = SWAP, then S on both and CZ
+    mem::swap(a, b);
+    a.s();
+    b.s();
+    a.xor_u8(b.xmask() >> 1);
+    b.xor_u8(a.xmask() >> 1);
+}
+
 /// Note that the inner storage type is basically a vector. Therefore, the it may
 /// contain buffer qubits, even though they were not explicitly initialized.
 impl Tracker for LiveVector {
@@ -122,7 +166,7 @@ impl Tracker for LiveVector {
         }
     }
 
-    single!(h, s);
+    single!((h, h), (s, s), (sdg, s), (sx, sx), (sxdg, sx), (sy, h), (sydg, h));
 
     fn cx(&mut self, control: usize, target: usize) {
         let (c, t) = unwrap_get_two_mut!(self.inner, control, target, "cx");
@@ -135,6 +179,19 @@ impl Tracker for LiveVector {
         b.xor_u8(a.xmask() >> 1);
     }
 
+    fn swap(&mut self, bit_a: usize, bit_b: usize) {
+        let (a, b) = unwrap_get_two_mut!(self.inner, bit_a, bit_b, "swap");
+        mem::swap(a, b);
+    }
+    fn cy(&mut self, control: usize, target: usize) {
+        let (c, t) = unwrap_get_two_mut!(self.inner, control, target, "cy");
+        cy(c, t);
+    }
+    fn iswap(&mut self, bit_a: usize, bit_b: usize) {
+        let (a, b) = unwrap_get_two_mut!(self.inner, bit_a, bit_b, "iswap");
+        iswap(a, b);
+    }
+
     fn move_x_to_x(&mut self, source: usize, destination: usize) {
         let (s, d) =
             unwrap_get_two_mut!(self.inner, source, destination, "move_x_to_x");
@@ -190,7 +247,15 @@ mod tests {
         fn single() {
             type Action = SingleAction<LiveVector>;
 
-            const ACTIONS: [Action; N_SINGLES] = [LiveVector::h, LiveVector::s];
+            const ACTIONS: [Action; N_SINGLES] = [
+                LiveVector::h,
+                LiveVector::s,
+                LiveVector::sdg,
+                LiveVector::sx,
+                LiveVector::sxdg,
+                LiveVector::sy,
+                LiveVector::sydg,
+            ];
 
             #[cfg_attr(coverage_nightly, no_coverage)]
             fn runner(action: Action, result: SingleResults) {
@@ -222,6 +287,10 @@ mod tests {
                 LiveVector::move_x_to_z,
                 LiveVector::move_z_to_x,
                 LiveVector::move_z_to_z,
+                LiveVector::swap,
+                LiveVector::cy,
+                LiveVector::iswap,
+                LiveVector::iswapdg,
             ];
 
             #[cfg_attr(coverage_nightly, no_coverage)]
@@ -239,6 +308,116 @@ mod tests {
 
             impl_utils::double_check(runner, ACTIONS);
         }
+
+        // only implements the required methods, to check the default implementations
+        struct Minimal(LiveVector);
+
+        impl Tracker for Minimal {
+            type Stack = Pauli;
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn init(num_bits: usize) -> Self {
+                Self(LiveVector::init(num_bits))
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn new_qubit(&mut self, bit: usize) -> Option<usize> {
+                self.0.new_qubit(bit)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn track_pauli(&mut self, bit: usize, pauli: Pauli) {
+                self.0.track_pauli(bit, pauli)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn track_pauli_string(&mut self, string: PauliString) {
+                self.0.track_pauli_string(string)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn h(&mut self, bit: usize) {
+                self.0.h(bit)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn s(&mut self, bit: usize) {
+                self.0.s(bit)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn cx(&mut self, control: usize, target: usize) {
+                self.0.cx(control, target)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn cz(&mut self, bit_a: usize, bit_b: usize) {
+                self.0.cz(bit_a, bit_b)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn move_x_to_x(&mut self, source: usize, destination: usize) {
+                self.0.move_x_to_x(source, destination)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn move_x_to_z(&mut self, source: usize, destination: usize) {
+                self.0.move_x_to_z(source, destination)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn move_z_to_x(&mut self, source: usize, destination: usize) {
+                self.0.move_z_to_x(source, destination)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn move_z_to_z(&mut self, source: usize, destination: usize) {
+                self.0.move_z_to_z(source, destination)
+            }
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn measure(&mut self, bit: usize) -> Result<Self::Stack, MissingStack> {
+                self.0.measure(bit)
+            }
+        }
+
+        #[test]
+        fn default_implementations() {
+            const SINGLES: [SingleAction<Minimal>; N_SINGLES] = [
+                Minimal::h,
+                Minimal::s,
+                Minimal::sdg,
+                Minimal::sx,
+                Minimal::sxdg,
+                Minimal::sy,
+                Minimal::sydg,
+            ];
+            const DOUBLES: [DoubleAction<Minimal>; N_DOUBLES] = [
+                Minimal::cx,
+                Minimal::cz,
+                Minimal::move_x_to_x,
+                Minimal::move_x_to_z,
+                Minimal::move_z_to_x,
+                Minimal::move_z_to_z,
+                Minimal::swap,
+                Minimal::cy,
+                Minimal::iswap,
+                Minimal::iswapdg,
+            ];
+
+            impl_utils::single_check(
+                |action: SingleAction<Minimal>, result: SingleResults| {
+                    for (input, check) in (0u8..).zip(result.1) {
+                        let mut tracker = Minimal::init(2);
+                        tracker.track_pauli_string(impl_utils::single_init(input));
+                        (action)(&mut tracker, 0);
+                        assert_eq!(tracker.0.inner[0].storage(), check, "{}", result.0);
+                    }
+                },
+                SINGLES,
+            );
+            impl_utils::double_check(
+                |action: DoubleAction<Minimal>, result: DoubleResults| {
+                    for (input, check) in (0u8..).zip(result.1) {
+                        let mut tracker = Minimal::init(2);
+                        tracker.track_pauli_string(impl_utils::double_init(input));
+                        (action)(&mut tracker, 0, 1);
+                        let output = impl_utils::double_output(
+                            tracker.0.inner.into_iter().enumerate(),
+                        );
+                        assert_eq!(output, check, "{}, {}", result.0, input);
+                    }
+                },
+                DOUBLES,
+            );
+        }
     }
 
     #[test]
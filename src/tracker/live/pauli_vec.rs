@@ -0,0 +1,482 @@
+use std::mem;
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use super::{
+    cy,
+    iswap,
+    LiveVector,
+};
+use crate::{
+    boolean_vector::BooleanVector,
+    pauli::{
+        Pauli,
+        PauliVec,
+    },
+    tracker::{
+        sequence::GateSequence,
+        MissingStack,
+        PauliString,
+        Tracker,
+    },
+};
+
+/// An implementor of [Tracker], like [LiveVector], but generic over the
+/// [BooleanVector] that stores the Paulis: the X and Z parts of all qubits are kept in
+/// two separate bit vectors (a [PauliVec] indexed by the qubits instead of the
+/// frames).
+///
+/// The single-qubit and two-qubit gates of the [Tracker] interface only touch single
+/// bits, so they are not faster than those of the [LiveVector]. However, operations on
+/// whole registers, like [track_pauli_vec](Self::track_pauli_vec),
+/// [h_masked](Self::h_masked) and [s_masked](Self::s_masked), work on all qubits at
+/// once, i.e., a word-packed [BooleanVector] processes 64 (or more) qubits per
+/// instruction.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     boolean_vector::packed::PackedBitVec,
+///     pauli::{
+///         Pauli,
+///         PauliVec,
+///     },
+///     tracker::{
+///         live::LivePauliVec,
+///         Tracker,
+///     },
+/// };
+/// let mut tracker = LivePauliVec::<PackedBitVec>::init(3);
+/// // track X on qubit 0 and 2, and Z on qubit 1
+/// tracker.track_pauli_vec(&PauliVec::try_from_str("101", "010").unwrap());
+/// // apply H on qubit 0 and 1
+/// tracker.h_masked(&[true, true, false].into_iter().collect());
+/// tracker.cz(1, 2);
+/// assert_eq!(tracker.measure(0), Ok(Pauli::new_z()));
+/// assert_eq!(tracker.measure(1), Ok(Pauli::new_y()));
+/// assert_eq!(tracker.measure(2), Ok(Pauli::new_y()));
+/// # }
+/// ```
+#[derive(Clone, PartialEq, Eq, Default, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct LivePauliVec<B> {
+    inner: PauliVec<B>,
+}
+
+impl<B> From<PauliVec<B>> for LivePauliVec<B> {
+    fn from(value: PauliVec<B>) -> Self {
+        Self { inner: value }
+    }
+}
+
+impl<B> From<LivePauliVec<B>> for PauliVec<B> {
+    fn from(value: LivePauliVec<B>) -> Self {
+        value.inner
+    }
+}
+
+impl<B> AsRef<PauliVec<B>> for LivePauliVec<B> {
+    fn as_ref(&self) -> &PauliVec<B> {
+        &self.inner
+    }
+}
+
+impl<B: BooleanVector> From<LiveVector> for LivePauliVec<B> {
+    fn from(value: LiveVector) -> Self {
+        Self {
+            inner: Vec::<Pauli>::from(value).into_iter().collect(),
+        }
+    }
+}
+
+impl<B: BooleanVector> From<LivePauliVec<B>> for LiveVector {
+    fn from(value: LivePauliVec<B>) -> Self {
+        let PauliVec { left, right } = value.inner;
+        left.into_iter()
+            .zip(right)
+            .map(|(x, z)| Pauli::new(x, z))
+            .collect::<Vec<_>>()
+            .into()
+    }
+}
+
+impl<B: BooleanVector> LivePauliVec<B> {
+    /// The number of qubits.
+    pub fn len(&self) -> usize {
+        self.inner.left.len()
+    }
+
+    /// Check whether there are no qubits.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Get the Pauli of the qu`bit`. Returns [None] if out of bounds.
+    #[inline]
+    pub fn get(&self, bit: usize) -> Option<Pauli> {
+        Some(Pauli::new(
+            self.inner.left.get_val(bit)?,
+            self.inner.right.get_val(bit)?,
+        ))
+    }
+
+    /// Set the Pauli of the qu`bit`.
+    ///
+    /// # Panics
+    /// Panics if the qu`bit` does not exist.
+    #[inline]
+    pub fn set(&mut self, bit: usize, pauli: Pauli) {
+        self.inner.left.set(bit, pauli.get_x());
+        self.inner.right.set(bit, pauli.get_z());
+    }
+
+    /// Track the Pauli string `paulis`, where the element `i` of the [PauliVec] is the
+    /// Pauli of the qubit `i`, on all qubits at once.
+    ///
+    /// # Panics
+    /// Panics if the lengths of `paulis` and the tracker are different.
+    pub fn track_pauli_vec(&mut self, paulis: &PauliVec<B>) {
+        self.inner.left.xor_inplace(&paulis.left);
+        self.inner.right.xor_inplace(&paulis.right);
+    }
+
+    /// Apply the Hadamard gate on all qubits whose element in `mask` is `true/1`.
+    ///
+    /// # Panics
+    /// Panics if the lengths of `mask` and the tracker are different.
+    pub fn h_masked(&mut self, mask: &B) {
+        // swap the X and Z parts where the mask is set
+        let mut swap = self.inner.left.clone();
+        swap.xor_inplace(&self.inner.right);
+        swap.and_inplace(mask);
+        self.inner.left.xor_inplace(&swap);
+        self.inner.right.xor_inplace(&swap);
+    }
+
+    /// Apply the Phase S gate on all qubits whose element in `mask` is `true/1`.
+    ///
+    /// # Panics
+    /// Panics if the lengths of `mask` and the tracker are different.
+    pub fn s_masked(&mut self, mask: &B) {
+        let mut x = self.inner.left.clone();
+        x.and_inplace(mask);
+        self.inner.right.xor_inplace(&x);
+    }
+
+    /// Apply the gates of the `sequence`. This is equivalent to applying the gates one
+    /// after another, cf. [sequence](crate::tracker::sequence).
+    ///
+    /// # Panics
+    /// Panics if a qubit of the `sequence` does not exist. In that case, no gate is
+    /// applied.
+    pub fn apply_sequence(&mut self, sequence: &GateSequence) {
+        let mut paulis: Vec<Pauli> = sequence
+            .qubits()
+            .iter()
+            .map(|bit| self.unwrap_get(*bit, "apply_sequence"))
+            .collect();
+        sequence.run(&mut paulis);
+        for (bit, pauli) in sequence.qubits().iter().zip(paulis) {
+            self.set(*bit, pauli);
+        }
+    }
+
+    #[inline]
+    fn unwrap_get(&self, bit: usize, gate: &str) -> Pauli {
+        self.get(bit)
+            .unwrap_or_else(|| panic!("{}: qubit {} does not exist", gate, bit))
+    }
+
+    #[inline]
+    fn check_two(&self, bit_a: usize, bit_b: usize, gate: &str) {
+        let len = self.len();
+        if bit_a == bit_b || bit_a >= len || bit_b >= len {
+            panic!("{}: qubit {} and/or {} do not exist", gate, bit_a, bit_b)
+        }
+    }
+
+    // apply the `gate` on the Paulis of the two qubits
+    #[inline]
+    fn apply_two(
+        &mut self,
+        bit_a: usize,
+        bit_b: usize,
+        name: &str,
+        gate: impl FnOnce(&mut Pauli, &mut Pauli),
+    ) {
+        self.check_two(bit_a, bit_b, name);
+        let mut a = self.get(bit_a).expect("checked above");
+        let mut b = self.get(bit_b).expect("checked above");
+        gate(&mut a, &mut b);
+        self.set(bit_a, a);
+        self.set(bit_b, b);
+    }
+
+    // x_[destination] ^= x_[source], where x is the left or right part
+    #[inline]
+    fn xor_bit(vec: &mut B, destination: usize, source: bool) {
+        if source {
+            let flag = vec.get_val(destination).expect("checked by the caller");
+            vec.set(destination, !flag);
+        }
+    }
+}
+
+// the gate and the equivalent (up to Paulis) gate of Pauli
+macro_rules! single {
+    ($(($name:ident, $gate:ident)),*) => {$(
+        fn $name(&mut self, bit: usize) {
+            let mut pauli = self.unwrap_get(bit, stringify!($name));
+            pauli.$gate();
+            self.set(bit, pauli);
+        }
+    )*};
+}
+
+macro_rules! movements {
+    ($((
+        $name:ident,
+        $from:ident,
+        $to:ident
+    )),*) => {$(
+        fn $name(&mut self, source: usize, destination: usize) {
+            self.check_two(source, destination, stringify!($name));
+            let flag = self.inner.$from.get_val(source).expect("checked above");
+            Self::xor_bit(&mut self.inner.$to, destination, flag);
+            self.inner.$from.set(source, false);
+        }
+    )*};
+}
+
+/// Note that the inner storage type is basically a vector. Therefore, it may contain
+/// buffer qubits, even though they were not explicitly initialized.
+impl<B: BooleanVector> Tracker for LivePauliVec<B> {
+    type Stack = Pauli;
+
+    fn init(num_bits: usize) -> Self {
+        Self { inner: PauliVec::zeros(num_bits) }
+    }
+
+    fn new_qubit(&mut self, bit: usize) -> Option<usize> {
+        let len = self.len();
+        if bit < len {
+            return Some(bit);
+        }
+        self.inner.extend_zeros(bit - len + 1);
+        None
+    }
+
+    fn track_pauli(&mut self, bit: usize, pauli: Pauli) {
+        if let Some(mut p) = self.get(bit) {
+            p.xor(pauli);
+            self.set(bit, p);
+        }
+    }
+
+    fn track_pauli_string(&mut self, string: PauliString) {
+        for (bit, pauli) in string {
+            self.track_pauli(bit, pauli);
+        }
+    }
+
+    single!((h, h), (s, s), (sdg, s), (sx, sx), (sxdg, sx), (sy, h), (sydg, h));
+
+    fn cx(&mut self, control: usize, target: usize) {
+        self.check_two(control, target, "cx");
+        let x = self.inner.left.get_val(control).expect("checked above");
+        let z = self.inner.right.get_val(target).expect("checked above");
+        Self::xor_bit(&mut self.inner.left, target, x);
+        Self::xor_bit(&mut self.inner.right, control, z);
+    }
+
+    fn cz(&mut self, bit_a: usize, bit_b: usize) {
+        self.check_two(bit_a, bit_b, "cz");
+        let x_a = self.inner.left.get_val(bit_a).expect("checked above");
+        let x_b = self.inner.left.get_val(bit_b).expect("checked above");
+        Self::xor_bit(&mut self.inner.right, bit_a, x_b);
+        Self::xor_bit(&mut self.inner.right, bit_b, x_a);
+    }
+
+    fn swap(&mut self, bit_a: usize, bit_b: usize) {
+        self.apply_two(bit_a, bit_b, "swap", mem::swap);
+    }
+
+    fn cy(&mut self, control: usize, target: usize) {
+        self.apply_two(control, target, "cy", cy);
+    }
+
+    fn iswap(&mut self, bit_a: usize, bit_b: usize) {
+        self.apply_two(bit_a, bit_b, "iswap", iswap);
+    }
+
+    movements!(
+        (move_x_to_x, left, left),
+        (move_x_to_z, left, right),
+        (move_z_to_x, right, left),
+        (move_z_to_z, right, right)
+    );
+
+    fn measure(&mut self, bit: usize) -> Result<Self::Stack, MissingStack> {
+        self.get(bit).ok_or(MissingStack { bit })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::mem;
+
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::packed::PackedBitVec,
+        tracker::sequence::Gate,
+    };
+
+    type ThisTracker = LivePauliVec<PackedBitVec>;
+
+    mod action_definition_check {
+        use super::{
+            test,
+            *,
+        };
+        use crate::tracker::test::impl_utils::{
+            self,
+            DoubleAction,
+            DoubleResults,
+            SingleAction,
+            SingleResults,
+            N_DOUBLES,
+            N_SINGLES,
+        };
+
+        #[test]
+        fn single() {
+            type Action = SingleAction<ThisTracker>;
+
+            const ACTIONS: [Action; N_SINGLES] = [
+                ThisTracker::h,
+                ThisTracker::s,
+                ThisTracker::sdg,
+                ThisTracker::sx,
+                ThisTracker::sxdg,
+                ThisTracker::sy,
+                ThisTracker::sydg,
+            ];
+
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn runner(action: Action, result: SingleResults) {
+                for (input, check) in (0u8..).zip(result.1) {
+                    let mut tracker = ThisTracker::init(2);
+                    tracker.track_pauli_string(impl_utils::single_init(input));
+                    (action)(&mut tracker, 0);
+                    assert_eq!(
+                        tracker.get(0).unwrap().storage(),
+                        check,
+                        "{}, {}",
+                        result.0,
+                        input
+                    );
+                }
+            }
+
+            impl_utils::single_check(runner, ACTIONS);
+        }
+
+        #[test]
+        fn double() {
+            type Action = DoubleAction<ThisTracker>;
+
+            const ACTIONS: [Action; N_DOUBLES] = [
+                ThisTracker::cx,
+                ThisTracker::cz,
+                ThisTracker::move_x_to_x,
+                ThisTracker::move_x_to_z,
+                ThisTracker::move_z_to_x,
+                ThisTracker::move_z_to_z,
+                ThisTracker::swap,
+                ThisTracker::cy,
+                ThisTracker::iswap,
+                ThisTracker::iswapdg,
+            ];
+
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn runner(action: Action, result: DoubleResults) {
+                for (input, check) in (0u8..).zip(result.1) {
+                    let mut tracker = ThisTracker::init(2);
+                    tracker.track_pauli_string(impl_utils::double_init(input));
+                    (action)(&mut tracker, 0, 1);
+                    let output = impl_utils::double_output(
+                        (0..2).map(|bit| (bit, tracker.get(bit).unwrap())),
+                    );
+                    assert_eq!(output, check, "{}, {}", result.0, input);
+                }
+            }
+
+            impl_utils::double_check(runner, ACTIONS);
+        }
+    }
+
+    #[test]
+    fn masked_gates() {
+        let num_bits = 130;
+        let paulis: PauliVec<PackedBitVec> = (0..num_bits)
+            .map(|i| Pauli::try_from((i % 4) as u8).unwrap())
+            .collect();
+        let mask: PackedBitVec = (0..num_bits).map(|i| i % 7 < 3).collect();
+        let mut masked = ThisTracker::init(num_bits);
+        masked.track_pauli_vec(&paulis);
+        let mut single = masked.clone();
+        masked.s_masked(&mask);
+        masked.h_masked(&mask);
+        for bit in (0..num_bits).filter(|i| i % 7 < 3) {
+            single.s(bit);
+            single.h(bit);
+        }
+        assert_eq!(masked, single);
+
+        let mut everything = masked.clone();
+        everything.h_masked(&PackedBitVec::zeros(num_bits));
+        assert_eq!(everything, masked);
+        let mut ones = PackedBitVec::zeros(num_bits);
+        for bit in 0..num_bits {
+            ones.set(bit, true);
+        }
+        everything.h_masked(&ones);
+        mem::swap(&mut masked.inner.left, &mut masked.inner.right);
+        assert_eq!(everything, masked);
+    }
+
+    #[test]
+    fn compare_with_live_vector() {
+        let mut live = LiveVector::init(4);
+        live.track_x(0);
+        live.track_y(2);
+        let mut packed = ThisTracker::from(live.clone());
+        let sequence = GateSequence::new([
+            Gate::H(0),
+            Gate::Cx(0, 1),
+            Gate::S(2),
+            Gate::Cz(2, 3),
+            Gate::MoveZToX(1, 3),
+            Gate::S(0),
+        ]);
+        live.apply_sequence(&sequence);
+        packed.apply_sequence(&sequence);
+        assert_eq!(LiveVector::from(packed.clone()), live);
+
+        assert_eq!(packed.new_qubit(1), Some(1));
+        assert_eq!(packed.new_qubit(5), None);
+        assert_eq!(packed.len(), 6);
+        assert_eq!(packed.measure(5), Ok(Pauli::new_i()));
+        assert_eq!(packed.measure(6), Err(MissingStack { bit: 6 }));
+        packed.track_z(6);
+        assert_eq!(packed.len(), 6);
+    }
+}
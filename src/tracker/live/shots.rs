@@ -0,0 +1,435 @@
+use std::mem;
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use crate::{
+    boolean_vector::BooleanVector,
+    pauli::{
+        Pauli,
+        PauliVec,
+    },
+    slice_extension::GetTwoMutSlice,
+    tracker::{
+        sequence::GateSequence,
+        MissingStack,
+        PauliString,
+        Tracker,
+    },
+};
+
+/// An implementor of [Tracker], similar to [LiveVector](super::LiveVector), but it
+/// tracks `num_shots` independent shots, e.g., of a Monte Carlo sampling, at once.
+///
+/// Each qubit holds a [PauliVec] where the element `i` is the Pauli of the shot `i`
+/// (the same layout as a stack in [Frames](crate::tracker::frames::Frames), but with
+/// shots instead of frames). So a gate updates all shots with one
+/// [xor_inplace](BooleanVector::xor_inplace), which is word-parallel for bit-vectors.
+/// The Paulis that depend on measurement outcomes are tracked with the masked methods,
+/// e.g., [track_z_masked](Self::track_z_masked), where the mask is the packed outcome
+/// of all shots, e.g., from a
+/// [BatchedRandomMeasurementCircuit](crate::circuit::BatchedRandomMeasurementCircuit).
+/// The methods [Tracker::track_pauli] and [Tracker::track_pauli_string] track the Paulis
+/// in all shots.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     boolean_vector::packed::PackedBitVec,
+///     pauli::PauliVec,
+///     tracker::{
+///         live::LiveShots,
+///         Tracker,
+///     },
+/// };
+/// let mut tracker = LiveShots::<PackedBitVec>::new(2, 3);
+/// // the outcomes of some measurement in the three shots
+/// let outcome = [true, false, true].into_iter().collect();
+/// tracker.track_z_masked(0, &outcome);
+/// tracker.track_x(1);
+/// tracker.cz(0, 1);
+/// assert_eq!(
+///     tracker.measure(0),
+///     Ok(PauliVec::try_from_str("000", "010").unwrap())
+/// );
+/// assert_eq!(
+///     tracker.measure(1),
+///     Ok(PauliVec::try_from_str("111", "000").unwrap())
+/// );
+/// # }
+/// ```
+#[derive(Clone, PartialEq, Eq, Default, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct LiveShots<B> {
+    inner: Vec<PauliVec<B>>,
+    num_shots: usize,
+    // all true, to track Paulis in all shots
+    ones: B,
+}
+
+macro_rules! masked {
+    ($(($name:ident, $track:ident, $x:literal, $z:literal, $doc:literal),)*) => {$(
+        /// Track a
+        #[doc = $doc]
+        /// on the qu`bit` in the shots where the `mask` is `true/1`, cf.
+        #[doc = concat!("[", stringify!($track), "](Tracker::", stringify!($track), ").")]
+        ///
+        /// # Panics
+        /// Panics if the length of `mask` is not the number of shots.
+        pub fn $name(&mut self, bit: usize, mask: &B) {
+            self.track_pauli_masked(bit, Pauli::new($x, $z), mask)
+        }
+    )*};
+}
+
+impl<B: BooleanVector> LiveShots<B> {
+    /// Create a tracker with `num_bits` qubits and `num_shots` shots.
+    pub fn new(num_bits: usize, num_shots: usize) -> Self {
+        Self {
+            inner: vec![PauliVec::zeros(num_shots); num_bits],
+            num_shots,
+            ones: (0..num_shots).map(|_| true).collect(),
+        }
+    }
+
+    /// The number of shots.
+    pub fn num_shots(&self) -> usize {
+        self.num_shots
+    }
+
+    /// Returns a reference to the Paulis of all shots of the qu`bit`. Returns [None] if
+    /// out of bounds.
+    pub fn get(&self, bit: usize) -> Option<&PauliVec<B>> {
+        self.inner.get(bit)
+    }
+
+    /// Returns a mutable reference to the Paulis of all shots of the qu`bit`. Returns
+    /// [None] if out of bounds.
+    pub fn get_mut(&mut self, bit: usize) -> Option<&mut PauliVec<B>> {
+        self.inner.get_mut(bit)
+    }
+
+    /// Track the `pauli` on the qu`bit` in the shots where the `mask` is `true/1`.
+    ///
+    /// # Panics
+    /// Panics if the length of `mask` is not the number of shots.
+    pub fn track_pauli_masked(&mut self, bit: usize, pauli: Pauli, mask: &B) {
+        if let Some(stack) = self.inner.get_mut(bit) {
+            track_masked(stack, pauli, mask);
+        }
+    }
+
+    masked!(
+        (track_x_masked, track_x, true, false, "X"),
+        (track_y_masked, track_y, true, true, "Y"),
+        (track_z_masked, track_z, false, true, "Z"),
+    );
+
+    /// Apply the gates of the `sequence`. This is equivalent to applying the gates one
+    /// after another, cf. [sequence](crate::tracker::sequence).
+    ///
+    /// # Panics
+    /// Panics if a qubit of the `sequence` does not exist. In that case, no gate is
+    /// applied.
+    pub fn apply_sequence(&mut self, sequence: &GateSequence) {
+        for bit in sequence.qubits() {
+            if self.inner.get(*bit).is_none() {
+                panic!("apply_sequence: qubit {bit} does not exist");
+            }
+        }
+        let mut stacks: Vec<PauliVec<B>> = sequence
+            .qubits()
+            .iter()
+            .map(|bit| mem::replace(&mut self.inner[*bit], PauliVec::new()))
+            .collect();
+        sequence.run(&mut stacks);
+        for (bit, mut stack) in sequence.qubits().iter().zip(stacks) {
+            // the moves in the sequence clear the source side completely
+            stack.left.resize(self.num_shots, false);
+            stack.right.resize(self.num_shots, false);
+            self.inner[*bit] = stack;
+        }
+    }
+}
+
+fn track_masked<B: BooleanVector>(stack: &mut PauliVec<B>, pauli: Pauli, mask: &B) {
+    if pauli.get_x() {
+        stack.left.xor_inplace(mask);
+    }
+    if pauli.get_z() {
+        stack.right.xor_inplace(mask);
+    }
+}
+
+// the gate and the equivalent (up to Paulis) gate of PauliVec
+macro_rules! single {
+    ($(($name:ident, $gate:ident)),*) => {$(
+        fn $name(&mut self, bit: usize) {
+            unwrap_get_mut!(self.inner, bit, stringify!($name)).$gate()
+        }
+    )*};
+}
+
+macro_rules! movements {
+    ($((
+        $name:ident,
+        $from_side:ident,
+        $to_side:ident
+    )),*) => {$(
+        fn $name(&mut self, source: usize, destination: usize) {
+            let (s, d) = unwrap_get_two_mut!(
+                self.inner,
+                source,
+                destination,
+                stringify!($name)
+            );
+            d.$to_side.xor_inplace(&s.$from_side);
+            s.$from_side = B::zeros(self.num_shots);
+        }
+    )*};
+}
+
+/// Note that the inner storage type is basically a vector. Therefore, it may contain
+/// buffer qubits, even though they were not explicitly initialized. The
+/// [init](Tracker::init) function creates a tracker with one shot; use
+/// [new](LiveShots::new) to specify the number of shots.
+impl<B: BooleanVector> Tracker for LiveShots<B> {
+    type Stack = PauliVec<B>;
+
+    fn init(num_bits: usize) -> Self {
+        Self::new(num_bits, 1)
+    }
+
+    fn new_qubit(&mut self, bit: usize) -> Option<usize> {
+        let len = self.inner.len();
+        if bit < len {
+            return Some(bit);
+        }
+        self.inner.resize(bit + 1, PauliVec::zeros(self.num_shots));
+        None
+    }
+
+    fn track_pauli(&mut self, bit: usize, pauli: Pauli) {
+        if let Some(stack) = self.inner.get_mut(bit) {
+            track_masked(stack, pauli, &self.ones);
+        }
+    }
+
+    fn track_pauli_string(&mut self, string: PauliString) {
+        for (bit, pauli) in string {
+            self.track_pauli(bit, pauli);
+        }
+    }
+
+    single!((h, h), (s, s), (sdg, s), (sx, sx), (sxdg, sx), (sy, h), (sydg, h));
+
+    fn cx(&mut self, control: usize, target: usize) {
+        let (c, t) = unwrap_get_two_mut!(self.inner, control, target, "cx");
+        t.left.xor_inplace(&c.left);
+        c.right.xor_inplace(&t.right);
+    }
+
+    fn cz(&mut self, bit_a: usize, bit_b: usize) {
+        let (a, b) = unwrap_get_two_mut!(self.inner, bit_a, bit_b, "cz");
+        a.right.xor_inplace(&b.left);
+        b.right.xor_inplace(&a.left);
+    }
+
+    fn swap(&mut self, bit_a: usize, bit_b: usize) {
+        let (a, b) = unwrap_get_two_mut!(self.inner, bit_a, bit_b, "swap");
+        mem::swap(a, b);
+    }
+
+    fn cy(&mut self, control: usize, target: usize) {
+        let (c, t) = unwrap_get_two_mut!(self.inner, control, target, "cy");
+        c.right.xor_inplace(&t.left);
+        c.right.xor_inplace(&t.right);
+        t.left.xor_inplace(&c.left);
+        t.right.xor_inplace(&c.left);
+    }
+
+    fn iswap(&mut self, bit_a: usize, bit_b: usize) {
+        let (a, b) = unwrap_get_two_mut!(self.inner, bit_a, bit_b, "iswap");
+        // = SWAP, then S on both and CZ
+        mem::swap(a, b);
+        a.right.xor_inplace(&a.left);
+        a.right.xor_inplace(&b.left);
+        b.right.xor_inplace(&b.left);
+        b.right.xor_inplace(&a.left);
+    }
+
+    movements!(
+        (move_x_to_x, left, left),
+        (move_x_to_z, left, right),
+        (move_z_to_x, right, left),
+        (move_z_to_z, right, right)
+    );
+
+    fn measure(&mut self, bit: usize) -> Result<Self::Stack, MissingStack> {
+        self.get(bit).ok_or(MissingStack { bit }).cloned()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::packed::PackedBitVec,
+        tracker::{
+            live::LiveVector,
+            sequence::Gate,
+        },
+    };
+
+    type ThisTracker = LiveShots<PackedBitVec>;
+
+    mod action_definition_check {
+        use super::{
+            test,
+            *,
+        };
+        use crate::tracker::test::impl_utils::{
+            self,
+            DoubleAction,
+            DoubleResults,
+            SingleAction,
+            SingleResults,
+            N_DOUBLES,
+            N_SINGLES,
+        };
+
+        const NUM_SHOTS: usize = 3;
+
+        #[test]
+        fn single() {
+            type Action = SingleAction<ThisTracker>;
+
+            const ACTIONS: [Action; N_SINGLES] = [
+                ThisTracker::h,
+                ThisTracker::s,
+                ThisTracker::sdg,
+                ThisTracker::sx,
+                ThisTracker::sxdg,
+                ThisTracker::sy,
+                ThisTracker::sydg,
+            ];
+
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn runner(action: Action, result: SingleResults) {
+                for (input, check) in (0u8..).zip(result.1) {
+                    let mut tracker = ThisTracker::new(2, NUM_SHOTS);
+                    tracker.track_pauli_string(impl_utils::single_init(input));
+                    (action)(&mut tracker, 0);
+                    assert_eq!(
+                        tracker.get(0).unwrap(),
+                        &PauliVec::from_iter(
+                            [Pauli::try_from(check).unwrap(); NUM_SHOTS]
+                        ),
+                        "{}, {}",
+                        result.0,
+                        input
+                    );
+                }
+            }
+
+            impl_utils::single_check(runner, ACTIONS);
+        }
+
+        #[test]
+        fn double() {
+            type Action = DoubleAction<ThisTracker>;
+
+            const ACTIONS: [Action; N_DOUBLES] = [
+                ThisTracker::cx,
+                ThisTracker::cz,
+                ThisTracker::move_x_to_x,
+                ThisTracker::move_x_to_z,
+                ThisTracker::move_z_to_x,
+                ThisTracker::move_z_to_z,
+                ThisTracker::swap,
+                ThisTracker::cy,
+                ThisTracker::iswap,
+                ThisTracker::iswapdg,
+            ];
+
+            #[cfg_attr(coverage_nightly, no_coverage)]
+            fn runner(action: Action, result: DoubleResults) {
+                for (input, check) in (0u8..).zip(result.1) {
+                    let mut tracker = ThisTracker::new(2, NUM_SHOTS);
+                    tracker.track_pauli_string(impl_utils::double_init(input));
+                    (action)(&mut tracker, 0, 1);
+                    for shot in 0..NUM_SHOTS {
+                        let output = impl_utils::double_output((0..2).map(|bit| {
+                            let stack = tracker.get(bit).unwrap();
+                            let x = stack.left.get_val(shot).unwrap();
+                            let z = stack.right.get_val(shot).unwrap();
+                            (bit, Pauli::new(x, z))
+                        }));
+                        assert_eq!(output, check, "{}, {}", result.0, input);
+                    }
+                }
+            }
+
+            impl_utils::double_check(runner, ACTIONS);
+        }
+    }
+
+    #[test]
+    fn compare_with_live_vector() {
+        let num_bits = 4;
+        let num_shots = 70;
+        let outcomes: Vec<PackedBitVec> = (0..2)
+            .map(|seed| (0..num_shots).map(|shot| (shot * 5 + seed) % 3 == 0).collect())
+            .collect();
+        let sequence = GateSequence::new([
+            Gate::H(0),
+            Gate::Cx(0, 1),
+            Gate::S(2),
+            Gate::Cz(2, 3),
+            Gate::MoveZToX(1, 3),
+        ]);
+
+        let mut shots = ThisTracker::new(num_bits, num_shots);
+        shots.track_x_masked(0, &outcomes[0]);
+        shots.track_y_masked(2, &outcomes[1]);
+        shots.track_z(1);
+        shots.apply_sequence(&sequence);
+        shots.cx(3, 0);
+        shots.move_x_to_z(2, 1);
+
+        for shot in 0..num_shots {
+            let mut live = LiveVector::init(num_bits);
+            if outcomes[0].get_val(shot).unwrap() {
+                live.track_x(0);
+            }
+            if outcomes[1].get_val(shot).unwrap() {
+                live.track_y(2);
+            }
+            live.track_z(1);
+            live.apply_sequence(&sequence);
+            live.cx(3, 0);
+            live.move_x_to_z(2, 1);
+            for bit in 0..num_bits {
+                let stack = shots.get(bit).unwrap();
+                let pauli = Pauli::new(
+                    stack.left.get_val(shot).unwrap(),
+                    stack.right.get_val(shot).unwrap(),
+                );
+                assert_eq!(live.get(bit), Some(&pauli), "{shot}, {bit}");
+            }
+        }
+
+        assert_eq!(shots.new_qubit(2), Some(2));
+        assert_eq!(shots.new_qubit(5), None);
+        assert_eq!(shots.measure(5), Ok(PauliVec::zeros(num_shots)));
+        assert_eq!(shots.measure(6), Err(MissingStack { bit: 6 }));
+        assert_eq!(ThisTracker::init(1).num_shots(), 1);
+    }
+}
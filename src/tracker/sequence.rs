@@ -0,0 +1,693 @@
+/*!
+Compiled gate sequences that can be applied in bulk to [Frames](super::frames::Frames)
+and [LiveVector](super::live::LiveVector).
+
+Every single gate method of [Tracker](super::Tracker) looks up the involved qubits in the
+tracker's storage and checks whether they exist; for hash map based storages this is a
+hash lookup per gate. A [GateSequence] is build from a list of [Gate]s once:
+- the qubits are renumbered into dense slots, so that, when the sequence is applied, each
+  qubit is only looked up once in the storage
+- back-to-back single-qubit gates on the same qubit are fused into one [LocalClifford],
+  which is applied with at most one pass over the Pauli stack (e.g., S·S is the identity
+  (up to Paulis) and costs nothing, and H·S·H costs one xor pass instead of one pass per
+  S)
+
+Single-qubit gates on other qubits commute with the two-qubit gates, so they are only
+applied when a two-qubit gate touches their qubit or at the end of the sequence.
+*/
+
+use std::mem;
+
+#[cfg(feature = "serde")]
+use serde::{
+    Deserialize,
+    Serialize,
+};
+
+use crate::{
+    boolean_vector::BooleanVector,
+    collection::IntMap,
+    pauli::{
+        Pauli,
+        PauliVec,
+    },
+    slice_extension::GetTwoMutSlice,
+    tracker::live,
+};
+
+/// A Clifford gate as it can be applied via the methods of [Tracker](super::Tracker).
+#[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Debug)]
+pub enum Gate {
+    /// Hadamard gate on the qubit.
+    H(usize),
+    /// S gate on the qubit.
+    S(usize),
+    /// Inverse of the S gate on the qubit.
+    Sdg(usize),
+    /// Square root of X gate on the qubit.
+    SX(usize),
+    /// Inverse of the square root of X gate on the qubit.
+    SXdg(usize),
+    /// Square root of Y gate on the qubit.
+    SY(usize),
+    /// Inverse of the square root of Y gate on the qubit.
+    SYdg(usize),
+    /// Control X (Control Not) gate on the (control, target) qubits.
+    Cx(usize, usize),
+    /// Control Z gate on the qubits.
+    Cz(usize, usize),
+    /// Control Y gate on the (control, target) qubits.
+    Cy(usize, usize),
+    /// SWAP gate on the qubits.
+    Swap(usize, usize),
+    /// iSWAP gate on the qubits.
+    ISwap(usize, usize),
+    /// Inverse of the iSWAP gate on the qubits.
+    ISwapdg(usize, usize),
+    /// [move_x_to_x](super::Tracker::move_x_to_x) from the (source, destination) qubits.
+    MoveXToX(usize, usize),
+    /// [move_x_to_z](super::Tracker::move_x_to_z) from the (source, destination) qubits.
+    MoveXToZ(usize, usize),
+    /// [move_z_to_x](super::Tracker::move_z_to_x) from the (source, destination) qubits.
+    MoveZToX(usize, usize),
+    /// [move_z_to_z](super::Tracker::move_z_to_z) from the (source, destination) qubits.
+    MoveZToZ(usize, usize),
+}
+
+/// A single-qubit Clifford gate, modulo Paulis and phases, i.e., one of the six
+/// elements of the group generated by H and S.
+///
+/// It is described by the conjugation images of X and Z; a product of X and Z is mapped
+/// to the product of the images.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::Pauli,
+///     tracker::sequence::LocalClifford,
+/// };
+/// let s = LocalClifford::s();
+/// assert_eq!(s.conjugate(Pauli::new_x()), Pauli::new_y());
+/// assert!(s.then(s).is_identity());
+/// # }
+/// ```
+#[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Debug)]
+#[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
+pub struct LocalClifford {
+    x: Pauli,
+    z: Pauli,
+}
+
+impl Default for LocalClifford {
+    fn default() -> Self {
+        Self::identity()
+    }
+}
+
+impl LocalClifford {
+    /// The identity.
+    pub fn identity() -> Self {
+        Self { x: Pauli::new_x(), z: Pauli::new_z() }
+    }
+
+    /// The Hadamard gate.
+    pub fn h() -> Self {
+        Self { x: Pauli::new_z(), z: Pauli::new_x() }
+    }
+
+    /// The S gate.
+    pub fn s() -> Self {
+        Self { x: Pauli::new_y(), z: Pauli::new_z() }
+    }
+
+    /// The square root of X gate.
+    pub fn sx() -> Self {
+        Self { x: Pauli::new_x(), z: Pauli::new_y() }
+    }
+
+    /// Check whether it is the identity.
+    pub fn is_identity(&self) -> bool {
+        *self == Self::identity()
+    }
+
+    /// Conjugate the `pauli` with the gate (ignoring phases).
+    pub fn conjugate(&self, pauli: Pauli) -> Pauli {
+        let mut ret = Pauli::new_i();
+        if pauli.get_x() {
+            ret.xor(self.x);
+        }
+        if pauli.get_z() {
+            ret.xor(self.z);
+        }
+        ret
+    }
+
+    /// The composition of first applying `self` and then `other`.
+    pub fn then(self, other: Self) -> Self {
+        Self {
+            x: other.conjugate(self.x),
+            z: other.conjugate(self.z),
+        }
+    }
+
+    /// The inverse gate.
+    pub fn inverse(self) -> Self {
+        // the group has six elements, so self^6 is the identity
+        let square = self.then(self);
+        square.then(square).then(self)
+    }
+
+    /// Conjugate the Paulis in the `stack` with the gate. This needs at most one xor
+    /// pass over the stack.
+    pub fn apply<B: BooleanVector>(&self, stack: &mut PauliVec<B>) {
+        self.apply_with(stack, B::xor_inplace)
+    }
+
+    /// Like [LocalClifford::apply], but with a custom `xor` implementation.
+    pub(crate) fn apply_with<B: BooleanVector>(
+        &self,
+        stack: &mut PauliVec<B>,
+        xor: impl Fn(&mut B, &B),
+    ) {
+        // new_left = x_x * left + z_x * right, new_right = x_z * left + z_z * right
+        match (self.x.get_x(), self.x.get_z(), self.z.get_x(), self.z.get_z()) {
+            (true, false, false, true) => {}
+            (false, true, true, false) => stack.h(),
+            (true, true, false, true) => xor(&mut stack.right, &stack.left),
+            (true, false, true, true) => xor(&mut stack.left, &stack.right),
+            (false, true, true, true) => {
+                xor(&mut stack.left, &stack.right);
+                stack.h();
+            }
+            (true, true, true, false) => {
+                xor(&mut stack.right, &stack.left);
+                stack.h();
+            }
+            _ => unreachable!("the images of X and Z are always independent"),
+        }
+    }
+}
+
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+pub(crate) enum DoubleGate {
+    Cx,
+    Cz,
+    Cy,
+    Swap,
+    ISwap,
+    MoveXToX,
+    MoveXToZ,
+    MoveZToX,
+    MoveZToZ,
+}
+
+impl DoubleGate {
+    pub(crate) fn name(self) -> &'static str {
+        match self {
+            DoubleGate::Cx => "cx",
+            DoubleGate::Cz => "cz",
+            DoubleGate::Cy => "cy",
+            DoubleGate::Swap => "swap",
+            DoubleGate::ISwap => "iswap",
+            DoubleGate::MoveXToX => "move_x_to_x",
+            DoubleGate::MoveXToZ => "move_x_to_z",
+            DoubleGate::MoveZToX => "move_z_to_x",
+            DoubleGate::MoveZToZ => "move_z_to_z",
+        }
+    }
+}
+
+// the indices are either qubits or slots, depending on the context
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+pub(crate) enum Instruction {
+    Single(usize, LocalClifford),
+    Double(DoubleGate, usize, usize),
+}
+
+impl From<Gate> for Instruction {
+    fn from(gate: Gate) -> Self {
+        match gate {
+            Gate::H(bit) => Instruction::Single(bit, LocalClifford::h()),
+            Gate::S(bit) => Instruction::Single(bit, LocalClifford::s()),
+            // the following single-qubit gates are equal to the ones above up to Paulis
+            // and phases, cf. the default methods of Tracker
+            Gate::Sdg(bit) => Instruction::Single(bit, LocalClifford::s()),
+            Gate::SX(bit) => Instruction::Single(bit, LocalClifford::sx()),
+            Gate::SXdg(bit) => Instruction::Single(bit, LocalClifford::sx()),
+            Gate::SY(bit) => Instruction::Single(bit, LocalClifford::h()),
+            Gate::SYdg(bit) => Instruction::Single(bit, LocalClifford::h()),
+            Gate::Cx(a, b) => Instruction::Double(DoubleGate::Cx, a, b),
+            Gate::Cz(a, b) => Instruction::Double(DoubleGate::Cz, a, b),
+            Gate::Cy(a, b) => Instruction::Double(DoubleGate::Cy, a, b),
+            Gate::Swap(a, b) => Instruction::Double(DoubleGate::Swap, a, b),
+            Gate::ISwap(a, b) => Instruction::Double(DoubleGate::ISwap, a, b),
+            Gate::ISwapdg(a, b) => Instruction::Double(DoubleGate::ISwap, a, b),
+            Gate::MoveXToX(a, b) => Instruction::Double(DoubleGate::MoveXToX, a, b),
+            Gate::MoveXToZ(a, b) => Instruction::Double(DoubleGate::MoveXToZ, a, b),
+            Gate::MoveZToX(a, b) => Instruction::Double(DoubleGate::MoveZToX, a, b),
+            Gate::MoveZToZ(a, b) => Instruction::Double(DoubleGate::MoveZToZ, a, b),
+        }
+    }
+}
+
+/// A compiled sequence of [Gate]s, cf. the [module](self) documentation.
+///
+/// # Examples
+/// ```
+/// # #[cfg_attr(coverage_nightly, no_coverage)]
+/// # fn main() {
+/// use pauli_tracker::{
+///     pauli::PauliVec,
+///     tracker::{
+///         frames::{
+///             storage::{
+///                 self,
+///                 Map,
+///             },
+///             Frames,
+///         },
+///         sequence::{
+///             Gate,
+///             GateSequence,
+///         },
+///         Tracker,
+///     },
+/// };
+/// let sequence = GateSequence::new([
+///     Gate::H(0),
+///     Gate::S(0),
+///     Gate::H(0),
+///     Gate::Cx(0, 1),
+///     Gate::S(1),
+///     Gate::S(1),
+/// ]);
+/// let mut fused = Frames::<Map<Vec<bool>>>::init(2);
+/// fused.track_z(0);
+/// fused.apply_sequence(&sequence);
+///
+/// let mut step_wise = Frames::<Map<Vec<bool>>>::init(2);
+/// step_wise.track_z(0);
+/// step_wise.h(0);
+/// step_wise.s(0);
+/// step_wise.h(0);
+/// step_wise.cx(0, 1);
+/// step_wise.s(1);
+/// step_wise.s(1);
+///
+/// assert_eq!(
+///     storage::into_sorted_by_bit(fused.into_storage()),
+///     storage::into_sorted_by_bit(step_wise.into_storage())
+/// );
+/// # }
+/// ```
+#[derive(Clone, PartialEq, Eq, Default, Debug)]
+pub struct GateSequence {
+    // slot -> qubit
+    qubits: Vec<usize>,
+    instructions: Vec<Instruction>,
+}
+
+impl GateSequence {
+    /// Compile the `gates` into a [GateSequence].
+    ///
+    /// # Panics
+    /// Panics if a two-qubit gate acts twice on the same qubit.
+    pub fn new(gates: impl IntoIterator<Item = Gate>) -> Self {
+        let mut slots = IntMap::default();
+        let mut qubits = Vec::new();
+        let mut pending: Vec<LocalClifford> = Vec::new();
+        let mut instructions = Vec::new();
+
+        let mut slot = |bit: usize, pending: &mut Vec<LocalClifford>| {
+            *slots.entry(bit).or_insert_with(|| {
+                qubits.push(bit);
+                pending.push(LocalClifford::identity());
+                qubits.len() - 1
+            })
+        };
+        fn flush(
+            slot: usize,
+            pending: &mut [LocalClifford],
+            instructions: &mut Vec<Instruction>,
+        ) {
+            let clifford = mem::take(&mut pending[slot]);
+            if !clifford.is_identity() {
+                instructions.push(Instruction::Single(slot, clifford));
+            }
+        }
+
+        for gate in gates {
+            let (double, a, b) = match Instruction::from(gate) {
+                Instruction::Single(bit, clifford) => {
+                    let slot = slot(bit, &mut pending);
+                    pending[slot] = pending[slot].then(clifford);
+                    continue;
+                }
+                Instruction::Double(double, a, b) => (double, a, b),
+            };
+            assert_ne!(a, b, "{}: the qubits must be different", double.name());
+            let (a, b) = (slot(a, &mut pending), slot(b, &mut pending));
+            flush(a, &mut pending, &mut instructions);
+            flush(b, &mut pending, &mut instructions);
+            instructions.push(Instruction::Double(double, a, b));
+        }
+        for slot in 0..pending.len() {
+            flush(slot, &mut pending, &mut instructions);
+        }
+
+        Self { qubits, instructions }
+    }
+
+    /// Get the qubits the sequence acts on, ordered by their first appearance.
+    pub fn qubits(&self) -> &[usize] {
+        &self.qubits
+    }
+
+    /// Get the number of instructions after the fusion of the single-qubit gates.
+    pub fn len(&self) -> usize {
+        self.instructions.len()
+    }
+
+    /// Check whether the sequence does nothing.
+    pub fn is_empty(&self) -> bool {
+        self.instructions.is_empty()
+    }
+
+    /// Run the sequence on the `stacks`, where `stacks[i]` is the stack of the qubit
+    /// `self.qubits()[i]`.
+    pub(crate) fn run<T: SequenceTarget>(&self, stacks: &mut [T]) {
+        for instruction in self.instructions.iter() {
+            match *instruction {
+                Instruction::Single(slot, clifford) => stacks[slot].local(clifford),
+                Instruction::Double(gate, a, b) => {
+                    // the slots are different and in bounds by construction
+                    let (a, b) = stacks.get_two_mut(a, b).expect(
+                        "bug: GateSequence::new guarantees that the slots are \
+                         different and in bounds",
+                    );
+                    T::double(gate, a, b);
+                }
+            }
+        }
+    }
+}
+
+impl FromIterator<Gate> for GateSequence {
+    fn from_iter<T: IntoIterator<Item = Gate>>(iter: T) -> Self {
+        Self::new(iter)
+    }
+}
+
+/// The per-qubit objects on which a [GateSequence] can be run.
+pub(crate) trait SequenceTarget {
+    fn local(&mut self, clifford: LocalClifford);
+    fn double(gate: DoubleGate, a: &mut Self, b: &mut Self);
+}
+
+// the following implementations should follow the gate implementations of the trackers
+// in frames.rs and live.rs; the tests below check that
+
+impl<B: BooleanVector> SequenceTarget for PauliVec<B> {
+    #[inline]
+    fn local(&mut self, clifford: LocalClifford) {
+        clifford.apply(self)
+    }
+
+    #[inline]
+    fn double(gate: DoubleGate, a: &mut Self, b: &mut Self) {
+        double_with(gate, a, b, B::xor_inplace)
+    }
+}
+
+/// Apply the two-qubit `gate` on the stacks `a` and `b`, with a custom `xor`
+/// implementation.
+pub(crate) fn double_with<B: BooleanVector>(
+    gate: DoubleGate,
+    a: &mut PauliVec<B>,
+    b: &mut PauliVec<B>,
+    xor: impl Fn(&mut B, &B),
+) {
+    match gate {
+        DoubleGate::Cx => {
+            xor(&mut b.left, &a.left);
+            xor(&mut a.right, &b.right);
+        }
+        DoubleGate::Cz => {
+            xor(&mut a.right, &b.left);
+            xor(&mut b.right, &a.left);
+        }
+        DoubleGate::Cy => {
+            xor(&mut a.right, &b.left);
+            xor(&mut a.right, &b.right);
+            xor(&mut b.left, &a.left);
+            xor(&mut b.right, &a.left);
+        }
+        DoubleGate::Swap => mem::swap(a, b),
+        DoubleGate::ISwap => {
+            // = SWAP, then S on both and CZ
+            mem::swap(a, b);
+            xor(&mut a.right, &a.left);
+            xor(&mut a.right, &b.left);
+            xor(&mut b.right, &b.left);
+            xor(&mut b.right, &a.left);
+        }
+        DoubleGate::MoveXToX => {
+            xor(&mut b.left, &a.left);
+            a.left.resize(0, false);
+        }
+        DoubleGate::MoveXToZ => {
+            xor(&mut b.right, &a.left);
+            a.left.resize(0, false);
+        }
+        DoubleGate::MoveZToX => {
+            xor(&mut b.left, &a.right);
+            a.right.resize(0, false);
+        }
+        DoubleGate::MoveZToZ => {
+            xor(&mut b.right, &a.right);
+            a.right.resize(0, false);
+        }
+    }
+}
+
+impl SequenceTarget for Pauli {
+    #[inline]
+    fn local(&mut self, clifford: LocalClifford) {
+        *self = clifford.conjugate(*self);
+    }
+
+    #[inline]
+    fn double(gate: DoubleGate, a: &mut Self, b: &mut Self) {
+        match gate {
+            DoubleGate::Cx => {
+                b.xor_u8(a.xmask());
+                a.xor_u8(b.zmask());
+            }
+            DoubleGate::Cz => {
+                a.xor_u8(b.xmask() >> 1);
+                b.xor_u8(a.xmask() >> 1);
+            }
+            DoubleGate::Cy => live::cy(a, b),
+            DoubleGate::Swap => mem::swap(a, b),
+            DoubleGate::ISwap => live::iswap(a, b),
+            DoubleGate::MoveXToX => {
+                b.xor_u8(a.xmask());
+                a.set_x(false);
+            }
+            DoubleGate::MoveXToZ => {
+                b.xor_u8(a.xmask() >> 1);
+                a.set_x(false);
+            }
+            DoubleGate::MoveZToX => {
+                b.xor_u8(a.zmask() << 1);
+                a.set_z(false);
+            }
+            DoubleGate::MoveZToZ => {
+                b.xor_u8(a.zmask());
+                a.set_z(false);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use coverage_helper::test;
+
+    use super::*;
+    use crate::{
+        boolean_vector::packed::PackedBitVec,
+        tracker::{
+            frames::{
+                storage::{
+                    self,
+                    Map,
+                    StackStorage,
+                    Vector,
+                },
+                Frames,
+            },
+            live::LiveVector,
+            Tracker,
+        },
+    };
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn apply_step_wise<T: Tracker>(tracker: &mut T, gates: &[Gate]) {
+        for gate in gates {
+            match *gate {
+                Gate::H(bit) => tracker.h(bit),
+                Gate::S(bit) => tracker.s(bit),
+                Gate::Sdg(bit) => tracker.sdg(bit),
+                Gate::SX(bit) => tracker.sx(bit),
+                Gate::SXdg(bit) => tracker.sxdg(bit),
+                Gate::SY(bit) => tracker.sy(bit),
+                Gate::SYdg(bit) => tracker.sydg(bit),
+                Gate::Cx(a, b) => tracker.cx(a, b),
+                Gate::Cz(a, b) => tracker.cz(a, b),
+                Gate::Cy(a, b) => tracker.cy(a, b),
+                Gate::Swap(a, b) => tracker.swap(a, b),
+                Gate::ISwap(a, b) => tracker.iswap(a, b),
+                Gate::ISwapdg(a, b) => tracker.iswapdg(a, b),
+                Gate::MoveXToX(a, b) => tracker.move_x_to_x(a, b),
+                Gate::MoveXToZ(a, b) => tracker.move_x_to_z(a, b),
+                Gate::MoveZToX(a, b) => tracker.move_z_to_x(a, b),
+                Gate::MoveZToZ(a, b) => tracker.move_z_to_z(a, b),
+            }
+        }
+    }
+
+    #[cfg_attr(coverage_nightly, no_coverage)]
+    fn gates(num_bits: usize, len: usize) -> Vec<Gate> {
+        let mut gates: Vec<Gate> = (0..len)
+            .map(|i| {
+                let a = (i * 7 + 3) % num_bits;
+                let b = (a + 1 + i % (num_bits - 1)) % num_bits;
+                match (i * 5) % 16 {
+                    0 | 1 => Gate::H(a),
+                    2 | 3 => Gate::S(a),
+                    4 => Gate::Sdg(a),
+                    5 => Gate::SX(a),
+                    6 => Gate::SXdg(a),
+                    7 => Gate::SY(a),
+                    8 => Gate::SYdg(a),
+                    9 | 10 => Gate::Cx(a, b),
+                    11 => Gate::Cy(a, b),
+                    12 => Gate::Swap(a, b),
+                    13 => Gate::ISwap(a, b),
+                    14 => Gate::ISwapdg(a, b),
+                    _ => Gate::Cz(a, b),
+                }
+            })
+            .collect();
+        // the movements are only allowed before the source is measured, i.e., the
+        // source must not be used afterwards
+        gates.extend([
+            Gate::MoveXToZ(0, 1),
+            Gate::MoveZToX(2, 3),
+            Gate::MoveXToX(4, 5),
+            Gate::MoveZToZ(1, 0),
+        ]);
+        gates
+    }
+
+    #[test]
+    fn local_clifford_group() {
+        let (h, s) = (LocalClifford::h(), LocalClifford::s());
+        let mut elements = vec![LocalClifford::identity()];
+        let mut i = 0;
+        while i < elements.len() {
+            for generator in [h, s] {
+                let new = elements[i].then(generator);
+                if !elements.contains(&new) {
+                    elements.push(new);
+                }
+            }
+            i += 1;
+        }
+        assert_eq!(elements.len(), 6);
+        assert!(h.then(s).then(h).then(h).then(s).then(h).is_identity());
+        assert_eq!(h.then(s).then(h), LocalClifford::sx());
+
+        for clifford in elements {
+            assert!(clifford.then(clifford.inverse()).is_identity());
+            for input in 0..4 {
+                let mut stack = PauliVec::<Vec<bool>>::new();
+                stack.push(Pauli::try_from(input).unwrap());
+                clifford.apply(&mut stack);
+                assert_eq!(
+                    stack.pop().unwrap(),
+                    clifford.conjugate(Pauli::try_from(input).unwrap())
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn fusion() {
+        let sequence =
+            GateSequence::new([Gate::S(3), Gate::H(1), Gate::S(3), Gate::H(1)]);
+        assert!(sequence.is_empty());
+        assert_eq!(sequence.qubits(), [3, 1]);
+        let sequence = GateSequence::new([
+            Gate::H(0),
+            Gate::S(0),
+            Gate::H(0),
+            Gate::S(1),
+            Gate::Cz(0, 2),
+            Gate::S(0),
+        ]);
+        assert_eq!(sequence.len(), 4);
+    }
+
+    #[test]
+    #[should_panic]
+    fn same_qubits() {
+        GateSequence::new([Gate::Cx(1, 1)]);
+    }
+
+    #[test]
+    fn compare_with_step_wise() {
+        const NUM_BITS: usize = 6;
+        let gates = gates(NUM_BITS, 200);
+        let sequence = gates.iter().copied().collect::<GateSequence>();
+
+        #[cfg_attr(coverage_nightly, no_coverage)]
+        fn init_frames<S: StackStorage>() -> Frames<S> {
+            let mut frames = Frames::<S>::init(NUM_BITS);
+            for bit in 0..NUM_BITS {
+                frames.track_x(bit);
+                frames.track_z(bit);
+            }
+            frames
+        }
+
+        let mut step_wise = init_frames::<Vector<PackedBitVec>>();
+        let mut fused = init_frames::<Vector<PackedBitVec>>();
+        apply_step_wise(&mut step_wise, &gates);
+        fused.apply_sequence(&sequence);
+        assert_eq!(fused.as_storage(), step_wise.as_storage());
+
+        let mut step_wise = init_frames::<Map<Vec<bool>>>();
+        let mut fused = init_frames::<Map<Vec<bool>>>();
+        apply_step_wise(&mut step_wise, &gates);
+        fused.apply_sequence(&sequence);
+        assert_eq!(
+            storage::into_sorted_by_bit(fused.into_storage()),
+            storage::into_sorted_by_bit(step_wise.into_storage())
+        );
+
+        for input in 0..4 {
+            let mut step_wise = LiveVector::init(NUM_BITS);
+            for bit in 0..NUM_BITS {
+                step_wise.track_pauli(bit, Pauli::try_from((input + bit as u8) % 4).unwrap());
+            }
+            let mut fused = step_wise.clone();
+            apply_step_wise(&mut step_wise, &gates);
+            fused.apply_sequence(&sequence);
+            assert_eq!(fused, step_wise);
+        }
+    }
+}
@@ -93,6 +93,12 @@ fn roundtrip(init: usize, ops: Vec<Operation>) {
         &measurements.0,
     );
     check_graph(&graph, &circuit.storage, &measurements.0).unwrap();
+    let graph = analyse::try_create_dependency_graph(
+        <Storage as StackStorage>::iter(&circuit.storage),
+        &measurements.0,
+    )
+    .unwrap();
+    check_graph(&graph, &circuit.storage, &measurements.0).unwrap();
 
     // println!("graph: {:?}", graph);
     // println!("graph.len: {}", graph.len());
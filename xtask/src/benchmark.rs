@@ -0,0 +1,121 @@
+use std::{
+    env,
+    fs,
+    path::{
+        Path,
+        PathBuf,
+    },
+    process::Command,
+};
+
+// all backends are needed, cf. the required-features of the benches in Cargo.toml
+const FEATURES: &str = "analyse,experimental,bitvec,bitvec_simd,bit-vec";
+
+pub fn run(suite: &str, criterion_args: &[String]) {
+    println!("BENCH: {}", suite.to_uppercase());
+    Command::new("cargo")
+        .args(["bench", "--features", FEATURES, "--bench", suite, "--"])
+        .args(criterion_args)
+        .spawn()
+        .expect("failed to spawn cargo command")
+        .wait()
+        .expect("failed to wait for cargo command");
+}
+
+struct Record {
+    id: String,
+    // in nanoseconds
+    mean: f64,
+    elements: Option<u64>,
+}
+
+/// Print the mean times and throughputs of the last run of each benchmark, as recorded
+/// by criterion in target/criterion.
+pub fn summary() {
+    let root = env::var_os("CARGO_TARGET_DIR")
+        .map(PathBuf::from)
+        .unwrap_or_else(|| PathBuf::from("target"))
+        .join("criterion");
+    let mut records = Vec::new();
+    collect(&root, &mut records);
+    if records.is_empty() {
+        println!("no benchmark results in {}", root.display());
+        return;
+    }
+    records.sort_by(|a, b| a.id.cmp(&b.id));
+
+    println!("SUMMARY");
+    let width = records.iter().map(|r| r.id.len()).max().unwrap_or(0);
+    for Record { id, mean, elements } in records {
+        let throughput = match elements {
+            Some(elements) => format!("{}/s", si(elements as f64 / mean * 1e9)),
+            None => String::new(),
+        };
+        println!("{id:<width$}  {:>12}  {throughput:>12}", time(mean));
+    }
+}
+
+// criterion stores the results of the last run in <benchmark>/new/
+fn collect(dir: &Path, records: &mut Vec<Record>) {
+    let Ok(entries) = fs::read_dir(dir) else { return };
+    for entry in entries.flatten() {
+        let path = entry.path();
+        if !path.is_dir() {
+            continue;
+        }
+        if path.file_name().map_or(false, |name| name == "new") {
+            if let Some(record) = read_record(&path) {
+                records.push(record);
+            }
+        } else if path.file_name().map_or(true, |name| name != "report") {
+            collect(&path, records);
+        }
+    }
+}
+
+fn read_record(dir: &Path) -> Option<Record> {
+    let benchmark = fs::read_to_string(dir.join("benchmark.json")).ok()?;
+    let estimates = fs::read_to_string(dir.join("estimates.json")).ok()?;
+    let id = string_after(&benchmark, "\"full_id\":")?;
+    let elements = number_after(&benchmark, "\"Elements\":").map(|n| n as u64);
+    let mean = &estimates[estimates.find("\"mean\":")?..];
+    let mean = number_after(mean, "\"point_estimate\":")?;
+    Some(Record { id, mean, elements })
+}
+
+// we only need a few values from criterion's json files, so we search for them instead
+// of parsing the whole files
+fn string_after(json: &str, key: &str) -> Option<String> {
+    let rest = json[json.find(key)? + key.len()..]
+        .trim_start()
+        .strip_prefix('"')?;
+    Some(rest[..rest.find('"')?].to_string())
+}
+
+fn number_after(json: &str, key: &str) -> Option<f64> {
+    let rest = json[json.find(key)? + key.len()..].trim_start();
+    let end = rest
+        .find(|c: char| {
+            !(c.is_ascii_digit() || matches!(c, '.' | 'e' | 'E' | '-' | '+'))
+        })
+        .unwrap_or(rest.len());
+    rest[..end].parse().ok()
+}
+
+fn time(nanos: f64) -> String {
+    match nanos {
+        n if n < 1e3 => format!("{n:.1} ns"),
+        n if n < 1e6 => format!("{:.2} µs", n / 1e3),
+        n if n < 1e9 => format!("{:.2} ms", n / 1e6),
+        n => format!("{:.2} s", n / 1e9),
+    }
+}
+
+fn si(value: f64) -> String {
+    match value {
+        v if v < 1e3 => format!("{v:.1}"),
+        v if v < 1e6 => format!("{:.2}K", v / 1e3),
+        v if v < 1e9 => format!("{:.2}M", v / 1e6),
+        v => format!("{:.2}G", v / 1e9),
+    }
+}
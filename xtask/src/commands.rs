@@ -1,6 +1,7 @@
 //! This module handles only the parsing of the cli input and dispatching it to the
 //! correct task. The main logic of the different "tasks" are not in this module.
 
+pub mod bench;
 pub mod ci;
 
 use clap::{
@@ -21,6 +22,7 @@ pub fn build() -> Command {
         .about(env!("CARGO_PKG_DESCRIPTION"))
         .arg_required_else_help(true)
         .subcommand(command!(ci))
+        .subcommand(command!(bench))
         .infer_subcommands(true)
 }
 
@@ -0,0 +1,86 @@
+use clap::{
+    builder::EnumValueParser,
+    Arg,
+    ArgAction,
+    ArgMatches,
+    Command,
+    ValueEnum,
+};
+
+use crate::benchmark;
+
+#[derive(Clone, Copy, ValueEnum)]
+enum Suite {
+    Tracking,
+    Analyse,
+}
+
+impl Suite {
+    fn name(self) -> &'static str {
+        match self {
+            Suite::Tracking => "tracking",
+            Suite::Analyse => "analyse",
+        }
+    }
+}
+
+#[inline]
+pub fn cli() -> Command {
+    Command::new(crate::commands::command_name(file!()))
+        .about("Run the benchmarks and summarize the results")
+        .arg(
+            Arg::new("suite")
+                .value_parser(EnumValueParser::<Suite>::new())
+                .num_args(0..)
+                .value_name("SUITE")
+                .help("Run the specified benchmark suites (default: all)"),
+        )
+        .arg(
+            Arg::new("filter")
+                .long("filter")
+                .value_name("REGEX")
+                .help("Run only the benchmarks whose id matches REGEX"),
+        )
+        .arg(
+            Arg::new("save-baseline")
+                .long("save-baseline")
+                .value_name("NAME")
+                .help("Save the results as baseline NAME"),
+        )
+        .arg(
+            Arg::new("baseline")
+                .long("baseline")
+                .value_name("NAME")
+                .conflicts_with("save-baseline")
+                .help("Compare the results against the baseline NAME"),
+        )
+        .arg(
+            Arg::new("summary")
+                .long("summary")
+                .action(ArgAction::SetTrue)
+                .help("Don't run anything, only summarize the last results"),
+        )
+}
+
+pub fn run(args: &mut ArgMatches) {
+    if !args.get_flag("summary") {
+        let suites = match args.remove_many::<Suite>("suite") {
+            Some(suites) => suites.collect(),
+            None => vec![Suite::Tracking, Suite::Analyse],
+        };
+        let mut criterion_args = Vec::new();
+        for option in ["save-baseline", "baseline"] {
+            if let Some(name) = args.remove_one::<String>(option) {
+                criterion_args.push(format!("--{option}"));
+                criterion_args.push(name);
+            }
+        }
+        if let Some(filter) = args.remove_one::<String>("filter") {
+            criterion_args.push(filter);
+        }
+        for suite in suites {
+            benchmark::run(suite.name(), &criterion_args);
+        }
+    }
+    benchmark::summary();
+}
@@ -1,2 +1,3 @@
+pub mod benchmark;
 pub mod cicd;
 pub mod commands;
@@ -16,5 +16,5 @@ macro_rules! run {
 }
 
 fn main() {
-    run!(ci);
+    run!(ci, bench);
 }